@@ -21,3 +21,57 @@ function(target_resource_file _TARGET _SRC_FILES)
                            BYPRODUCTS ${_BINDIR}/${_FILE_NAME})
     endforeach()
 endfunction()
+
+# Runs every sample under _APP_DIR headless, see RunBench.cmake. A sample is a directory whose name is also
+# its executable target, with an optional <name>-Res resource target, so new samples are picked up on their own.
+function(add_bench_target _TARGET _APP_DIR)
+    if (CMAKE_VERSION VERSION_LESS 3.19)
+        message(STATUS "${_TARGET} needs CMake 3.19 for string(JSON), target not added")
+        return()
+    endif ()
+
+    set(VKL_BENCH_WARMUP 60 CACHE STRING "Frames every sample runs before measuring")
+    set(VKL_BENCH_FRAMES 300 CACHE STRING "Frames measured per sample")
+    set(VKL_BENCH_BASELINE "" CACHE FILEPATH "results.json of an earlier bench run to compare against")
+    set(VKL_BENCH_THRESHOLD 10 CACHE STRING "Percent a metric may get worse than the baseline before it counts as a regression")
+    set(VKL_BENCH_DEVICE "" CACHE STRING "VKL_DEVICE for the samples, e.g. llvmpipe to run on lavapipe")
+    set(VKL_BENCH_ICD "" CACHE FILEPATH "VK_ICD_FILENAMES for the samples, e.g. lvp_icd.x86_64.json")
+
+    file(GLOB _SAMPLE_DIRS LIST_DIRECTORIES true "${_APP_DIR}/*")
+    set(_CONFIG "")
+    set(_SAMPLES "")
+
+    foreach(_DIR ${_SAMPLE_DIRS})
+        get_filename_component(_SAMPLE ${_DIR} NAME)
+
+        if (TARGET ${_SAMPLE})
+            get_target_property(_WORKDIR ${_SAMPLE} BINARY_DIR) # where the resources end up
+            string(APPEND _CONFIG "list(APPEND BENCH_APPS \"${_SAMPLE}\")\n")
+            string(APPEND _CONFIG "set(BENCH_EXE_${_SAMPLE} \"$<TARGET_FILE:${_SAMPLE}>\")\n")
+            string(APPEND _CONFIG "set(BENCH_WORKDIR_${_SAMPLE} \"${_WORKDIR}\")\n")
+            list(APPEND _SAMPLES ${_SAMPLE})
+
+            if (TARGET ${_SAMPLE}-Res)
+                list(APPEND _SAMPLES ${_SAMPLE}-Res)
+            endif ()
+        endif ()
+    endforeach()
+
+    # executable paths differ per configuration in multi-config generators
+    file(GENERATE OUTPUT "${CMAKE_BINARY_DIR}/bench/BenchApps-$<CONFIG>.cmake" CONTENT "${_CONFIG}")
+
+    add_custom_target(${_TARGET}
+                      COMMAND ${CMAKE_COMMAND}
+                              "-DBENCH_CONFIG=${CMAKE_BINARY_DIR}/bench/BenchApps-$<CONFIG>.cmake"
+                              "-DBENCH_OUTPUT_DIR=${CMAKE_BINARY_DIR}/bench"
+                              "-DBENCH_WARMUP=${VKL_BENCH_WARMUP}"
+                              "-DBENCH_FRAMES=${VKL_BENCH_FRAMES}"
+                              "-DBENCH_BASELINE=${VKL_BENCH_BASELINE}"
+                              "-DBENCH_THRESHOLD=${VKL_BENCH_THRESHOLD}"
+                              "-DBENCH_DEVICE=${VKL_BENCH_DEVICE}"
+                              "-DBENCH_ICD=${VKL_BENCH_ICD}"
+                              -P "${CMAKE_CURRENT_FUNCTION_LIST_DIR}/RunBench.cmake"
+                      USES_TERMINAL
+                      COMMENT "Benchmarking the samples headless")
+    add_dependencies(${_TARGET} ${_SAMPLES})
+endfunction()
@@ -0,0 +1,146 @@
+# Benchmark driver, run by the bench target (add_bench_target in Extra.cmake):
+#
+#   cmake --build <build dir> --target bench
+#
+# Every sample runs headless for BENCH_WARMUP + BENCH_FRAMES frames and writes its --bench-out JSON
+# (init time, frame time percentiles, submits, allocated memory, pipeline creation time). The results of all samples are merged
+# into <build dir>/bench/results.json, each sample's output goes to <name>.log next to it.
+#
+# With VKL_BENCH_BASELINE pointing at an earlier results.json the run is compared against it, and the
+# target fails when a sample failed or a metric got more than VKL_BENCH_THRESHOLD percent worse.
+# On CPU-only machines set VKL_BENCH_DEVICE=llvmpipe (and VKL_BENCH_ICD to the lavapipe ICD json when
+# other ICDs are installed) to run on lavapipe.
+cmake_minimum_required(VERSION 3.19)
+
+# metrics compared against the baseline, all of them are "lower is better"
+set(BENCH_COMPARED_METRICS
+    "init_ms"
+    "submits_per_frame"
+    "allocated_bytes"
+    "metrics.cpu_frame.p50"
+    "metrics.cpu_frame.p95"
+    "metrics.cpu_frame.p99"
+    "metrics.prepare_wait.p99"
+    "metrics.submit_wait.p99")
+
+# "12.3456" -> 12345, CMake math only knows integers
+function(bench_to_milli _VALUE _OUT)
+    if (NOT _VALUE MATCHES "^([0-9]+)(\\.([0-9]*))?$")
+        set(${_OUT} 0 PARENT_SCOPE)
+        return()
+    endif ()
+
+    set(_FRACTION "${CMAKE_MATCH_3}000")
+    string(SUBSTRING "${_FRACTION}" 0 3 _FRACTION)
+    math(EXPR _MILLI "${CMAKE_MATCH_1} * 1000 + 1${_FRACTION} - 1000")
+    set(${_OUT} ${_MILLI} PARENT_SCOPE)
+endfunction()
+
+include("${BENCH_CONFIG}")
+
+if (BENCH_ICD)
+    set(ENV{VK_ICD_FILENAMES} "${BENCH_ICD}")
+endif ()
+
+if (BENCH_DEVICE)
+    set(ENV{VKL_DEVICE} "${BENCH_DEVICE}")
+endif ()
+
+string(TIMESTAMP _NOW UTC)
+set(_RESULTS "{}")
+string(JSON _RESULTS SET "${_RESULTS}" "timestamp" "\"${_NOW}\"")
+string(JSON _RESULTS SET "${_RESULTS}" "warmup_frames" "${BENCH_WARMUP}")
+string(JSON _RESULTS SET "${_RESULTS}" "frames" "${BENCH_FRAMES}")
+string(JSON _RESULTS SET "${_RESULTS}" "apps" "{}")
+set(_FAILED "")
+set(_PASSED "")
+
+foreach(_APP ${BENCH_APPS})
+    set(_OUTPUT "${BENCH_OUTPUT_DIR}/${_APP}.json")
+
+    file(REMOVE "${_OUTPUT}")
+
+    execute_process(COMMAND "${BENCH_EXE_${_APP}}" --headless --warmup ${BENCH_WARMUP} --frames ${BENCH_FRAMES} --bench-out "${_OUTPUT}"
+                    WORKING_DIRECTORY "${BENCH_WORKDIR_${_APP}}"
+                    RESULT_VARIABLE _RESULT
+                    OUTPUT_VARIABLE _LOG
+                    ERROR_VARIABLE _LOG
+                    TIMEOUT 600)
+
+    file(WRITE "${BENCH_OUTPUT_DIR}/${_APP}.log" "${_LOG}")
+
+    if (NOT _RESULT EQUAL 0 OR NOT EXISTS "${_OUTPUT}")
+        message(WARNING "${_APP} failed (${_RESULT}), see ${BENCH_OUTPUT_DIR}/${_APP}.log")
+        list(APPEND _FAILED ${_APP})
+        continue()
+    endif ()
+
+    file(READ "${_OUTPUT}" _APP_RESULTS)
+    string(JSON _RESULTS SET "${_RESULTS}" "apps" "${_APP}" "${_APP_RESULTS}")
+    list(APPEND _PASSED ${_APP})
+
+    string(JSON _INIT GET "${_APP_RESULTS}" "init_ms")
+    string(JSON _P50 GET "${_APP_RESULTS}" "metrics" "cpu_frame" "p50")
+    string(JSON _P99 GET "${_APP_RESULTS}" "metrics" "cpu_frame" "p99")
+    string(JSON _SUBMITS GET "${_APP_RESULTS}" "submits_per_frame")
+    message(STATUS "${_APP}: init ${_INIT} ms, frame p50 ${_P50} ms, p99 ${_P99} ms, ${_SUBMITS} submits/frame")
+endforeach()
+
+file(WRITE "${BENCH_OUTPUT_DIR}/results.json" "${_RESULTS}\n")
+message(STATUS "Results written to ${BENCH_OUTPUT_DIR}/results.json")
+
+set(_REGRESSIONS 0)
+
+if (BENCH_BASELINE)
+    if (NOT EXISTS "${BENCH_BASELINE}")
+        message(FATAL_ERROR "Baseline ${BENCH_BASELINE} does not exist")
+    endif ()
+
+    file(READ "${BENCH_BASELINE}" _BASELINE)
+    message(STATUS "Comparing against ${BENCH_BASELINE} (threshold ${BENCH_THRESHOLD}%)")
+
+    foreach(_APP ${_PASSED})
+        string(JSON _BASE_APP ERROR_VARIABLE _ERROR GET "${_BASELINE}" "apps" "${_APP}")
+
+        if (_ERROR)
+            message(STATUS "  ${_APP}: not in the baseline")
+            continue()
+        endif ()
+
+        string(JSON _APP_RESULTS GET "${_RESULTS}" "apps" "${_APP}")
+
+        foreach(_METRIC ${BENCH_COMPARED_METRICS})
+            string(REPLACE "." ";" _METRIC_PATH "${_METRIC}")
+            string(JSON _CURRENT ERROR_VARIABLE _ERROR GET "${_APP_RESULTS}" ${_METRIC_PATH})
+            string(JSON _BASE ERROR_VARIABLE _BASE_ERROR GET "${_BASE_APP}" ${_METRIC_PATH})
+
+            if (_ERROR OR _BASE_ERROR)
+                continue()
+            endif ()
+
+            bench_to_milli("${_CURRENT}" _CURRENT_MILLI)
+            bench_to_milli("${_BASE}" _BASE_MILLI)
+
+            # tiny values (a few microseconds of wait time) are all noise, give them a floor of 0.05
+            if (_BASE_MILLI LESS 50)
+                set(_BASE_MILLI 50)
+            endif ()
+
+            math(EXPR _LIMIT "${_BASE_MILLI} * (100 + ${BENCH_THRESHOLD}) / 100")
+
+            if (_CURRENT_MILLI GREATER _LIMIT)
+                math(EXPR _PERCENT "(${_CURRENT_MILLI} - ${_BASE_MILLI}) * 100 / ${_BASE_MILLI}")
+                message(STATUS "  ${_APP} ${_METRIC}: ${_BASE} -> ${_CURRENT} (+${_PERCENT}%) REGRESSION")
+                math(EXPR _REGRESSIONS "${_REGRESSIONS} + 1")
+            endif ()
+        endforeach()
+    endforeach()
+
+    message(STATUS "${_REGRESSIONS} regression(s)")
+endif ()
+
+list(LENGTH _FAILED _FAILED_COUNT)
+
+if (_FAILED_COUNT GREATER 0 OR _REGRESSIONS GREATER 0)
+    message(FATAL_ERROR "Benchmark failed: ${_FAILED_COUNT} sample(s) failed [${_FAILED}], ${_REGRESSIONS} regression(s)")
+endif ()
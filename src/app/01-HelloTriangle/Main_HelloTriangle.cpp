@@ -1,5 +1,6 @@
 #include <framework/App.h>
 #include <framework/Resource.h>
+#include <framework/ObjectCache.h>
 
 struct MyApp : public frm::App
 {
@@ -51,10 +52,16 @@ struct MyApp : public frm::App
         renderPassInfo.pAttachments = &attachment;
         renderPassInfo.pSubpasses = &subpass;
 
-        context.createRenderPass(renderPassInfo, &renderPass);
+        renderPass = context.getObjectCache().getRenderPass(renderPassInfo);
 
         initPipeline();
 
+        initFramebuffer(context);
+        recordCmd(context);
+    }
+
+    void initFramebuffer(frm::VulkanContext& context)
+    {
         // Create framebuffer for each swapbuffer
         for (size_t i = 0; i < context.getSwapbufferCount(); i++) {
             VkFramebufferCreateInfo fbInfo{};
@@ -75,13 +82,26 @@ struct MyApp : public frm::App
             context.createFramebuffer(fbInfo, &framebuffer);
             fb.push_back(framebuffer);
         }
+    }
 
+    void destroyFramebuffer(frm::VulkanContext& context)
+    {
+        for (auto framebuffer : fb) {
+            vkDestroyFramebuffer(context.getDevice(), framebuffer, nullptr);
+        }
+
+        fb.clear();
+    }
+
+    void recordCmd(frm::VulkanContext& context)
+    {
         // record command buffer
         // since we won't render the triangle everytime, we just have to render it once to the swapchain and present it
         for (size_t i = 0; i < context.getSwapbufferCount(); i++) {
             VkCommandBufferBeginInfo cmdBegin{};
             VkRenderPassBeginInfo rpBegin{};
             VkClearValue clearValue{};
+            VkViewport viewport{};
             VkSubmitInfo submitInfo{};
 
             clearValue.color.float32[0] = 0.0f;
@@ -99,12 +119,18 @@ struct MyApp : public frm::App
 
             getClientSizeRect(rpBegin.renderArea);
 
+            viewport.width = static_cast<float>(rpBegin.renderArea.extent.width);
+            viewport.height = static_cast<float>(rpBegin.renderArea.extent.height);
+            viewport.maxDepth = 1.f;
+
             vkResetCommandBuffer(cmdBuffer, 0); // we use this command buffer twice, so we need to reset it
 
             // record command buffer
             vkBeginCommandBuffer(cmdBuffer, &cmdBegin);
             vkCmdBeginRenderPass(cmdBuffer, &rpBegin, VK_SUBPASS_CONTENTS_INLINE);
             vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
+            vkCmdSetScissor(cmdBuffer, 0, 1, &rpBegin.renderArea);
             vkCmdDraw(cmdBuffer, 3, 1, 0, 0); // draw triangle to the framebuffer
             vkCmdEndRenderPass(cmdBuffer);
             vkEndCommandBuffer(cmdBuffer);
@@ -133,8 +159,8 @@ struct MyApp : public frm::App
             throw std::runtime_error("Cannot load fragment shader");
         }
 
-        context.createShaderModule(vsBlob, &vsModule);
-        context.createShaderModule(fsBlob, &fsModule);
+        vsModule = context.getObjectCache().getShaderModule(vsBlob);
+        fsModule = context.getObjectCache().getShaderModule(fsBlob);
     }
 
     void initPipeline()
@@ -146,19 +172,17 @@ struct MyApp : public frm::App
         VkPipelineShaderStageCreateInfo shaderStages[2] = {};
         VkPipelineVertexInputStateCreateInfo vertexInput{};
         VkPipelineInputAssemblyStateCreateInfo inputAsm{};
-        VkViewport viewport{};
         VkPipelineViewportStateCreateInfo viewportState{};
+        VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+        VkPipelineDynamicStateCreateInfo dynamicState{};
         VkPipelineRasterizationStateCreateInfo rasterState{};
         VkPipelineMultisampleStateCreateInfo multisample{};
         VkPipelineColorBlendStateCreateInfo colorBlend{};
         VkPipelineColorBlendAttachmentState blendAtt{};
-        VkRect2D clientRect{};
-
-        getClientSizeRect(clientRect);
 
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 
-        context.createPipelineLayout(pipelineLayoutInfo, &pipelineLayout);
+        pipelineLayout = context.getObjectCache().getPipelineLayout(pipelineLayoutInfo);
 
         shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -175,18 +199,14 @@ struct MyApp : public frm::App
         inputAsm.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
         inputAsm.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 
-        viewport.x = 0;
-        viewport.y = 0;
-        viewport.width = static_cast<float>(clientRect.extent.width);
-        viewport.height = static_cast<float>(clientRect.extent.height);
-        viewport.minDepth = 0.f;
-        viewport.maxDepth = 1.f;
-
+        // viewport and scissor are set while recording, the pipeline doesn't depend on the swapchain size
         viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
         viewportState.scissorCount = 1;
-        viewportState.pScissors = &clientRect;
         viewportState.viewportCount = 1;
-        viewportState.pViewports = &viewport;
+
+        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamicState.dynamicStateCount = GET_ARRAY_SIZE(dynamicStates);
+        dynamicState.pDynamicStates = dynamicStates;
 
         rasterState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
         rasterState.polygonMode = VK_POLYGON_MODE_FILL;
@@ -213,6 +233,7 @@ struct MyApp : public frm::App
         pipelineInfo.pRasterizationState = &rasterState;
         pipelineInfo.pMultisampleState = &multisample;
         pipelineInfo.pColorBlendState = &colorBlend;
+        pipelineInfo.pDynamicState = &dynamicState;
         pipelineInfo.layout = pipelineLayout;
         pipelineInfo.renderPass = renderPass;
 
@@ -226,6 +247,15 @@ struct MyApp : public frm::App
 
     void onRender(frm::VulkanContext& context, double dt) override
     {
+
+    }
+
+    void onSwapchainRecreated(frm::VulkanContext& context) override
+    {
+        // the new swapbuffers are blank, render the triangle into them again
+        destroyFramebuffer(context);
+        initFramebuffer(context);
+        recordCmd(context);
     }
 
     void onDestroy(frm::VulkanContext& context) override
@@ -233,20 +263,14 @@ struct MyApp : public frm::App
         VkDevice device = context.getDevice();
 
         vkDestroyPipeline(device, pipeline, nullptr);
-        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
-        vkDestroyShaderModule(device, vsModule, nullptr);
-        vkDestroyShaderModule(device, fsModule, nullptr);
 
-        for (auto framebuffer : fb) {
-            vkDestroyFramebuffer(device, framebuffer, nullptr);
-        }
+        destroyFramebuffer(context);
 
-        vkDestroyRenderPass(device, renderPass, nullptr);
         vkDestroyCommandPool(device, pool, nullptr);
     }
 };
 
-int main()
+int main(int argc, char** argv)
 {
-    return frm::App::run<MyApp>(640, 480);
+    return frm::App::run<MyApp>(640, 480, argc, argv);
 }
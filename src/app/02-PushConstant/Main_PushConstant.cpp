@@ -1,10 +1,9 @@
 #include <framework/App.h>
 #include <framework/Resource.h>
+#include <framework/ObjectCache.h>
 
 struct PushConstantExample : public frm::App
 {
-    VkCommandPool pool;
-    VkCommandBuffer cmdBuffer;
     VkRenderPass renderPass;
     VkShaderModule vsModule;
     VkShaderModule fsModule;
@@ -28,14 +27,12 @@ struct PushConstantExample : public frm::App
 
         initResource();
 
-        context.createCommandPool(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, &pool);
-        context.createCommandBuffer(pool, &cmdBuffer);
-
         // Create render pass
         VkRenderPassCreateInfo renderPassInfo{};
         VkAttachmentDescription attachment{};
         VkAttachmentReference attRef{};
         VkSubpassDescription subpass{};
+        VkSubpassDependency dependency{};
 
         attachment.format = context.getSwapchainFormat();
         attachment.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -54,14 +51,24 @@ struct PushConstantExample : public frm::App
         subpass.colorAttachmentCount = 1;
         subpass.pColorAttachments = &attRef;
 
+        // the swapbuffer may still be read by the presentation engine, wait for the acquire semaphore
+        // (signaled at the color attachment output stage) before transitioning and writing to it
+        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependency.dstSubpass = 0;
+        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependency.srcAccessMask = 0;
+        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
         renderPassInfo.attachmentCount = 1;
-        renderPassInfo.dependencyCount = 0;
+        renderPassInfo.dependencyCount = 1;
         renderPassInfo.subpassCount = 1;
         renderPassInfo.pAttachments = &attachment;
         renderPassInfo.pSubpasses = &subpass;
+        renderPassInfo.pDependencies = &dependency;
 
-        context.createRenderPass(renderPassInfo, &renderPass);
+        renderPass = context.getObjectCache().getRenderPass(renderPassInfo);
 
         initPipeline();
         initFramebuffer();
@@ -82,8 +89,8 @@ struct PushConstantExample : public frm::App
             throw std::runtime_error("Cannot load fragment shader");
         }
 
-        context.createShaderModule(vsBlob, &vsModule);
-        context.createShaderModule(fsBlob, &fsModule);
+        vsModule = context.getObjectCache().getShaderModule(vsBlob);
+        fsModule = context.getObjectCache().getShaderModule(fsBlob);
     }
 
     void initFramebuffer()
@@ -112,6 +119,15 @@ struct PushConstantExample : public frm::App
         }
     }
 
+    void destroyFramebuffer(frm::VulkanContext& context)
+    {
+        for (auto framebuffer : fb) {
+            vkDestroyFramebuffer(context.getDevice(), framebuffer, nullptr);
+        }
+
+        fb.clear();
+    }
+
     void initPipeline()
     {
         // Create our first pipeline
@@ -122,15 +138,13 @@ struct PushConstantExample : public frm::App
         VkPipelineShaderStageCreateInfo shaderStages[2] = {};
         VkPipelineVertexInputStateCreateInfo vertexInput{};
         VkPipelineInputAssemblyStateCreateInfo inputAsm{};
-        VkViewport viewport{};
         VkPipelineViewportStateCreateInfo viewportState{};
+        VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+        VkPipelineDynamicStateCreateInfo dynamicState{};
         VkPipelineRasterizationStateCreateInfo rasterState{};
         VkPipelineMultisampleStateCreateInfo multisample{};
         VkPipelineColorBlendStateCreateInfo colorBlend{};
         VkPipelineColorBlendAttachmentState blendAtt{};
-        VkRect2D clientRect{};
-
-        getClientSizeRect(clientRect);
 
         pconstRange.offset = 0;
         pconstRange.size = sizeof(MyConstants);
@@ -140,7 +154,7 @@ struct PushConstantExample : public frm::App
         pipelineLayoutInfo.pushConstantRangeCount = 1;
         pipelineLayoutInfo.pPushConstantRanges = &pconstRange;
 
-        context.createPipelineLayout(pipelineLayoutInfo, &pipelineLayout);
+        pipelineLayout = context.getObjectCache().getPipelineLayout(pipelineLayoutInfo);
 
         shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -157,18 +171,14 @@ struct PushConstantExample : public frm::App
         inputAsm.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
         inputAsm.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 
-        viewport.x = 0;
-        viewport.y = 0;
-        viewport.width = static_cast<float>(clientRect.extent.width);
-        viewport.height = static_cast<float>(clientRect.extent.height);
-        viewport.minDepth = 0.f;
-        viewport.maxDepth = 1.f;
-
+        // viewport and scissor are set while recording, the pipeline doesn't depend on the swapchain size
         viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
         viewportState.scissorCount = 1;
-        viewportState.pScissors = &clientRect;
         viewportState.viewportCount = 1;
-        viewportState.pViewports = &viewport;
+
+        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamicState.dynamicStateCount = GET_ARRAY_SIZE(dynamicStates);
+        dynamicState.pDynamicStates = dynamicStates;
 
         rasterState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
         rasterState.polygonMode = VK_POLYGON_MODE_FILL;
@@ -195,6 +205,7 @@ struct PushConstantExample : public frm::App
         pipelineInfo.pRasterizationState = &rasterState;
         pipelineInfo.pMultisampleState = &multisample;
         pipelineInfo.pColorBlendState = &colorBlend;
+        pipelineInfo.pDynamicState = &dynamicState;
         pipelineInfo.layout = pipelineLayout;
         pipelineInfo.renderPass = renderPass;
 
@@ -220,9 +231,11 @@ struct PushConstantExample : public frm::App
 
     void onRender(frm::VulkanContext& context, double dt) override
     {
+        VkCommandBuffer cmdBuffer = context.getFrameCommandBuffer(); // reset by the context once this frame slot is free again
         VkCommandBufferBeginInfo cmdBegin{};
         VkRenderPassBeginInfo rpBegin{};
         VkClearValue clearValue{};
+        VkViewport viewport{};
         VkSubmitInfo submitInfo{};
 
         clearValue.color.float32[0] = 0.0f;
@@ -231,6 +244,7 @@ struct PushConstantExample : public frm::App
         clearValue.color.float32[3] = 0.0f;
 
         cmdBegin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        cmdBegin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
         rpBegin.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
         rpBegin.renderPass = renderPass;
@@ -240,12 +254,16 @@ struct PushConstantExample : public frm::App
 
         getClientSizeRect(rpBegin.renderArea);
 
-        vkResetCommandBuffer(cmdBuffer, 0); // we use this command buffer twice, so we need to reset it
+        viewport.width = static_cast<float>(rpBegin.renderArea.extent.width);
+        viewport.height = static_cast<float>(rpBegin.renderArea.extent.height);
+        viewport.maxDepth = 1.f;
 
         // record command buffer
         vkBeginCommandBuffer(cmdBuffer, &cmdBegin);
         vkCmdBeginRenderPass(cmdBuffer, &rpBegin, VK_SUBPASS_CONTENTS_INLINE);
         vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(cmdBuffer, 0, 1, &rpBegin.renderArea);
         vkCmdPushConstants(cmdBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(MyConstants), &constants);
         vkCmdDraw(cmdBuffer, 3, 1, 0, 0); // draw triangle to the framebuffer
         vkCmdEndRenderPass(cmdBuffer);
@@ -255,8 +273,15 @@ struct PushConstantExample : public frm::App
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &cmdBuffer;
 
-        // execute the command buffer synchronously
-        context.queueSubmit(submitInfo);
+        // execute the command buffer, this doesn't wait for the GPU to finish
+        context.submitFrame(submitInfo);
+    }
+
+    void onSwapchainRecreated(frm::VulkanContext& context) override
+    {
+        // the pipeline uses dynamic viewport/scissor, only the framebuffers depend on the swapchain
+        destroyFramebuffer(context);
+        initFramebuffer();
     }
 
     void onDestroy(frm::VulkanContext& context) override
@@ -264,20 +289,12 @@ struct PushConstantExample : public frm::App
         VkDevice device = context.getDevice();
 
         vkDestroyPipeline(device, pipeline, nullptr);
-        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
-        vkDestroyShaderModule(device, vsModule, nullptr);
-        vkDestroyShaderModule(device, fsModule, nullptr);
-
-        for (auto framebuffer : fb) {
-            vkDestroyFramebuffer(device, framebuffer, nullptr);
-        }
 
-        vkDestroyRenderPass(device, renderPass, nullptr);
-        vkDestroyCommandPool(device, pool, nullptr);
+        destroyFramebuffer(context);
     }
 };
 
-int main()
+int main(int argc, char** argv)
 {
-    return frm::App::run<PushConstantExample>(640, 480);
+    return frm::App::run<PushConstantExample>(640, 480, argc, argv);
 }
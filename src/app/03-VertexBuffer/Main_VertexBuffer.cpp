@@ -1,5 +1,6 @@
 #include <framework/App.h>
 #include <framework/Resource.h>
+#include <framework/ObjectCache.h>
 #include <framework/GPUResource.h>
 #include <framework/ShapeGen.h>
 
@@ -19,7 +20,8 @@ struct VertexBufferExample : public frm::App
     void onInit(frm::VulkanContext& context) override
     {
         context.createCommandPool(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, &cmdPool);
-        
+        context.createCommandBuffer(cmdPool, &renderCmd);
+
         initBuffer(context);
         initRenderPass(context);
         initFramebuffer(context);
@@ -112,7 +114,7 @@ struct VertexBufferExample : public frm::App
         renderPassInfo.pAttachments = &attachment;
         renderPassInfo.pSubpasses = &subpass;
 
-        context.createRenderPass(renderPassInfo, &renderPass);
+        renderPass = context.getObjectCache().getRenderPass(renderPassInfo);
     }
 
     void initFramebuffer(frm::VulkanContext& context)
@@ -139,6 +141,15 @@ struct VertexBufferExample : public frm::App
         }
     }
 
+    void destroyFramebuffer(frm::VulkanContext& context)
+    {
+        for (auto framebuffer : fb) {
+            vkDestroyFramebuffer(context.getDevice(), framebuffer, nullptr);
+        }
+
+        fb.clear();
+    }
+
     void loadResources(frm::VulkanContext& context)
     {
         // Initialize resources
@@ -153,8 +164,8 @@ struct VertexBufferExample : public frm::App
             throw std::runtime_error("Cannot load fragment shader");
         }
 
-        context.createShaderModule(vsBlob, &vsModule);
-        context.createShaderModule(fsBlob, &fsModule);
+        vsModule = context.getObjectCache().getShaderModule(vsBlob);
+        fsModule = context.getObjectCache().getShaderModule(fsBlob);
     }
 
     void initPipeline(frm::VulkanContext& context)
@@ -166,19 +177,17 @@ struct VertexBufferExample : public frm::App
         VkVertexInputAttributeDescription inputAttribs[2] = {};
         VkPipelineVertexInputStateCreateInfo vertexInput{};
         VkPipelineInputAssemblyStateCreateInfo inputAsm{};
-        VkViewport viewport{};
         VkPipelineViewportStateCreateInfo viewportState{};
+        VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+        VkPipelineDynamicStateCreateInfo dynamicState{};
         VkPipelineRasterizationStateCreateInfo rasterState{};
         VkPipelineMultisampleStateCreateInfo multisample{};
         VkPipelineColorBlendStateCreateInfo colorBlend{};
         VkPipelineColorBlendAttachmentState blendAtt{};
-        VkRect2D clientRect{};
-
-        getClientSizeRect(clientRect);
 
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 
-        context.createPipelineLayout(pipelineLayoutInfo, &pipelineLayout);
+        pipelineLayout = context.getObjectCache().getPipelineLayout(pipelineLayoutInfo);
 
         shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -212,18 +221,14 @@ struct VertexBufferExample : public frm::App
         inputAsm.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
         inputAsm.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 
-        viewport.x = 0;
-        viewport.y = 0;
-        viewport.width = static_cast<float>(clientRect.extent.width);
-        viewport.height = static_cast<float>(clientRect.extent.height);
-        viewport.minDepth = 0.f;
-        viewport.maxDepth = 1.f;
-
+        // viewport and scissor are set while recording, the pipeline doesn't depend on the swapchain size
         viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
         viewportState.scissorCount = 1;
-        viewportState.pScissors = &clientRect;
         viewportState.viewportCount = 1;
-        viewportState.pViewports = &viewport;
+
+        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamicState.dynamicStateCount = GET_ARRAY_SIZE(dynamicStates);
+        dynamicState.pDynamicStates = dynamicStates;
 
         rasterState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
         rasterState.polygonMode = VK_POLYGON_MODE_FILL;
@@ -250,6 +255,7 @@ struct VertexBufferExample : public frm::App
         pipelineInfo.pRasterizationState = &rasterState;
         pipelineInfo.pMultisampleState = &multisample;
         pipelineInfo.pColorBlendState = &colorBlend;
+        pipelineInfo.pDynamicState = &dynamicState;
         pipelineInfo.layout = pipelineLayout;
         pipelineInfo.renderPass = renderPass;
 
@@ -261,12 +267,11 @@ struct VertexBufferExample : public frm::App
         VkBuffer vbuf = vertexBuffer->get();
         VkDeviceSize ofs = 0;
 
-        context.createCommandBuffer(cmdPool, &renderCmd);
-
         for (uint32_t i = 0; i < context.getSwapbufferCount(); i++) {
             VkCommandBufferBeginInfo cmdBegin{};
             VkRenderPassBeginInfo rpBegin{};
             VkClearValue clearValue{};
+            VkViewport viewport{};
             VkSubmitInfo submitInfo{};
 
             clearValue.color.float32[0] = 0.0f;
@@ -284,6 +289,10 @@ struct VertexBufferExample : public frm::App
 
             getClientSizeRect(rpBegin.renderArea);
 
+            viewport.width = static_cast<float>(rpBegin.renderArea.extent.width);
+            viewport.height = static_cast<float>(rpBegin.renderArea.extent.height);
+            viewport.maxDepth = 1.f;
+
             VkCommandBufferBeginInfo beginInfo{};
             beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
@@ -291,6 +300,8 @@ struct VertexBufferExample : public frm::App
             vkBeginCommandBuffer(renderCmd, &beginInfo);
             vkCmdBeginRenderPass(renderCmd, &rpBegin, VK_SUBPASS_CONTENTS_INLINE);
             vkCmdBindPipeline(renderCmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            vkCmdSetViewport(renderCmd, 0, 1, &viewport);
+            vkCmdSetScissor(renderCmd, 0, 1, &rpBegin.renderArea);
             vkCmdBindVertexBuffers(renderCmd, 0, 1, &vbuf, &ofs); // bind our vertex buffer
             vkCmdDraw(renderCmd, 3, 1, 0, 0); // draw triangle to the framebuffer
             vkCmdEndRenderPass(renderCmd);
@@ -316,25 +327,27 @@ struct VertexBufferExample : public frm::App
         
     }
 
+    void onSwapchainRecreated(frm::VulkanContext& context) override
+    {
+        // the new swapbuffers are blank, render into them again
+        destroyFramebuffer(context);
+        initFramebuffer(context);
+        recordCmd(context);
+    }
+
     void onDestroy(frm::VulkanContext& context) override
     {
         VkDevice device = context.getDevice();
 
         vkDestroyPipeline(device, pipeline, nullptr);
-        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
-        vkDestroyShaderModule(device, vsModule, nullptr);
-        vkDestroyShaderModule(device, fsModule, nullptr);
 
-        for (auto framebuffer : fb) {
-            vkDestroyFramebuffer(device, framebuffer, nullptr);
-        }
+        destroyFramebuffer(context);
 
-        vkDestroyRenderPass(device, renderPass, nullptr);
         vkDestroyCommandPool(device, cmdPool, nullptr);
     }
 };
 
-int main()
+int main(int argc, char** argv)
 {
-    return frm::App::run<VertexBufferExample>(640, 480);
+    return frm::App::run<VertexBufferExample>(640, 480, argc, argv);
 }
@@ -1,5 +1,6 @@
 #include <framework/App.h>
 #include <framework/Resource.h>
+#include <framework/ObjectCache.h>
 #include <framework/GPUResource.h>
 #include <framework/ShapeGen.h>
 
@@ -9,7 +10,8 @@ struct TransformExample : public frm::App
     frm::BufferResourceRef vertexBuffer;
     frm::BufferResourceRef indexBuffer;
     VkCommandPool cmdPool;
-    VkCommandBuffer renderCmd;
+    std::vector<VkCommandBuffer> uploadCmds;
+    frm::SubmitTicket bufferUpload; // signaled once the vertex & index data are on the GPU
     VkRenderPass renderPass;
     std::vector<VkFramebuffer> fb;
     VkShaderModule vsModule;
@@ -37,7 +39,7 @@ struct TransformExample : public frm::App
         initFramebuffer(context);
         loadResources(context);
         initPipeline(context);
-        recordCmd(context);
+        finishUploads(context);
     }
 
     void initTransformation()
@@ -55,74 +57,68 @@ struct TransformExample : public frm::App
         uint32_t* indices = nullptr;
         size_t numVertices;
         size_t numIndices;
+        VkDeviceSize vertexSize;
+        VkDeviceSize indexSize;
         VkBufferCreateInfo bufferInfo{};
         VkCommandBuffer copyCmd;
 
         numVertices = frm::ShapeGen::makeColorPlane(0.5f, indices, vertices, numIndices); // make a flat plane
+        vertexSize = sizeof(frm::VertexPosCol) * numVertices;
+        indexSize = sizeof(uint32_t) * numIndices;
 
         // create a temporary command buffer to copy buffer
         context.createCommandBuffer(cmdPool, &copyCmd);
 
-        // create staging buffer
+        // create staging buffer, big enough to hold both vertex and index data so both copies can be in flight at once
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        bufferInfo.size = sizeof(frm::VertexPosCol) * numVertices;
+        bufferInfo.size = vertexSize + indexSize;
         bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 
         context.createBuffer(bufferInfo, VMA_MEMORY_USAGE_CPU_ONLY, stagingBuffer);
 
-        // create vertex buffer with the same size as the staging buffer
+        // create vertex buffer
         bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bufferInfo.size = vertexSize;
         context.createBuffer(bufferInfo, VMA_MEMORY_USAGE_GPU_ONLY, vertexBuffer);
 
         // create index buffer
         bufferInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-        bufferInfo.size = sizeof(uint32_t) * numIndices;
+        bufferInfo.size = indexSize;
         context.createBuffer(bufferInfo, VMA_MEMORY_USAGE_GPU_ONLY, indexBuffer);
 
-        // copy vertex data to staging buffer
-        frm::VertexPosCol* mapped = nullptr;
+        // copy vertex data followed by index data to staging buffer
+        uint8_t* mapped = nullptr;
         stagingBuffer->map(&mapped);
-        std::memcpy(mapped, vertices, sizeof(frm::VertexPosCol) * numVertices);
+        std::memcpy(mapped, vertices, vertexSize);
+        std::memcpy(mapped + vertexSize, indices, indexSize);
         stagingBuffer->unmap();
 
-        // copy vertex data which currently inside the staging buffer to the vertex buffer
+        // copy both regions from the staging buffer to the vertex and index buffer
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-        VkBufferCopy region{};
-        region.size = sizeof(frm::VertexPosCol) * numVertices;
+        VkBufferCopy vertexRegion{};
+        vertexRegion.srcOffset = 0;
+        vertexRegion.size = vertexSize;
+
+        VkBufferCopy indexRegion{};
+        indexRegion.srcOffset = vertexSize;
+        indexRegion.size = indexSize;
 
         vkBeginCommandBuffer(copyCmd, &beginInfo);
-        vkCmdCopyBuffer(copyCmd, stagingBuffer->get(), vertexBuffer->get(), 1, &region);
+        vkCmdCopyBuffer(copyCmd, stagingBuffer->get(), vertexBuffer->get(), 1, &vertexRegion);
+        vkCmdCopyBuffer(copyCmd, stagingBuffer->get(), indexBuffer->get(), 1, &indexRegion);
         vkEndCommandBuffer(copyCmd);
 
-        // submit our copy command to GPU!!
+        // submit our copy command to GPU!! we don't wait here, only when the buffers are actually needed
         VkSubmitInfo submit{};
         submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
         submit.commandBufferCount = 1;
         submit.pCommandBuffers = &copyCmd;
 
-        context.queueSubmit(submit);
-
-        // Now do the same thing with index data
-
-        // copy index data to staging buffer
-        uint32_t* mappedIndices;
-        stagingBuffer->map(&mappedIndices);
-        std::memcpy(mappedIndices, indices, sizeof(uint32_t) * numIndices);
-        stagingBuffer->unmap();
-
-        // copy index data which currently inside the staging buffer to the vertex buffer
-        region.size = sizeof(uint32_t) * numIndices;
-
-        vkResetCommandBuffer(copyCmd, 0);
-        vkBeginCommandBuffer(copyCmd, &beginInfo);
-        vkCmdCopyBuffer(copyCmd, stagingBuffer->get(), indexBuffer->get(), 1, &region);
-        vkEndCommandBuffer(copyCmd);
-
-        context.queueSubmit(submit);
-
-        vkFreeCommandBuffers(context.getDevice(), cmdPool, 1, &copyCmd);
+        bufferUpload = context.queueSubmitAsync(submit);
+        uploadCmds.push_back(copyCmd);
 
         delete indices;
         delete vertices;
@@ -134,6 +130,7 @@ struct TransformExample : public frm::App
         VkAttachmentDescription attachment{};
         VkAttachmentReference attRef{};
         VkSubpassDescription subpass{};
+        VkSubpassDependency dependency{};
 
         attachment.format = context.getSwapchainFormat();
         attachment.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -152,14 +149,24 @@ struct TransformExample : public frm::App
         subpass.colorAttachmentCount = 1;
         subpass.pColorAttachments = &attRef;
 
+        // the swapbuffer may still be read by the presentation engine, wait for the acquire semaphore
+        // (signaled at the color attachment output stage) before transitioning and writing to it
+        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependency.dstSubpass = 0;
+        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependency.srcAccessMask = 0;
+        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
         renderPassInfo.attachmentCount = 1;
-        renderPassInfo.dependencyCount = 0;
+        renderPassInfo.dependencyCount = 1;
         renderPassInfo.subpassCount = 1;
         renderPassInfo.pAttachments = &attachment;
         renderPassInfo.pSubpasses = &subpass;
+        renderPassInfo.pDependencies = &dependency;
 
-        context.createRenderPass(renderPassInfo, &renderPass);
+        renderPass = context.getObjectCache().getRenderPass(renderPassInfo);
     }
 
     void initFramebuffer(frm::VulkanContext& context)
@@ -183,6 +190,15 @@ struct TransformExample : public frm::App
         }
     }
 
+    void destroyFramebuffer(frm::VulkanContext& context)
+    {
+        for (auto framebuffer : fb) {
+            vkDestroyFramebuffer(context.getDevice(), framebuffer, nullptr);
+        }
+
+        fb.clear();
+    }
+
     void loadResources(frm::VulkanContext& context)
     {
         // Initialize resources
@@ -197,8 +213,8 @@ struct TransformExample : public frm::App
             throw std::runtime_error("Cannot load fragment shader");
         }
 
-        context.createShaderModule(vsBlob, &vsModule);
-        context.createShaderModule(fsBlob, &fsModule);
+        vsModule = context.getObjectCache().getShaderModule(vsBlob);
+        fsModule = context.getObjectCache().getShaderModule(fsBlob);
     }
 
     void initPipeline(frm::VulkanContext& context)
@@ -211,8 +227,9 @@ struct TransformExample : public frm::App
         VkVertexInputAttributeDescription inputAttribs[2] = {};
         VkPipelineVertexInputStateCreateInfo vertexInput{};
         VkPipelineInputAssemblyStateCreateInfo inputAsm{};
-        VkViewport viewport{};
         VkPipelineViewportStateCreateInfo viewportState{};
+        VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+        VkPipelineDynamicStateCreateInfo dynamicState{};
         VkPipelineRasterizationStateCreateInfo rasterState{};
         VkPipelineMultisampleStateCreateInfo multisample{};
         VkPipelineColorBlendStateCreateInfo colorBlend{};
@@ -226,7 +243,7 @@ struct TransformExample : public frm::App
         pipelineLayoutInfo.pushConstantRangeCount = 1;
         pipelineLayoutInfo.pPushConstantRanges = &pconstRange;
 
-        context.createPipelineLayout(pipelineLayoutInfo, &pipelineLayout);
+        pipelineLayout = context.getObjectCache().getPipelineLayout(pipelineLayoutInfo);
 
         shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -260,18 +277,14 @@ struct TransformExample : public frm::App
         inputAsm.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
         inputAsm.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 
-        viewport.x = 0;
-        viewport.y = 0;
-        viewport.width = static_cast<float>(viewRect.extent.width);
-        viewport.height = static_cast<float>(viewRect.extent.height);
-        viewport.minDepth = 0.f;
-        viewport.maxDepth = 1.f;
-
+        // viewport and scissor are set while recording, the pipeline doesn't depend on the swapchain size
         viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
         viewportState.scissorCount = 1;
-        viewportState.pScissors = &viewRect;
         viewportState.viewportCount = 1;
-        viewportState.pViewports = &viewport;
+
+        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamicState.dynamicStateCount = GET_ARRAY_SIZE(dynamicStates);
+        dynamicState.pDynamicStates = dynamicStates;
 
         rasterState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
         rasterState.polygonMode = VK_POLYGON_MODE_FILL;
@@ -298,15 +311,21 @@ struct TransformExample : public frm::App
         pipelineInfo.pRasterizationState = &rasterState;
         pipelineInfo.pMultisampleState = &multisample;
         pipelineInfo.pColorBlendState = &colorBlend;
+        pipelineInfo.pDynamicState = &dynamicState;
         pipelineInfo.layout = pipelineLayout;
         pipelineInfo.renderPass = renderPass;
 
         context.createGraphicsPipeline(pipelineInfo, &pipeline);
     }
 
-    void recordCmd(frm::VulkanContext& context)
+    void finishUploads(frm::VulkanContext& context)
     {
-        context.createCommandBuffer(cmdPool, &renderCmd);
+        // the buffers are needed from the first frame on, so this is the latest point we can wait for them
+        context.wait(bufferUpload);
+
+        vkFreeCommandBuffers(context.getDevice(), cmdPool, static_cast<uint32_t>(uploadCmds.size()), uploadCmds.data());
+        uploadCmds.clear();
+        stagingBuffer.reset();
     }
 
     void onUpdate(frm::VulkanContext& context, double dt) override
@@ -320,11 +339,13 @@ struct TransformExample : public frm::App
 
     void onRender(frm::VulkanContext& context, double dt) override
     {
+        VkCommandBuffer renderCmd = context.getFrameCommandBuffer(); // reset by the context once this frame slot is free again
         VkBuffer buf = vertexBuffer->get();
         VkDeviceSize ofs = 0;
         VkCommandBufferBeginInfo cmdBegin{};
         VkRenderPassBeginInfo rpBegin{};
         VkClearValue clearValue{};
+        VkViewport viewport{};
         VkSubmitInfo submitInfo{};
 
         clearValue.color.float32[0] = 0.0f;
@@ -344,13 +365,19 @@ struct TransformExample : public frm::App
         rpBegin.renderArea.extent.width = viewRect.extent.width;
         rpBegin.renderArea.extent.height = viewRect.extent.height;
 
+        viewport.width = static_cast<float>(rpBegin.renderArea.extent.width);
+        viewport.height = static_cast<float>(rpBegin.renderArea.extent.height);
+        viewport.maxDepth = 1.f;
+
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-        vkResetCommandBuffer(renderCmd, 0);
         vkBeginCommandBuffer(renderCmd, &beginInfo);
         vkCmdBeginRenderPass(renderCmd, &rpBegin, VK_SUBPASS_CONTENTS_INLINE);
         vkCmdBindPipeline(renderCmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        vkCmdSetViewport(renderCmd, 0, 1, &viewport);
+        vkCmdSetScissor(renderCmd, 0, 1, &rpBegin.renderArea);
         vkCmdBindVertexBuffers(renderCmd, 0, 1, &buf, &ofs); // bind vertex buffer
         vkCmdBindIndexBuffer(renderCmd, indexBuffer->get(), 0, VK_INDEX_TYPE_UINT32); // bind index buffer
         vkCmdPushConstants(renderCmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(MyConstants), &constants); // set push constant values
@@ -364,7 +391,15 @@ struct TransformExample : public frm::App
         submit.commandBufferCount = 1;
         submit.pCommandBuffers = &renderCmd;
 
-        context.queueSubmit(submit);
+        context.submitFrame(submit); // doesn't block, the next frame can be recorded while this one is rendered
+    }
+
+    void onSwapchainRecreated(frm::VulkanContext& context) override
+    {
+        // the pipeline uses dynamic viewport/scissor, only the framebuffers depend on the swapchain
+        destroyFramebuffer(context);
+        initTransformation();
+        initFramebuffer(context);
     }
 
     void onDestroy(frm::VulkanContext& context) override
@@ -372,20 +407,14 @@ struct TransformExample : public frm::App
         VkDevice device = context.getDevice();
 
         vkDestroyPipeline(device, pipeline, nullptr);
-        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
-        vkDestroyShaderModule(device, vsModule, nullptr);
-        vkDestroyShaderModule(device, fsModule, nullptr);
 
-        for (auto framebuffer : fb) {
-            vkDestroyFramebuffer(device, framebuffer, nullptr);
-        }
+        destroyFramebuffer(context);
 
-        vkDestroyRenderPass(device, renderPass, nullptr);
         vkDestroyCommandPool(device, cmdPool, nullptr);
     }
 };
 
-int main()
+int main(int argc, char** argv)
 {
-    return frm::App::run<TransformExample>(640, 480);
+    return frm::App::run<TransformExample>(640, 480, argc, argv);
 }
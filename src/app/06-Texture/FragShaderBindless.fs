@@ -0,0 +1,21 @@
+#version 460
+#extension GL_EXT_nonuniform_qualifier : require
+
+// the context's bindless table, see frm::BindlessTable
+layout(set = 0, binding = 0) uniform texture2D textures[];
+layout(set = 0, binding = 1) uniform sampler samplers[];
+
+layout(push_constant) uniform pushConstant
+{
+    layout(offset = 64) uint textureIndex; // after the vertex shader's matrix
+    uint samplerIndex;
+};
+
+layout(location = 0) in vec2 uv;
+layout(location = 0) out vec4 o_color;
+
+void main()
+{
+    vec3 c = texture(sampler2D(textures[textureIndex], samplers[samplerIndex]), uv).rgb;
+    o_color = vec4(c, 1.0);
+}
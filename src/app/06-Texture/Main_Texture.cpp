@@ -1,21 +1,24 @@
 #include <framework/App.h>
 #include <framework/Resource.h>
+#include <framework/ObjectCache.h>
+#include <framework/DescriptorAllocator.h>
 #include <framework/GPUResource.h>
 #include <framework/ShapeGen.h>
+#include <framework/Uploader.h>
+#include <framework/CommandList.h>
+#include <framework/BindlessTable.h>
 
 struct TextureExample : public frm::App
 {
     frm::ImageResourceRef image; // ImageResourceRef & BufferResourceRef are wrapper for VkImage and VkBuffer, object deletion is done automatically :)
     frm::BufferResourceRef vertexBuffer; 
     frm::BufferResourceRef indexBuffer;
-    VkCommandPool cmdPool;
-    VkCommandBuffer renderCmd;
+    frm::SubmitTicket upload; // signaled once the texture, vertex & index data are usable on the graphics queue
     VkRenderPass renderPass;
     std::vector<VkFramebuffer> fb;
     VkShaderModule vsModule;
     VkShaderModule fsModule;
     VkDescriptorSetLayout descSetLayout;
-    VkDescriptorPool descriptorPool;
     VkDescriptorSet descSet;
     VkPipelineLayout pipelineLayout;
     VkPipeline pipeline;
@@ -24,18 +27,27 @@ struct TextureExample : public frm::App
     VkRect2D viewRect;
     float aspect = 0.f;
     float time = 0.f;
+    bool bindless = false; // the texture is read through the context's bindless table instead of descSet
 
     struct MyConstants
     {
         glm::mat4 wvpMatrix{};
     };
 
+    // bindless only, where the fragment shader finds the texture and sampler
+    struct BindlessIndices
+    {
+        uint32_t textureIndex;
+        uint32_t samplerIndex;
+    };
+
     MyConstants constants;
+    BindlessIndices bindlessIndices{};
 
     void onInit(frm::VulkanContext& context) override
     {
-        context.createCommandPool(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, &cmdPool);
-        
+        bindless = context.getFeatures().descriptorIndexing;
+
         initTexture(context);
         initSampler(context);
         initTransformation();
@@ -45,33 +57,18 @@ struct TextureExample : public frm::App
         loadResources(context);
         initPipeline(context);
         initDescriptor(context);
-        recordCmd(context);
+        finishUploads(context);
     }
 
     void initTexture(frm::VulkanContext& context)
     {
-        frm::BufferResourceRef stagingBuffer;
         frm::ImageData imageData;
-        VkCommandBuffer copyCmd;
-        VkBufferCreateInfo stagingBufInfo{};
         VkImageCreateInfo imageInfo{};
         VkImageViewCreateInfo imageViewInfo{};
 
         if (!frm::Resource::loadImage("shaderboi_fish.png", imageData, 4)) {
             throw std::runtime_error("Cannot load image");
         }
-        
-        // Create a staging buffer as a texture transfer source
-        stagingBufInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        stagingBufInfo.size = imageData.data.size();
-        stagingBufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-
-        context.createBuffer(stagingBufInfo, VMA_MEMORY_USAGE_CPU_ONLY, stagingBuffer);
-
-        uint8_t* pixelData = nullptr;
-        stagingBuffer->map(&pixelData);
-        std::memcpy(pixelData, imageData.data.data(), imageData.data.size()); // copy image data to staging buffer
-        stagingBuffer->unmap();
 
         // Create actual image on the GPU
         imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -87,7 +84,8 @@ struct TextureExample : public frm::App
         imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
         imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-        context.createImage(imageInfo, VMA_MEMORY_USAGE_GPU_ONLY, image);
+        // with bindless the context also puts a view of it in the bindless table
+        context.createImage(imageInfo, VMA_MEMORY_USAGE_GPU_ONLY, image, bindless);
 
         imageViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
         imageViewInfo.image = image->get();
@@ -102,90 +100,16 @@ struct TextureExample : public frm::App
 
         context.createImageView(imageViewInfo, &imageView);
 
-        // create copy command
-        context.createCommandBuffer(cmdPool, &copyCmd);
-
-        VkImageMemoryBarrier imageTransferBarrier{};
-        imageTransferBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        imageTransferBarrier.srcAccessMask = 0;
-        imageTransferBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        imageTransferBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        imageTransferBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        imageTransferBarrier.srcQueueFamilyIndex = context.getQueueIndex();
-        imageTransferBarrier.dstQueueFamilyIndex = context.getQueueIndex();
-        imageTransferBarrier.image = image->get();
-        imageTransferBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        imageTransferBarrier.subresourceRange.baseMipLevel = 0;
-        imageTransferBarrier.subresourceRange.levelCount = 1;
-        imageTransferBarrier.subresourceRange.baseArrayLayer = 0;
-        imageTransferBarrier.subresourceRange.layerCount = 1;
-
-        VkImageMemoryBarrier imageFragReadBarrier{};
-        imageFragReadBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        imageFragReadBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        imageFragReadBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-        imageFragReadBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        imageFragReadBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageFragReadBarrier.srcQueueFamilyIndex = context.getQueueIndex();
-        imageFragReadBarrier.dstQueueFamilyIndex = context.getQueueIndex();
-        imageFragReadBarrier.image = image->get();
-        imageFragReadBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        imageFragReadBarrier.subresourceRange.baseMipLevel = 0;
-        imageFragReadBarrier.subresourceRange.levelCount = 1;
-        imageFragReadBarrier.subresourceRange.baseArrayLayer = 0;
-        imageFragReadBarrier.subresourceRange.layerCount = 1;
-
-        VkCommandBufferBeginInfo beginInfo{};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-        VkBufferImageCopy imageCopy{};
-        imageCopy.bufferOffset = 0;
-        imageCopy.bufferRowLength = imageData.width;
-        imageCopy.bufferImageHeight = imageData.height;
-        imageCopy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        imageCopy.imageSubresource.mipLevel = 0;
-        imageCopy.imageSubresource.baseArrayLayer = 0;
-        imageCopy.imageSubresource.layerCount = 1;
-        imageCopy.imageOffset.x = 0;
-        imageCopy.imageOffset.y = 0;
-        imageCopy.imageOffset.z = 0;
-        imageCopy.imageExtent.width = imageData.width;
-        imageCopy.imageExtent.height = imageData.height;
-        imageCopy.imageExtent.depth = 1;
-
-        vkBeginCommandBuffer(copyCmd, &beginInfo);
-        vkCmdPipelineBarrier(copyCmd,
-            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-            VK_PIPELINE_STAGE_TRANSFER_BIT,
-            0,
-            0,
-            nullptr,
-            0,
-            nullptr,
-            1,
-            &imageTransferBarrier);
-        vkCmdCopyBufferToImage(copyCmd, stagingBuffer->get(), image->get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageCopy);
-        vkCmdPipelineBarrier(copyCmd,
-            VK_PIPELINE_STAGE_TRANSFER_BIT,
-            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-            0,
-            0,
-            nullptr,
-            0,
-            nullptr,
-            1,
-            &imageFragReadBarrier);
-        vkEndCommandBuffer(copyCmd);
-
-        VkSubmitInfo submit{};
-        submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submit.commandBufferCount = 1;
-        submit.pCommandBuffers = &copyCmd;
-
-        context.queueSubmit(submit);
-
-        vkFreeCommandBuffers(context.getDevice(), cmdPool, 1, &copyCmd);
+        // Queue the pixels for upload. The uploader copies them through a staging buffer on the transfer queue
+        // and transitions the image to SHADER_READ_ONLY_OPTIMAL for the fragment shader.
+        context.getUploader().uploadImage(image,
+                                          imageData.data.data(),
+                                          imageData.data.size(),
+                                          imageData.width,
+                                          imageData.height,
+                                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                                          VK_ACCESS_SHADER_READ_BIT);
     }
 
     void initSampler(frm::VulkanContext& context)
@@ -207,7 +131,7 @@ struct TextureExample : public frm::App
         samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
         samplerInfo.unnormalizedCoordinates = VK_FALSE;
 
-        context.createSampler(samplerInfo, &sampler);
+        sampler = context.getObjectCache().getSampler(samplerInfo);
     }
 
     void initTransformation()
@@ -221,79 +145,35 @@ struct TextureExample : public frm::App
 
     void initBuffer(frm::VulkanContext& context)
     {
-        frm::BufferResourceRef stagingBuffer;
         frm::VertexPosTex* vertices = nullptr;
         uint32_t* indices = nullptr;
         size_t numVertices;
         size_t numIndices;
+        VkDeviceSize vertexSize;
+        VkDeviceSize indexSize;
         VkBufferCreateInfo bufferInfo{};
-        VkCommandBuffer copyCmd;
 
         numVertices = frm::ShapeGen::makePlane(0.5f, indices, vertices, numIndices); // make a flat plane
+        vertexSize = sizeof(frm::VertexPosTex) * numVertices;
+        indexSize = sizeof(uint32_t) * numIndices;
 
-        // create a temporary command buffer to copy buffer
-        context.createCommandBuffer(cmdPool, &copyCmd);
-
-        // create staging buffer
+        // create vertex buffer
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        bufferInfo.size = sizeof(frm::VertexPosTex) * numVertices;
-        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-
-        context.createBuffer(bufferInfo, VMA_MEMORY_USAGE_CPU_ONLY, stagingBuffer);
-
-        // create vertex buffer with the same size as the staging buffer
         bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bufferInfo.size = vertexSize;
         context.createBuffer(bufferInfo, VMA_MEMORY_USAGE_GPU_ONLY, vertexBuffer);
 
         // create index buffer
         bufferInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-        bufferInfo.size = sizeof(uint32_t) * numIndices;
+        bufferInfo.size = indexSize;
         context.createBuffer(bufferInfo, VMA_MEMORY_USAGE_GPU_ONLY, indexBuffer);
 
-        // copy vertex data to staging buffer
-        frm::VertexPosTex* mapped = nullptr;
-        stagingBuffer->map(&mapped);
-        std::memcpy(mapped, vertices, sizeof(frm::VertexPosTex) * numVertices);
-        stagingBuffer->unmap();
-
-        // copy vertex data which currently inside the staging buffer to the vertex buffer
-        VkCommandBufferBeginInfo beginInfo{};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-
-        VkBufferCopy region{};
-        region.size = sizeof(frm::VertexPosTex) * numVertices;
-
-        vkBeginCommandBuffer(copyCmd, &beginInfo);
-        vkCmdCopyBuffer(copyCmd, stagingBuffer->get(), vertexBuffer->get(), 1, &region);
-        vkEndCommandBuffer(copyCmd);
-
-        // submit our copy command to GPU!!
-        VkSubmitInfo submit{};
-        submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submit.commandBufferCount = 1;
-        submit.pCommandBuffers = &copyCmd;
-
-        context.queueSubmit(submit);
-
-        // Now do the same thing with index data
+        // queue vertex and index data for upload, they're copied to staging memory right away
+        context.getUploader().uploadBuffer(vertexBuffer, vertices, vertexSize, 0, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+        context.getUploader().uploadBuffer(indexBuffer, indices, indexSize, 0, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
 
-        // copy index data to staging buffer
-        uint32_t* mappedIndices;
-        stagingBuffer->map(&mappedIndices);
-        std::memcpy(mappedIndices, indices, sizeof(uint32_t) * numIndices);
-        stagingBuffer->unmap();
-
-        // copy index data which currently inside the staging buffer to the vertex buffer
-        region.size = sizeof(uint32_t) * numIndices;
-
-        vkResetCommandBuffer(copyCmd, 0);
-        vkBeginCommandBuffer(copyCmd, &beginInfo);
-        vkCmdCopyBuffer(copyCmd, stagingBuffer->get(), indexBuffer->get(), 1, &region);
-        vkEndCommandBuffer(copyCmd);
-
-        context.queueSubmit(submit);
-
-        vkFreeCommandBuffers(context.getDevice(), cmdPool, 1, &copyCmd);
+        // submit every queued upload to GPU!! we don't wait here, only when the data is actually needed
+        upload = context.getUploader().flush();
 
         delete indices;
         delete vertices;
@@ -305,6 +185,7 @@ struct TextureExample : public frm::App
         VkAttachmentDescription attachment{};
         VkAttachmentReference attRef{};
         VkSubpassDescription subpass{};
+        VkSubpassDependency dependency{};
 
         attachment.format = context.getSwapchainFormat();
         attachment.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -323,14 +204,24 @@ struct TextureExample : public frm::App
         subpass.colorAttachmentCount = 1;
         subpass.pColorAttachments = &attRef;
 
+        // the swapbuffer may still be read by the presentation engine, wait for the acquire semaphore
+        // (signaled at the color attachment output stage) before transitioning and writing to it
+        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependency.dstSubpass = 0;
+        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependency.srcAccessMask = 0;
+        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
         renderPassInfo.attachmentCount = 1;
-        renderPassInfo.dependencyCount = 0;
+        renderPassInfo.dependencyCount = 1;
         renderPassInfo.subpassCount = 1;
         renderPassInfo.pAttachments = &attachment;
         renderPassInfo.pSubpasses = &subpass;
+        renderPassInfo.pDependencies = &dependency;
 
-        context.createRenderPass(renderPassInfo, &renderPass);
+        renderPass = context.getObjectCache().getRenderPass(renderPassInfo);
     }
 
     void initFramebuffer(frm::VulkanContext& context)
@@ -354,6 +245,15 @@ struct TextureExample : public frm::App
         }
     }
 
+    void destroyFramebuffer(frm::VulkanContext& context)
+    {
+        for (auto framebuffer : fb) {
+            vkDestroyFramebuffer(context.getDevice(), framebuffer, nullptr);
+        }
+
+        fb.clear();
+    }
+
     void loadResources(frm::VulkanContext& context)
     {
         // Initialize resources
@@ -364,17 +264,17 @@ struct TextureExample : public frm::App
             throw std::runtime_error("Cannot load vertex shader");
         }
 
-        if (!frm::Resource::loadBinary("FragShader.fs.spv", fsBlob)) {
+        if (!frm::Resource::loadBinary(bindless ? "FragShaderBindless.fs.spv" : "FragShader.fs.spv", fsBlob)) {
             throw std::runtime_error("Cannot load fragment shader");
         }
 
-        context.createShaderModule(vsBlob, &vsModule);
-        context.createShaderModule(fsBlob, &fsModule);
+        vsModule = context.getObjectCache().getShaderModule(vsBlob);
+        fsModule = context.getObjectCache().getShaderModule(fsBlob);
     }
 
     void initPipeline(frm::VulkanContext& context)
     {
-        VkPushConstantRange pconstRange{};
+        VkPushConstantRange pconstRanges[2] = {};
         VkDescriptorSetLayoutBinding texBinding{}; // our texture binding information
         VkDescriptorSetLayoutCreateInfo setLayoutInfo{};
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
@@ -384,8 +284,9 @@ struct TextureExample : public frm::App
         VkVertexInputAttributeDescription inputAttribs[2] = {};
         VkPipelineVertexInputStateCreateInfo vertexInput{};
         VkPipelineInputAssemblyStateCreateInfo inputAsm{};
-        VkViewport viewport{};
         VkPipelineViewportStateCreateInfo viewportState{};
+        std::vector<VkDynamicState> dynamicStates;
+        VkPipelineDynamicStateCreateInfo dynamicState{};
         VkPipelineRasterizationStateCreateInfo rasterState{};
         VkPipelineMultisampleStateCreateInfo multisample{};
         VkPipelineColorBlendStateCreateInfo colorBlend{};
@@ -401,19 +302,24 @@ struct TextureExample : public frm::App
         setLayoutInfo.bindingCount = 1;
         setLayoutInfo.pBindings = &texBinding;
 
-        context.createDescriptorLayout(setLayoutInfo, &descSetLayout);
+        // the bindless table brings its own layout
+        descSetLayout = bindless ? context.getBindlessTable().getSetLayout() : context.getObjectCache().getDescriptorLayout(setLayoutInfo);
+
+        pconstRanges[0].offset = 0;
+        pconstRanges[0].size = sizeof(MyConstants);
+        pconstRanges[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
-        pconstRange.offset = 0;
-        pconstRange.size = sizeof(MyConstants);
-        pconstRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        pconstRanges[1].offset = sizeof(MyConstants);
+        pconstRanges[1].size = sizeof(BindlessIndices);
+        pconstRanges[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         pipelineLayoutInfo.setLayoutCount = 1;
         pipelineLayoutInfo.pSetLayouts = &descSetLayout;
-        pipelineLayoutInfo.pushConstantRangeCount = 1;
-        pipelineLayoutInfo.pPushConstantRanges = &pconstRange;
+        pipelineLayoutInfo.pushConstantRangeCount = bindless ? 2 : 1;
+        pipelineLayoutInfo.pPushConstantRanges = pconstRanges;
 
-        context.createPipelineLayout(pipelineLayoutInfo, &pipelineLayout);
+        pipelineLayout = context.getObjectCache().getPipelineLayout(pipelineLayoutInfo);
 
         shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -447,18 +353,18 @@ struct TextureExample : public frm::App
         inputAsm.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
         inputAsm.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 
-        viewport.x = 0;
-        viewport.y = 0;
-        viewport.width = static_cast<float>(viewRect.extent.width);
-        viewport.height = static_cast<float>(viewRect.extent.height);
-        viewport.minDepth = 0.f;
-        viewport.maxDepth = 1.f;
-
+        // viewport and scissor are set while recording, the pipeline doesn't depend on the swapchain size
         viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
         viewportState.scissorCount = 1;
-        viewportState.pScissors = &viewRect;
         viewportState.viewportCount = 1;
-        viewportState.pViewports = &viewport;
+
+        // everything the device can set while recording, the cull mode, topology etc. below are ignored when
+        // the extended dynamic state is there and one pipeline covers all their combinations
+        context.getDynamicStates(dynamicStates);
+
+        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+        dynamicState.pDynamicStates = dynamicStates.data();
 
         rasterState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
         rasterState.polygonMode = VK_POLYGON_MODE_FILL;
@@ -485,6 +391,7 @@ struct TextureExample : public frm::App
         pipelineInfo.pRasterizationState = &rasterState;
         pipelineInfo.pMultisampleState = &multisample;
         pipelineInfo.pColorBlendState = &colorBlend;
+        pipelineInfo.pDynamicState = &dynamicState;
         pipelineInfo.layout = pipelineLayout;
         pipelineInfo.renderPass = renderPass;
 
@@ -493,21 +400,18 @@ struct TextureExample : public frm::App
 
     void initDescriptor(frm::VulkanContext& context)
     {
-        VkDescriptorPoolSize texBindingSize{};
-        VkDescriptorPoolCreateInfo descPoolInfo{};
         VkDescriptorImageInfo imageDescInfo{};
         VkWriteDescriptorSet write{};
 
-        texBindingSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        texBindingSize.descriptorCount = 1;
-
-        descPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        descPoolInfo.maxSets = 1;
-        descPoolInfo.poolSizeCount = 1;
-        descPoolInfo.pPoolSizes = &texBindingSize;
+        // nothing to write, the table already has the texture and the sampler is added once
+        if (bindless) {
+            bindlessIndices.textureIndex = image->getBindlessIndex();
+            bindlessIndices.samplerIndex = context.getBindlessTable().addSampler(sampler);
+            return;
+        }
 
-        context.createDescriptorPool(descPoolInfo, &descriptorPool);
-        context.allocDescriptorSet(descSetLayout, descriptorPool, &descSet);
+        // the set lives as long as the app, so it comes from the context's persistent allocator
+        descSet = context.getDescriptorAllocator().allocate(descSetLayout);
 
         // bind our texture to the descriptor
         imageDescInfo.sampler = sampler;
@@ -525,9 +429,11 @@ struct TextureExample : public frm::App
         vkUpdateDescriptorSets(context.getDevice(), 1, &write, 0, nullptr);
     }
 
-    void recordCmd(frm::VulkanContext& context)
+    void finishUploads(frm::VulkanContext& context)
     {
-        context.createCommandBuffer(cmdPool, &renderCmd);
+        // the texture and buffers are needed from the first frame on, so this is the latest point we can wait for them
+        context.wait(upload);
+        context.getUploader().collect();
     }
 
     void onUpdate(frm::VulkanContext& context, double dt) override
@@ -541,6 +447,8 @@ struct TextureExample : public frm::App
 
     void onRender(frm::VulkanContext& context, double dt) override
     {
+        VkCommandBuffer renderCmd = context.getFrameCommandBuffer(); // reset by the context once this frame slot is free again
+        frm::CommandList cmd(context, renderCmd);
         VkBuffer buf = vertexBuffer->get();
         VkDeviceSize ofs = 0;
         VkCommandBufferBeginInfo cmdBegin{};
@@ -567,15 +475,24 @@ struct TextureExample : public frm::App
 
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-        vkResetCommandBuffer(renderCmd, 0);
         vkBeginCommandBuffer(renderCmd, &beginInfo);
         vkCmdBeginRenderPass(renderCmd, &rpBegin, VK_SUBPASS_CONTENTS_INLINE);
         vkCmdBindPipeline(renderCmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        cmd.resetDynamicState(rpBegin.renderArea); // viewport, scissor and the defaults for the extended state
         vkCmdBindVertexBuffers(renderCmd, 0, 1, &buf, &ofs); // bind vertex buffer
         vkCmdBindIndexBuffer(renderCmd, indexBuffer->get(), 0, VK_INDEX_TYPE_UINT32); // bind index buffer
         vkCmdPushConstants(renderCmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(MyConstants), &constants); // set push constant values
-        vkCmdBindDescriptorSets(renderCmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descSet, 0, nullptr); // SET descriptor set to pipeline
+
+        if (bindless) {
+            context.getBindlessTable().bind(renderCmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout);
+            vkCmdPushConstants(renderCmd, pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(MyConstants), sizeof(BindlessIndices), &bindlessIndices);
+        }
+        else {
+            vkCmdBindDescriptorSets(renderCmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descSet, 0, nullptr); // SET descriptor set to pipeline
+        }
+
         vkCmdDrawIndexed(renderCmd, 6, 1, 0, 0, 0); // draw triangle to the framebuffer
         vkCmdEndRenderPass(renderCmd);
         vkEndCommandBuffer(renderCmd);
@@ -586,32 +503,29 @@ struct TextureExample : public frm::App
         submit.commandBufferCount = 1;
         submit.pCommandBuffers = &renderCmd;
 
-        context.queueSubmit(submit);
+        context.submitFrame(submit); // doesn't block, the next frame can be recorded while this one is rendered
+    }
+
+    void onSwapchainRecreated(frm::VulkanContext& context) override
+    {
+        // the pipeline uses dynamic viewport/scissor, only the framebuffers depend on the swapchain
+        destroyFramebuffer(context);
+        initTransformation();
+        initFramebuffer(context);
     }
 
     void onDestroy(frm::VulkanContext& context) override
     {
         VkDevice device = context.getDevice();
 
-        vkDestroySampler(device, sampler, nullptr);
         vkDestroyImageView(device, imageView, nullptr);
-        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
         vkDestroyPipeline(device, pipeline, nullptr);
-        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
-        vkDestroyDescriptorSetLayout(device, descSetLayout, nullptr);
-        vkDestroyShaderModule(device, vsModule, nullptr);
-        vkDestroyShaderModule(device, fsModule, nullptr);
-
-        for (auto framebuffer : fb) {
-            vkDestroyFramebuffer(device, framebuffer, nullptr);
-        }
 
-        vkDestroyRenderPass(device, renderPass, nullptr);
-        vkDestroyCommandPool(device, cmdPool, nullptr);
+        destroyFramebuffer(context);
     }
 };
 
-int main()
+int main(int argc, char** argv)
 {
-    return frm::App::run<TextureExample>(640, 480);
+    return frm::App::run<TextureExample>(640, 480, argc, argv);
 }
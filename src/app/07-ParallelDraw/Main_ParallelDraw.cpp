@@ -0,0 +1,359 @@
+#include <framework/App.h>
+#include <framework/Resource.h>
+#include <framework/ObjectCache.h>
+#include <framework/ParallelRecorder.h>
+
+// Draws a big grid of triangles, one draw call each, recorded into secondary command buffers by
+// several threads. --threads <n> picks the thread count, --sweep measures every count from 1 up to all cores.
+struct ParallelDrawExample : public frm::App
+{
+    static const uint32_t g_gridSize = 128; // 16384 draws
+    static const uint32_t g_sweepFrames = 200; // frames measured per thread count
+
+    VkRenderPass renderPass;
+    VkShaderModule vsModule;
+    VkShaderModule fsModule;
+    VkPipelineLayout pipelineLayout;
+    VkPipeline pipeline;
+    std::vector<VkFramebuffer> fb;
+    std::unique_ptr<frm::ParallelRecorder> recorder;
+
+    struct MyConstants
+    {
+        glm::vec4 color;
+        glm::vec2 offset;
+        float size;
+    };
+
+    std::vector<MyConstants> items;
+    float time = 0.f;
+
+    // thread sweep state
+    bool sweep = false;
+    uint32_t sweepFrame = 0;
+    double recordTime = 0.0;
+
+    void onInit(frm::VulkanContext& context) override
+    {
+        recorder = std::make_unique<frm::ParallelRecorder>(context);
+
+        if (const char* threads = getArgValue("--threads")) {
+            recorder->setThreadCount(static_cast<uint32_t>(std::strtoul(threads, nullptr, 10)));
+        }
+
+        if (hasArg("--sweep")) {
+            sweep = true;
+            recorder->setThreadCount(1);
+        }
+
+        std::cout << "Recording " << g_gridSize * g_gridSize << " draws on " << recorder->getThreadCount() << " thread(s)" << std::endl;
+
+        initItems();
+        initRenderPass(context);
+        loadResources(context);
+        initPipeline(context);
+        initFramebuffer(context);
+    }
+
+    void initItems()
+    {
+        float cellSize = 2.f / static_cast<float>(g_gridSize);
+
+        // a colored triangle in every cell of the clip space grid
+        for (uint32_t y = 0; y < g_gridSize; y++) {
+            for (uint32_t x = 0; x < g_gridSize; x++) {
+                MyConstants item{};
+
+                item.color = glm::vec4(static_cast<float>(x) / g_gridSize, static_cast<float>(y) / g_gridSize, 0.5f, 1.f);
+                item.offset = glm::vec2(-1.f + cellSize * (static_cast<float>(x) + 0.5f), -1.f + cellSize * (static_cast<float>(y) + 0.5f));
+                item.size = cellSize;
+
+                items.push_back(item);
+            }
+        }
+    }
+
+    void initRenderPass(frm::VulkanContext& context)
+    {
+        VkRenderPassCreateInfo renderPassInfo{};
+        VkAttachmentDescription attachment{};
+        VkAttachmentReference attRef{};
+        VkSubpassDescription subpass{};
+        VkSubpassDependency dependency{};
+
+        attachment.format = context.getSwapchainFormat();
+        attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+        attRef.attachment = 0;
+        attRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &attRef;
+
+        // the swapbuffer may still be read by the presentation engine, wait for the acquire semaphore
+        // (signaled at the color attachment output stage) before transitioning and writing to it
+        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependency.dstSubpass = 0;
+        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependency.srcAccessMask = 0;
+        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = 1;
+        renderPassInfo.dependencyCount = 1;
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pAttachments = &attachment;
+        renderPassInfo.pSubpasses = &subpass;
+        renderPassInfo.pDependencies = &dependency;
+
+        renderPass = context.getObjectCache().getRenderPass(renderPassInfo);
+    }
+
+    void initFramebuffer(frm::VulkanContext& context)
+    {
+        VkRect2D imgSize{};
+
+        getClientSizeRect(imgSize);
+
+        // Create framebuffer for each swapbuffer
+        for (size_t i = 0; i < context.getSwapbufferCount(); i++) {
+            VkFramebufferCreateInfo fbInfo{};
+            VkImageView imgView = context.getSwapbufferView(i);
+            VkFramebuffer framebuffer;
+
+            fbInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            fbInfo.renderPass = renderPass;
+            fbInfo.attachmentCount = 1;
+            fbInfo.pAttachments = &imgView;
+            fbInfo.width = imgSize.extent.width;
+            fbInfo.height = imgSize.extent.height;
+            fbInfo.layers = 1;
+
+            context.createFramebuffer(fbInfo, &framebuffer);
+            fb.push_back(framebuffer);
+        }
+    }
+
+    void destroyFramebuffer(frm::VulkanContext& context)
+    {
+        for (auto framebuffer : fb) {
+            vkDestroyFramebuffer(context.getDevice(), framebuffer, nullptr);
+        }
+
+        fb.clear();
+    }
+
+    void loadResources(frm::VulkanContext& context)
+    {
+        std::vector<uint8_t> vsBlob;
+        std::vector<uint8_t> fsBlob;
+
+        if (!frm::Resource::loadBinary("VertexShader.vs.spv", vsBlob)) {
+            throw std::runtime_error("Cannot load vertex shader");
+        }
+
+        if (!frm::Resource::loadBinary("FragShader.fs.spv", fsBlob)) {
+            throw std::runtime_error("Cannot load fragment shader");
+        }
+
+        vsModule = context.getObjectCache().getShaderModule(vsBlob);
+        fsModule = context.getObjectCache().getShaderModule(fsBlob);
+    }
+
+    void initPipeline(frm::VulkanContext& context)
+    {
+        VkPushConstantRange pconstRange{};
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        VkGraphicsPipelineCreateInfo pipelineInfo{};
+        VkPipelineShaderStageCreateInfo shaderStages[2] = {};
+        VkPipelineVertexInputStateCreateInfo vertexInput{};
+        VkPipelineInputAssemblyStateCreateInfo inputAsm{};
+        VkPipelineViewportStateCreateInfo viewportState{};
+        VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+        VkPipelineDynamicStateCreateInfo dynamicState{};
+        VkPipelineRasterizationStateCreateInfo rasterState{};
+        VkPipelineMultisampleStateCreateInfo multisample{};
+        VkPipelineColorBlendStateCreateInfo colorBlend{};
+        VkPipelineColorBlendAttachmentState blendAtt{};
+
+        pconstRange.offset = 0;
+        pconstRange.size = sizeof(MyConstants);
+        pconstRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pconstRange;
+
+        pipelineLayout = context.getObjectCache().getPipelineLayout(pipelineLayoutInfo);
+
+        shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+        shaderStages[0].module = vsModule;
+        shaderStages[0].pName = "main";
+
+        shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        shaderStages[1].module = fsModule;
+        shaderStages[1].pName = "main";
+
+        vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+        inputAsm.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        inputAsm.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+        // viewport and scissor are set while recording, the pipeline doesn't depend on the swapchain size
+        viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+        viewportState.scissorCount = 1;
+        viewportState.viewportCount = 1;
+
+        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamicState.dynamicStateCount = GET_ARRAY_SIZE(dynamicStates);
+        dynamicState.pDynamicStates = dynamicStates;
+
+        rasterState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rasterState.polygonMode = VK_POLYGON_MODE_FILL;
+        rasterState.lineWidth = 1.0f;
+        rasterState.cullMode = VK_CULL_MODE_NONE;
+        rasterState.frontFace = VK_FRONT_FACE_CLOCKWISE;
+
+        multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+        blendAtt.blendEnable = VK_FALSE;
+        blendAtt.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+        colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        colorBlend.attachmentCount = 1;
+        colorBlend.pAttachments = &blendAtt;
+
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.stageCount = 2;
+        pipelineInfo.pStages = shaderStages;
+        pipelineInfo.pVertexInputState = &vertexInput;
+        pipelineInfo.pInputAssemblyState = &inputAsm;
+        pipelineInfo.pViewportState = &viewportState;
+        pipelineInfo.pRasterizationState = &rasterState;
+        pipelineInfo.pMultisampleState = &multisample;
+        pipelineInfo.pColorBlendState = &colorBlend;
+        pipelineInfo.pDynamicState = &dynamicState;
+        pipelineInfo.layout = pipelineLayout;
+        pipelineInfo.renderPass = renderPass;
+
+        context.createGraphicsPipeline(pipelineInfo, &pipeline);
+    }
+
+    void onUpdate(frm::VulkanContext& context, double dt) override
+    {
+        time += static_cast<float>(dt);
+    }
+
+    void onRender(frm::VulkanContext& context, double dt) override
+    {
+        VkCommandBuffer cmdBuffer = context.getFrameCommandBuffer(); // reset by the context once this frame slot is free again
+        VkCommandBufferBeginInfo cmdBegin{};
+        VkRenderPassBeginInfo rpBegin{};
+        VkClearValue clearValue{};
+        VkViewport viewport{};
+        VkSubmitInfo submitInfo{};
+        float pulse = 0.75f + std::sin(time * 2.f) * 0.25f;
+
+        cmdBegin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        cmdBegin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        rpBegin.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        rpBegin.renderPass = renderPass;
+        rpBegin.framebuffer = fb[getCurrentSwapbuffer()];
+        rpBegin.clearValueCount = 1;
+        rpBegin.pClearValues = &clearValue;
+
+        getClientSizeRect(rpBegin.renderArea);
+
+        viewport.width = static_cast<float>(rpBegin.renderArea.extent.width);
+        viewport.height = static_cast<float>(rpBegin.renderArea.extent.height);
+        viewport.maxDepth = 1.f;
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        vkBeginCommandBuffer(cmdBuffer, &cmdBegin);
+
+        // every chunk is its own secondary buffer, nothing is inherited from the primary
+        recorder->recordRenderPass(cmdBuffer, rpBegin, static_cast<uint32_t>(items.size()), [&](VkCommandBuffer chunkCmd, uint32_t first, uint32_t count) {
+            vkCmdBindPipeline(chunkCmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            vkCmdSetViewport(chunkCmd, 0, 1, &viewport);
+            vkCmdSetScissor(chunkCmd, 0, 1, &rpBegin.renderArea);
+
+            for (uint32_t i = first; i < first + count; i++) {
+                MyConstants constants = items[i];
+
+                constants.size *= pulse;
+
+                vkCmdPushConstants(chunkCmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(MyConstants), &constants);
+                vkCmdDraw(chunkCmd, 3, 1, 0, 0);
+            }
+        });
+
+        vkEndCommandBuffer(cmdBuffer);
+
+        recordTime += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &cmdBuffer;
+
+        context.submitFrame(submitInfo);
+
+        if (sweep) {
+            updateSweep(context);
+        }
+    }
+
+    void updateSweep(frm::VulkanContext& context)
+    {
+        uint32_t threadCount = recorder->getThreadCount();
+
+        if (++sweepFrame < g_sweepFrames) {
+            return;
+        }
+
+        std::cout << "Threads: " << threadCount << ", recording: " << recordTime * 1000.0 / g_sweepFrames << " ms/frame" << std::endl;
+
+        sweepFrame = 0;
+        recordTime = 0.0;
+
+        // 1, 2, 3, ... up to every thread we have
+        recorder->setThreadCount(threadCount + 1);
+
+        if (recorder->getThreadCount() == threadCount) {
+            sweep = false;
+        }
+    }
+
+    void onSwapchainRecreated(frm::VulkanContext& context) override
+    {
+        // the pipeline uses dynamic viewport/scissor, only the framebuffers depend on the swapchain
+        destroyFramebuffer(context);
+        initFramebuffer(context);
+    }
+
+    void onDestroy(frm::VulkanContext& context) override
+    {
+        VkDevice device = context.getDevice();
+
+        vkDestroyPipeline(device, pipeline, nullptr);
+
+        destroyFramebuffer(context);
+    }
+};
+
+int main(int argc, char** argv)
+{
+    return frm::App::run<ParallelDrawExample>(640, 480, argc, argv);
+}
@@ -0,0 +1,19 @@
+#version 460
+
+layout(push_constant) uniform pushConstant
+{
+    vec4 color;
+    vec2 offset;
+    float size;
+};
+
+vec2 pos[] = vec2[3](
+    vec2(0.5, 0.5),
+    vec2(-0.5, 0.5),
+    vec2(0.0, -0.5)
+);
+
+void main()
+{
+    gl_Position = vec4(pos[gl_VertexIndex] * size + offset, 0.5, 1.0);
+}
@@ -0,0 +1,21 @@
+#version 460
+
+layout(set = 0, binding = 0) uniform sampler2D scene;
+
+// written by the compute pass every frame, one color per row band
+layout(set = 1, binding = 0) readonly buffer Ramp
+{
+    vec4 colors[];
+} ramp;
+
+layout(location = 0) in vec2 uv;
+layout(location = 0) out vec4 o_color;
+
+void main()
+{
+    vec2 d = uv - 0.5;
+    uint count = uint(ramp.colors.length());
+    uint row = min(uint(uv.y * float(count)), count - 1u);
+    vec3 c = texture(scene, uv).rgb * (1.0 - dot(d, d) * 1.5); // darken the corners
+    o_color = vec4(c * ramp.colors[row].rgb, 1.0);
+}
@@ -0,0 +1,10 @@
+#version 460
+
+layout(location = 0) out vec2 o_uv;
+
+void main()
+{
+    // one triangle covering the whole screen
+    o_uv = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+    gl_Position = vec4(o_uv * 2.0 - 1.0, 0.5, 1.0);
+}
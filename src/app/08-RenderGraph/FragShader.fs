@@ -0,0 +1,8 @@
+#version 460
+
+layout(location = 0) out vec4 o_color;
+
+void main()
+{
+    o_color = vec4(1.0, 0.5, 0.0, 1.0);
+}
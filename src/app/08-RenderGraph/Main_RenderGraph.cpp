@@ -0,0 +1,677 @@
+#include <framework/App.h>
+#include <framework/Resource.h>
+#include <framework/ObjectCache.h>
+#include <framework/DescriptorAllocator.h>
+#include <framework/CommandAllocator.h>
+#include <framework/RenderGraph.h>
+#include <framework/GpuProfiler.h>
+
+// Renders a triangle into an offscreen image and composites it onto the swapbuffer. The frame is built as
+// a render graph, none of the barriers and layout transitions between the passes are written by hand.
+// With dynamic rendering the passes draw straight into the image views, otherwise through render passes.
+// A color ramp for the composite is computed on the async compute queue, the frame waits for it on the GPU.
+struct RenderGraphExample : public frm::App
+{
+    static const VkFormat g_sceneFormat = VK_FORMAT_R8G8B8A8_UNORM;
+    static const uint32_t g_rampSize = 256;
+
+    frm::RenderGraph graph;
+    frm::ImageResourceRef sceneImage;
+    VkImageView sceneView;
+    VkRenderPass sceneRenderPass = VK_NULL_HANDLE;
+    VkRenderPass compositeRenderPass = VK_NULL_HANDLE;
+    VkFramebuffer sceneFb = VK_NULL_HANDLE;
+    std::vector<VkFramebuffer> compositeFb;
+    VkShaderModule vsModule;
+    VkShaderModule fsModule;
+    VkShaderModule compositeVsModule;
+    VkShaderModule compositeFsModule;
+    VkShaderModule rampCsModule;
+    VkDescriptorSetLayout descSetLayout;
+    VkDescriptorSetLayout rampSetLayout;
+    VkDescriptorSet descSet;
+    std::vector<VkDescriptorSet> rampSets;
+    std::vector<frm::BufferResourceRef> rampBuffers; // one per frame in flight, the GPU may still read the previous one
+    std::unique_ptr<frm::CommandAllocator> computeCmdAllocator;
+    VkPipelineLayout scenePipelineLayout;
+    VkPipelineLayout compositePipelineLayout;
+    VkPipelineLayout rampPipelineLayout;
+    VkPipeline scenePipeline;
+    VkPipeline compositePipeline;
+    VkPipeline rampPipeline;
+    VkSampler sampler;
+    VkRect2D viewRect;
+    float time = 0.f;
+    bool printStats = true;
+    bool dynamicRendering = false;
+
+    void onInit(frm::VulkanContext& context) override
+    {
+        dynamicRendering = context.getFeatures().dynamicRendering && !hasArg("--render-pass");
+
+        std::cout << "Using " << (dynamicRendering ? "dynamic rendering" : "render passes") << std::endl;
+
+        if (!dynamicRendering) {
+            initRenderPass(context);
+        }
+
+        initSampler(context);
+        loadResources(context);
+        initPipeline(context);
+        initRamp(context);
+        descSet = context.getDescriptorAllocator().allocate(descSetLayout);
+        initSceneImage(context);
+        initFramebuffer(context);
+    }
+
+    void initRenderPass(frm::VulkanContext& context)
+    {
+        VkRenderPassCreateInfo renderPassInfo{};
+        VkAttachmentDescription attachment{};
+        VkAttachmentReference attRef{};
+        VkSubpassDescription subpass{};
+
+        // The graph moves the images into COLOR_ATTACHMENT_OPTIMAL before the pass and out of it afterwards,
+        // so the render passes neither transition nor need external dependencies.
+        attachment.format = g_sceneFormat;
+        attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD; // cleared by the background pass
+        attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        attRef.attachment = 0;
+        attRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &attRef;
+
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = 1;
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pAttachments = &attachment;
+        renderPassInfo.pSubpasses = &subpass;
+
+        sceneRenderPass = context.getObjectCache().getRenderPass(renderPassInfo);
+
+        // the composite covers every pixel, the old swapbuffer contents don't matter
+        attachment.format = context.getSwapchainFormat();
+        attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+
+        compositeRenderPass = context.getObjectCache().getRenderPass(renderPassInfo);
+    }
+
+    void initSampler(frm::VulkanContext& context)
+    {
+        VkSamplerCreateInfo samplerInfo{};
+
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_LINEAR;
+        samplerInfo.minFilter = VK_FILTER_LINEAR;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+
+        sampler = context.getObjectCache().getSampler(samplerInfo);
+    }
+
+    void initSceneImage(frm::VulkanContext& context)
+    {
+        VkImageCreateInfo imageInfo{};
+        VkImageViewCreateInfo imageViewInfo{};
+        VkDescriptorImageInfo imageDescInfo{};
+        VkWriteDescriptorSet write{};
+
+        getClientSizeRect(viewRect);
+
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = g_sceneFormat;
+        imageInfo.extent.width = viewRect.extent.width;
+        imageInfo.extent.height = viewRect.extent.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        context.createImage(imageInfo, VMA_MEMORY_USAGE_GPU_ONLY, sceneImage);
+
+        imageViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        imageViewInfo.image = sceneImage->get();
+        imageViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        imageViewInfo.format = imageInfo.format;
+        imageViewInfo.components = { VK_COMPONENT_SWIZZLE_IDENTITY };
+        imageViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        imageViewInfo.subresourceRange.levelCount = 1;
+        imageViewInfo.subresourceRange.layerCount = 1;
+
+        context.createImageView(imageViewInfo, &sceneView);
+
+        imageDescInfo.sampler = sampler;
+        imageDescInfo.imageView = sceneView;
+        imageDescInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = descSet;
+        write.dstBinding = 0;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.pImageInfo = &imageDescInfo;
+
+        vkUpdateDescriptorSets(context.getDevice(), 1, &write, 0, nullptr);
+    }
+
+    void destroySceneImage(frm::VulkanContext& context)
+    {
+        vkDestroyImageView(context.getDevice(), sceneView, nullptr);
+        sceneImage.reset();
+    }
+
+    void initFramebuffer(frm::VulkanContext& context)
+    {
+        VkFramebufferCreateInfo fbInfo{};
+
+        if (dynamicRendering) {
+            return; // nothing to create, a resize only replaces the scene image
+        }
+
+        fbInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        fbInfo.renderPass = sceneRenderPass;
+        fbInfo.attachmentCount = 1;
+        fbInfo.pAttachments = &sceneView;
+        fbInfo.width = viewRect.extent.width;
+        fbInfo.height = viewRect.extent.height;
+        fbInfo.layers = 1;
+
+        context.createFramebuffer(fbInfo, &sceneFb);
+
+        // Create framebuffer for each swapbuffer
+        for (size_t i = 0; i < context.getSwapbufferCount(); i++) {
+            VkImageView imgView = context.getSwapbufferView(i);
+            VkFramebuffer framebuffer;
+
+            fbInfo.renderPass = compositeRenderPass;
+            fbInfo.pAttachments = &imgView;
+
+            context.createFramebuffer(fbInfo, &framebuffer);
+            compositeFb.push_back(framebuffer);
+        }
+    }
+
+    void destroyFramebuffer(frm::VulkanContext& context)
+    {
+        vkDestroyFramebuffer(context.getDevice(), sceneFb, nullptr);
+
+        for (auto framebuffer : compositeFb) {
+            vkDestroyFramebuffer(context.getDevice(), framebuffer, nullptr);
+        }
+
+        compositeFb.clear();
+    }
+
+    void loadResources(frm::VulkanContext& context)
+    {
+        const char* names[] = { "VertexShader.vs.spv", "FragShader.fs.spv", "CompositeVS.vs.spv", "CompositeFS.fs.spv", "RampCS.cs.spv" };
+        VkShaderModule* modules[] = { &vsModule, &fsModule, &compositeVsModule, &compositeFsModule, &rampCsModule };
+
+        for (size_t i = 0; i < GET_ARRAY_SIZE(names); i++) {
+            std::vector<uint8_t> blob;
+
+            if (!frm::Resource::loadBinary(names[i], blob)) {
+                throw std::runtime_error(std::string("Cannot load shader ") + names[i]);
+            }
+
+            *modules[i] = context.getObjectCache().getShaderModule(blob);
+        }
+    }
+
+    void initPipeline(frm::VulkanContext& context)
+    {
+        VkPushConstantRange pconstRange{};
+        VkDescriptorSetLayoutBinding texBinding{};
+        VkDescriptorSetLayoutBinding rampBinding{};
+        VkDescriptorSetLayoutCreateInfo setLayoutInfo{};
+        VkDescriptorSetLayout compositeSetLayouts[2];
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        std::vector<VkGraphicsPipelineCreateInfo> pipelineInfos(2);
+        VkPipelineShaderStageCreateInfo shaderStages[2][2] = {};
+        VkPipelineVertexInputStateCreateInfo vertexInput{};
+        VkPipelineInputAssemblyStateCreateInfo inputAsm{};
+        VkPipelineViewportStateCreateInfo viewportState{};
+        VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+        VkPipelineDynamicStateCreateInfo dynamicState{};
+        VkPipelineRasterizationStateCreateInfo rasterState{};
+        VkPipelineMultisampleStateCreateInfo multisample{};
+        VkPipelineColorBlendStateCreateInfo colorBlend{};
+        VkPipelineColorBlendAttachmentState blendAtt{};
+        VkFormat colorFormats[2] = { g_sceneFormat, context.getSwapchainFormat() };
+        VkPipelineRenderingCreateInfoKHR renderingInfos[2] = {};
+
+        texBinding.binding = 0;
+        texBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        texBinding.descriptorCount = 1;
+        texBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        setLayoutInfo.bindingCount = 1;
+        setLayoutInfo.pBindings = &texBinding;
+
+        descSetLayout = context.getObjectCache().getDescriptorLayout(setLayoutInfo);
+
+        // written by the compute pass, read by the composite
+        rampBinding.binding = 0;
+        rampBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        rampBinding.descriptorCount = 1;
+        rampBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        setLayoutInfo.pBindings = &rampBinding;
+
+        rampSetLayout = context.getObjectCache().getDescriptorLayout(setLayoutInfo);
+
+        pconstRange.offset = 0;
+        pconstRange.size = sizeof(float);
+        pconstRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pconstRange;
+
+        scenePipelineLayout = context.getObjectCache().getPipelineLayout(pipelineLayoutInfo);
+
+        compositeSetLayouts[0] = descSetLayout;
+        compositeSetLayouts[1] = rampSetLayout;
+
+        pipelineLayoutInfo.setLayoutCount = 2;
+        pipelineLayoutInfo.pSetLayouts = compositeSetLayouts;
+        pipelineLayoutInfo.pushConstantRangeCount = 0;
+        pipelineLayoutInfo.pPushConstantRanges = nullptr;
+
+        compositePipelineLayout = context.getObjectCache().getPipelineLayout(pipelineLayoutInfo);
+
+        // time and ramp size
+        pconstRange.size = sizeof(float) + sizeof(uint32_t);
+        pconstRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &rampSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pconstRange;
+
+        rampPipelineLayout = context.getObjectCache().getPipelineLayout(pipelineLayoutInfo);
+
+        vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+        inputAsm.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        inputAsm.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+        // viewport and scissor are set while recording, the pipeline doesn't depend on the swapchain size
+        viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+        viewportState.scissorCount = 1;
+        viewportState.viewportCount = 1;
+
+        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamicState.dynamicStateCount = GET_ARRAY_SIZE(dynamicStates);
+        dynamicState.pDynamicStates = dynamicStates;
+
+        rasterState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rasterState.polygonMode = VK_POLYGON_MODE_FILL;
+        rasterState.lineWidth = 1.0f;
+        rasterState.cullMode = VK_CULL_MODE_NONE;
+        rasterState.frontFace = VK_FRONT_FACE_CLOCKWISE;
+
+        multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+        blendAtt.blendEnable = VK_FALSE;
+        blendAtt.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+        colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        colorBlend.attachmentCount = 1;
+        colorBlend.pAttachments = &blendAtt;
+
+        // both pipelines share everything but the shaders, layout and render pass
+        for (size_t i = 0; i < pipelineInfos.size(); i++) {
+            VkShaderModule vs = i == 0 ? vsModule : compositeVsModule;
+            VkShaderModule fs = i == 0 ? fsModule : compositeFsModule;
+
+            shaderStages[i][0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            shaderStages[i][0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+            shaderStages[i][0].module = vs;
+            shaderStages[i][0].pName = "main";
+
+            shaderStages[i][1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            shaderStages[i][1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+            shaderStages[i][1].module = fs;
+            shaderStages[i][1].pName = "main";
+
+            pipelineInfos[i].sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+            pipelineInfos[i].stageCount = 2;
+            pipelineInfos[i].pStages = shaderStages[i];
+            pipelineInfos[i].pVertexInputState = &vertexInput;
+            pipelineInfos[i].pInputAssemblyState = &inputAsm;
+            pipelineInfos[i].pViewportState = &viewportState;
+            pipelineInfos[i].pRasterizationState = &rasterState;
+            pipelineInfos[i].pMultisampleState = &multisample;
+            pipelineInfos[i].pColorBlendState = &colorBlend;
+            pipelineInfos[i].pDynamicState = &dynamicState;
+            pipelineInfos[i].layout = i == 0 ? scenePipelineLayout : compositePipelineLayout;
+            pipelineInfos[i].renderPass = i == 0 ? sceneRenderPass : compositeRenderPass;
+
+            // without a render pass the pipeline only needs to know the attachment formats
+            if (dynamicRendering) {
+                renderingInfos[i].sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+                renderingInfos[i].colorAttachmentCount = 1;
+                renderingInfos[i].pColorAttachmentFormats = &colorFormats[i];
+
+                pipelineInfos[i].pNext = &renderingInfos[i];
+            }
+        }
+
+        // compiled in parallel on the worker threads
+        std::vector<VkPipeline> pipelines;
+
+        context.createGraphicsPipelines(pipelineInfos, pipelines);
+
+        scenePipeline = pipelines[0];
+        compositePipeline = pipelines[1];
+
+        VkComputePipelineCreateInfo computeInfo{};
+
+        computeInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        computeInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        computeInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        computeInfo.stage.module = rampCsModule;
+        computeInfo.stage.pName = "main";
+        computeInfo.layout = rampPipelineLayout;
+
+        context.createComputePipeline(computeInfo, &rampPipeline);
+    }
+
+    void initRamp(frm::VulkanContext& context)
+    {
+        VkBufferCreateInfo bufferInfo{};
+        std::vector<uint32_t> queueFamilies;
+
+        // written on the compute queue and read on the graphics queue, which may be different families
+        context.getQueueFamilies(queueFamilies);
+
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = g_rampSize * sizeof(glm::vec4);
+        bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+        if (queueFamilies.size() > 1) {
+            bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+            bufferInfo.pQueueFamilyIndices = queueFamilies.data();
+        }
+
+        rampBuffers.resize(context.getFramesInFlight());
+        rampSets.resize(context.getFramesInFlight());
+
+        for (size_t i = 0; i < rampBuffers.size(); i++) {
+            VkDescriptorBufferInfo bufferDescInfo{};
+            VkWriteDescriptorSet write{};
+
+            context.createBuffer(bufferInfo, VMA_MEMORY_USAGE_GPU_ONLY, rampBuffers[i]);
+            rampSets[i] = context.getDescriptorAllocator().allocate(rampSetLayout);
+
+            bufferDescInfo.buffer = rampBuffers[i]->get();
+            bufferDescInfo.range = VK_WHOLE_SIZE;
+
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = rampSets[i];
+            write.dstBinding = 0;
+            write.descriptorCount = 1;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            write.pBufferInfo = &bufferDescInfo;
+
+            vkUpdateDescriptorSets(context.getDevice(), 1, &write, 0, nullptr);
+        }
+
+        computeCmdAllocator = std::make_unique<frm::CommandAllocator>(context, context.getFramesInFlight(), frm::QueueType::Compute);
+    }
+
+    // Runs on the compute queue ahead of the frame, the composite waits for the ticket on the GPU
+    frm::SubmitTicket dispatchRamp(frm::VulkanContext& context)
+    {
+        uint32_t frameIndex = context.getFrameIndex();
+        VkCommandBuffer cmdBuffer;
+        VkCommandBufferBeginInfo cmdBegin{};
+        VkSubmitInfo submitInfo{};
+        struct
+        {
+            float time;
+            uint32_t count;
+        } params = { time, g_rampSize };
+
+        // The previous submission from this slot is done: the frame that waited for it has passed its fence
+        computeCmdAllocator->beginFrame(frameIndex);
+        cmdBuffer = computeCmdAllocator->allocate();
+
+        cmdBegin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        cmdBegin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        vkBeginCommandBuffer(cmdBuffer, &cmdBegin);
+
+        {
+            FRM_GPU_SCOPE_QUEUE(context, cmdBuffer, "ramp", frm::QueueType::Compute);
+            vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, rampPipeline);
+            vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, rampPipelineLayout, 0, 1, &rampSets[frameIndex], 0, nullptr);
+            vkCmdPushConstants(cmdBuffer, rampPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(params), &params);
+            frm::VulkanContext::cmdDispatchThreads(cmdBuffer, glm::uvec3(g_rampSize, 1, 1), glm::uvec3(64, 1, 1));
+        }
+
+        vkEndCommandBuffer(cmdBuffer);
+
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &cmdBuffer;
+
+        return context.queueSubmitAsync(frm::QueueType::Compute, submitInfo);
+    }
+
+    void onUpdate(frm::VulkanContext& context, double dt) override
+    {
+        time += static_cast<float>(dt);
+    }
+
+    void buildGraph(frm::VulkanContext& context)
+    {
+        VkImage swapbuffer = context.getSwapbuffer(getCurrentSwapbuffer());
+        frm::RenderGraph::ResourceHandle scene;
+        frm::RenderGraph::ResourceHandle backbuffer;
+
+        graph.reset();
+
+        // the previous frame's composite read the scene image, the acquire semaphore is waited on at the color output stage
+        // the image remembers its state from the previous frame's graph
+        scene = graph.importImage("scene", sceneImage);
+        backbuffer = graph.importImage("backbuffer", swapbuffer, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+        graph.addPass("background", [&](frm::RenderGraph::PassBuilder& builder) {
+            builder.write(scene, frm::ResourceUsage::Transfer);
+        }, [this, &context](VkCommandBuffer cmdBuffer) {
+            FRM_GPU_SCOPE(context, cmdBuffer, "background");
+            VkClearColorValue color{};
+            VkImageSubresourceRange range{};
+
+            color.float32[0] = 0.1f;
+            color.float32[1] = 0.1f;
+            color.float32[2] = 0.2f + std::sin(time) * 0.1f;
+            color.float32[3] = 1.0f;
+
+            range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            range.levelCount = 1;
+            range.layerCount = 1;
+
+            vkCmdClearColorImage(cmdBuffer, sceneImage->get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &color, 1, &range);
+        });
+
+        // writes to an image nobody reads afterwards, the graph drops it
+        graph.addPass("unused clear", [&](frm::RenderGraph::PassBuilder& builder) {
+            builder.write(backbuffer, frm::ResourceUsage::Transfer);
+        }, [swapbuffer](VkCommandBuffer cmdBuffer) {
+            VkClearColorValue color{};
+            VkImageSubresourceRange range{};
+
+            range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            range.levelCount = 1;
+            range.layerCount = 1;
+
+            vkCmdClearColorImage(cmdBuffer, swapbuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &color, 1, &range);
+        });
+
+        graph.addPass("scene", [&](frm::RenderGraph::PassBuilder& builder) {
+            builder.read(scene, frm::ResourceUsage::ColorAttachment); // drawn on top of the background
+            builder.write(scene, frm::ResourceUsage::ColorAttachment);
+        }, [this, &context](VkCommandBuffer cmdBuffer) {
+            FRM_GPU_SCOPE(context, cmdBuffer, "scene");
+
+            beginPass(context, cmdBuffer, sceneRenderPass, sceneFb, sceneView, VK_ATTACHMENT_LOAD_OP_LOAD);
+            vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, scenePipeline);
+            vkCmdPushConstants(cmdBuffer, scenePipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(float), &time);
+            vkCmdDraw(cmdBuffer, 3, 1, 0, 0);
+            endPass(context, cmdBuffer);
+        });
+
+        graph.addPass("composite", [&](frm::RenderGraph::PassBuilder& builder) {
+            builder.read(scene, frm::ResourceUsage::FragmentShader);
+            builder.write(backbuffer, frm::ResourceUsage::ColorAttachment);
+        }, [this, &context](VkCommandBuffer cmdBuffer) {
+            FRM_GPU_SCOPE(context, cmdBuffer, "composite");
+            VkFramebuffer framebuffer = dynamicRendering ? VK_NULL_HANDLE : compositeFb[getCurrentSwapbuffer()];
+
+            beginPass(context, cmdBuffer, compositeRenderPass, framebuffer, context.getSwapbufferView(getCurrentSwapbuffer()), VK_ATTACHMENT_LOAD_OP_DONT_CARE);
+            vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, compositePipeline);
+            VkDescriptorSet sets[] = { descSet, rampSets[context.getFrameIndex()] };
+
+            vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, compositePipelineLayout, 0, 2, sets, 0, nullptr);
+            vkCmdDraw(cmdBuffer, 3, 1, 0, 0);
+            endPass(context, cmdBuffer);
+        });
+
+        graph.setOutput(backbuffer, frm::ResourceUsage::Present);
+        graph.compile();
+    }
+
+    // the render pass and framebuffer are only used without dynamic rendering, the view and load op only with it
+    void beginPass(frm::VulkanContext& context,
+                   VkCommandBuffer cmdBuffer,
+                   VkRenderPass renderPass,
+                   VkFramebuffer framebuffer,
+                   VkImageView view,
+                   VkAttachmentLoadOp loadOp)
+    {
+        VkViewport viewport{};
+
+        if (dynamicRendering) {
+            frm::RenderingAttachment attachment{};
+
+            attachment.view = view;
+            attachment.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            attachment.loadOp = loadOp;
+            attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+
+            context.cmdBeginRendering(cmdBuffer, viewRect, { attachment });
+        }
+        else {
+            VkRenderPassBeginInfo rpBegin{};
+
+            rpBegin.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            rpBegin.renderPass = renderPass;
+            rpBegin.framebuffer = framebuffer;
+            rpBegin.renderArea = viewRect;
+
+            vkCmdBeginRenderPass(cmdBuffer, &rpBegin, VK_SUBPASS_CONTENTS_INLINE);
+        }
+
+        viewport.width = static_cast<float>(viewRect.extent.width);
+        viewport.height = static_cast<float>(viewRect.extent.height);
+        viewport.maxDepth = 1.f;
+
+        vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(cmdBuffer, 0, 1, &viewRect);
+    }
+
+    void endPass(frm::VulkanContext& context, VkCommandBuffer cmdBuffer)
+    {
+        if (dynamicRendering) {
+            context.cmdEndRendering(cmdBuffer);
+        }
+        else {
+            vkCmdEndRenderPass(cmdBuffer);
+        }
+    }
+
+    void onRender(frm::VulkanContext& context, double dt) override
+    {
+        VkCommandBuffer cmdBuffer = context.getFrameCommandBuffer(); // reset by the context once this frame slot is free again
+        VkCommandBufferBeginInfo cmdBegin{};
+        VkSubmitInfo submitInfo{};
+        frm::SubmitTicket rampTicket = dispatchRamp(context);
+
+        buildGraph(context);
+
+        if (printStats) {
+            std::cout << "Render graph: " << graph.getCulledPassCount() << " pass(es) culled, " << graph.getBarrierCount() << " barrier(s)" << std::endl;
+            printStats = false;
+        }
+
+        cmdBegin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        cmdBegin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        vkBeginCommandBuffer(cmdBuffer, &cmdBegin);
+
+        {
+            FRM_GPU_SCOPE(context, cmdBuffer, "frame"); // passes plus the barriers between them
+            graph.execute(cmdBuffer);
+        }
+
+        vkEndCommandBuffer(cmdBuffer);
+
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &cmdBuffer;
+
+        // the semaphore wait also makes the compute writes visible to the composite's fragment shader
+        context.submitFrame(submitInfo, { { rampTicket, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT } });
+    }
+
+    void onSwapchainRecreated(frm::VulkanContext& context) override
+    {
+        // the scene image follows the window size, the frames using it have already finished
+        destroyFramebuffer(context);
+        destroySceneImage(context);
+        initSceneImage(context);
+        initFramebuffer(context);
+        printStats = true;
+    }
+
+    void onDestroy(frm::VulkanContext& context) override
+    {
+        VkDevice device = context.getDevice();
+
+        vkDestroyPipeline(device, scenePipeline, nullptr);
+        vkDestroyPipeline(device, compositePipeline, nullptr);
+        vkDestroyPipeline(device, rampPipeline, nullptr);
+
+        computeCmdAllocator.reset();
+        rampBuffers.clear();
+
+        destroyFramebuffer(context);
+        destroySceneImage(context);
+    }
+};
+
+int main(int argc, char** argv)
+{
+    return frm::App::run<RenderGraphExample>(640, 480, argc, argv);
+}
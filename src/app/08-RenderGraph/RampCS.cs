@@ -0,0 +1,29 @@
+#version 460
+
+layout(local_size_x = 64) in;
+
+layout(set = 0, binding = 0) writeonly buffer Ramp
+{
+    vec4 colors[];
+} ramp;
+
+layout(push_constant) uniform Params
+{
+    float time;
+    uint count;
+} params;
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+
+    if (i >= params.count) {
+        return;
+    }
+
+    // a slowly cycling tint that fades out towards the bottom of the screen
+    float t = float(i) / float(params.count - 1);
+    vec3 tint = 0.5 + 0.5 * cos(params.time * 0.5 + vec3(0.0, 2.0, 4.0));
+
+    ramp.colors[i] = vec4(mix(tint, vec3(1.0), t * 0.65 + 0.35), 1.0);
+}
@@ -0,0 +1,18 @@
+#version 460
+
+layout(push_constant) uniform pushConstant
+{
+    float angle;
+};
+
+vec2 pos[] = vec2[3](
+    vec2(0.5, 0.5),
+    vec2(-0.5, 0.5),
+    vec2(0.0, -0.5)
+);
+
+void main()
+{
+    mat2 rotation = mat2(cos(angle), sin(angle), -sin(angle), cos(angle));
+    gl_Position = vec4(rotation * pos[gl_VertexIndex], 0.5, 1.0);
+}
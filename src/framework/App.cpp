@@ -1,10 +1,24 @@
 #include <framework/App.h>
+#include <framework/GpuProfiler.h>
+#include <framework/CpuProfiler.h>
+#include <iomanip>
 
 namespace frm
 {
+    static double getElapsedMs(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
     App::App() :
         m_window(nullptr),
-        m_currentSwapbuffer(0)
+        m_currentSwapbuffer(0),
+        m_swapchainGeneration(0),
+        m_headless(false),
+        m_frameLimit(0),
+        m_warmupFrames(0),
+        m_initTime(0.0),
+        m_printStats(false)
     {
     }
     
@@ -14,11 +28,34 @@ namespace frm
             SDL_DestroyWindow(m_window);
         }
 
-        SDL_Quit();
+        // headless never initializes SDL
+        if (!m_headless) {
+            SDL_Quit();
+        }
     }
     
-    void App::init(int w, int h)
+    void App::init(int w, int h, uint32_t framesInFlight)
     {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        // started before the device so init and resource loading are in the trace too
+        if (!m_tracePath.empty()) {
+            m_cpuProfiler = std::make_unique<CpuProfiler>(m_trace);
+        }
+
+        FRM_CPU_THREAD_NAME("Main thread");
+        FRM_CPU_SCOPE("init");
+
+        if (m_headless) {
+            // no display, no SDL: the context renders into its virtual swapchain
+            m_vkCtx.initHeadlessDevice(static_cast<uint32_t>(w), static_cast<uint32_t>(h), framesInFlight);
+            m_swapchainGeneration = m_vkCtx.getSwapchainGeneration();
+            onInit(m_vkCtx);
+            m_initTime = getElapsedMs(start);
+
+            return;
+        }
+
         if (SDL_Init(SDL_INIT_EVERYTHING) != 0) {
             throw std::runtime_error("Cannot init SDL");
         }
@@ -28,19 +65,86 @@ namespace frm
                                     SDL_WINDOWPOS_CENTERED,
                                     w,
                                     h,
-                                    SDL_WINDOW_VULKAN);
+                                    SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
 
         if (m_window == nullptr) {
             throw std::runtime_error("Cannot create window");
         }
 
-        m_vkCtx.initDevice(m_window);
+        m_vkCtx.initDevice(m_window, framesInFlight);
+        m_swapchainGeneration = m_vkCtx.getSwapchainGeneration();
         onInit(m_vkCtx);
+        m_initTime = getElapsedMs(start);
+    }
+
+    void App::parseArgs(int argc, char** argv)
+    {
+        // the environment variables let scripts switch every sample over without touching their command lines
+        m_headless = getEnvFlag("VKL_HEADLESS");
+        m_vkCtx.enableValidation(getEnvFlag("VKL_VALIDATION"));
+
+        m_args.assign(argv + std::min(argc, 1), argv + argc);
+
+        if (argc > 0) {
+            m_appName = argv[0];
+            m_appName = m_appName.substr(m_appName.find_last_of("/\\") + 1);
+            m_appName = m_appName.substr(0, m_appName.rfind(".exe"));
+        }
+
+        for (int i = 1; i < argc; i++) {
+            if (std::strcmp(argv[i], "--headless") == 0) {
+                m_headless = true;
+            }
+            else if (std::strcmp(argv[i], "--validation") == 0) {
+                m_vkCtx.enableValidation(true);
+            }
+            else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+                m_frameLimit = std::strtoull(argv[++i], nullptr, 10);
+            }
+            else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+                m_tracePath = argv[++i];
+            }
+            else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+                m_warmupFrames = std::strtoull(argv[++i], nullptr, 10);
+            }
+            else if (std::strcmp(argv[i], "--bench-out") == 0 && i + 1 < argc) {
+                m_benchPath = argv[++i];
+            }
+            else if (std::strcmp(argv[i], "--memory-stats") == 0 && i + 1 < argc) {
+                m_memoryStatsPath = argv[++i];
+            }
+            else if (std::strcmp(argv[i], "--stats") == 0) {
+                m_printStats = true;
+            }
+            else if (std::strcmp(argv[i], "--stats-out") == 0 && i + 1 < argc) {
+                if (!m_frameStats.openStream(argv[++i])) {
+                    std::cout << "Cannot open " << argv[i] << " for frame stats" << std::endl;
+                }
+            }
+        }
+
+        // with a frame limit the percentiles cover every measured frame, not only the last ones
+        if (m_frameLimit != 0) {
+            m_frameStats.setWindowSize(static_cast<uint32_t>(std::min<uint64_t>(m_frameLimit, FrameStats::g_maxWindowSize)));
+        }
+
+#ifdef VKL_PROFILING
+        m_vkCtx.enableGpuProfiling(!m_tracePath.empty());
+#else
+        if (!m_tracePath.empty()) {
+            std::cout << "--trace ignored, built without VKL_PROFILING" << std::endl;
+            m_tracePath.clear();
+        }
+#endif
     }
 
     void App::dispatch()
     {
         auto currentTime = std::chrono::high_resolution_clock::now();
+        uint64_t frameCount = 0;
+        uint64_t submitCount = m_vkCtx.getSubmitCount();
+        bool measuring = false;
+        bool minimized = false;
         bool run = true;
 
         while (run) {
@@ -48,22 +152,90 @@ namespace frm
             auto newTime = std::chrono::high_resolution_clock::now();
             double dt = std::chrono::duration<double>(newTime - currentTime).count();
 
-            while (SDL_PollEvent(&event)) {
+            // warm-up frames (pipeline creation, first uploads, driver caches) don't count
+            if (!measuring && frameCount >= m_warmupFrames) {
+                m_frameStats.reset();
+                submitCount = m_vkCtx.getSubmitCount();
+                measuring = true;
+            }
+
+            // Nothing can be rendered while the window is minimized, sleep until it's restored or resized
+            // instead of spinning through empty frames. The remaining events are polled as usual.
+            while (m_window != nullptr && (minimized ? SDL_WaitEvent(&event) : SDL_PollEvent(&event))) {
                 switch (event.type) {
                     case SDL_QUIT:
                         run = false;
+                        minimized = false;
+                        break;
+                    case SDL_WINDOWEVENT:
+                        if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+                            m_vkCtx.invalidateSwapchain();
+                        }
+
+                        if (event.window.event == SDL_WINDOWEVENT_RESTORED || event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+                            minimized = false;
+                        }
+                        break;
                 }
             }
 
-            onUpdate(m_vkCtx, dt);
+            double submitTime = m_vkCtx.getSubmitTime();
+            FrameSample sample{};
+            bool rendered;
+
+            {
+                FRM_CPU_SCOPE("onUpdate");
+                onUpdate(m_vkCtx, dt);
+            }
 
-            m_vkCtx.prepareNextSwapbuffer(m_currentSwapbuffer);
-            onRender(m_vkCtx, dt);
-            m_vkCtx.present(m_currentSwapbuffer);
+            // skipped while the window is minimized or the swapchain is out of date
+            auto prepareStart = std::chrono::high_resolution_clock::now();
+            rendered = m_vkCtx.prepareNextSwapbuffer(m_currentSwapbuffer);
+            sample.times[static_cast<size_t>(FrameMetric::PrepareWait)] = getElapsedMs(prepareStart);
+            minimized = !rendered && m_vkCtx.isMinimized();
+
+            if (rendered) {
+                if (m_swapchainGeneration != m_vkCtx.getSwapchainGeneration()) {
+                    FRM_CPU_SCOPE("onSwapchainRecreated");
+                    m_swapchainGeneration = m_vkCtx.getSwapchainGeneration();
+                    onSwapchainRecreated(m_vkCtx);
+                }
+
+                {
+                    FRM_CPU_SCOPE("onRender");
+                    onRender(m_vkCtx, dt);
+                }
+
+                auto presentStart = std::chrono::high_resolution_clock::now();
+                m_vkCtx.present(m_currentSwapbuffer);
+                sample.times[static_cast<size_t>(FrameMetric::Present)] = getElapsedMs(presentStart);
+
+                sample.times[static_cast<size_t>(FrameMetric::SubmitWait)] = (m_vkCtx.getSubmitTime() - submitTime) * 1000.0;
+                sample.times[static_cast<size_t>(FrameMetric::CpuFrame)] = getElapsedMs(newTime);
+                m_frameStats.addFrame(sample);
+                frameCount++;
+            }
+
+            if (m_frameLimit != 0 && frameCount >= m_warmupFrames + m_frameLimit) {
+                run = false;
+            }
 
             currentTime = newTime;
         }
 
+        // frames may still be in flight, don't let the app destroy resources the GPU is using
+        m_vkCtx.waitIdle();
+        writeTrace();
+        writeBenchResults(m_vkCtx.getSubmitCount() - submitCount);
+        writeMemoryStats();
+        m_frameStats.closeStream();
+
+        if (m_printStats) {
+            m_frameStats.print(std::cout);
+            printMemoryStats();
+            printPipelineStats();
+        }
+
         onDestroy(m_vkCtx);
     }
 
@@ -75,21 +247,189 @@ namespace frm
     {
     }
 
+    void App::onSwapchainRecreated(VulkanContext& context)
+    {
+    }
+
     void App::onGuiRender()
     {
     }
 
-    void App::getClientSizeRect(VkRect2D& rect)
+    bool App::hasArg(const char* name) const
+    {
+        return std::find(m_args.begin(), m_args.end(), name) != m_args.end();
+    }
+
+    const char* App::getArgValue(const char* name) const
+    {
+        auto it = std::find(m_args.begin(), m_args.end(), name);
+
+        if (it == m_args.end() || it + 1 == m_args.end()) {
+            return nullptr;
+        }
+
+        return (it + 1)->c_str();
+    }
+
+    void App::writeTrace()
+    {
+        GpuProfiler* gpuProfiler = m_vkCtx.getGpuProfiler();
+
+        if (m_tracePath.empty()) {
+            return;
+        }
+
+        // stops the collector, the worker threads are idle by now
+        m_cpuProfiler.reset();
+
+        // the device is idle, the frames the context hasn't come around to yet can be read back too
+        if (gpuProfiler != nullptr) {
+            gpuProfiler->resolveAll();
+            gpuProfiler->exportTrace(m_trace);
+        }
+
+        if (!m_trace.write(m_tracePath)) {
+            std::cout << "Cannot write trace to " << m_tracePath << std::endl;
+            return;
+        }
+
+        std::cout << "Trace written to " << m_tracePath << " (" << m_trace.getEventCount() << " events";
+
+        if (m_trace.getDroppedCount() > 0) {
+            std::cout << ", " << m_trace.getDroppedCount() << " dropped past the limit";
+        }
+
+        std::cout << ")" << std::endl;
+    }
+
+    void App::writeBenchResults(uint64_t submitCount)
     {
-        int w, h;
+        std::ofstream file;
+        uint64_t frameCount = m_frameStats.getFrameCount();
+
+        if (m_benchPath.empty()) {
+            return;
+        }
+
+        file.open(m_benchPath, std::ios::out | std::ios::trunc);
+
+        if (!file.is_open()) {
+            std::cout << "Cannot write benchmark results to " << m_benchPath << std::endl;
+            return;
+        }
 
-        assert(m_window != nullptr);
+        // fixed notation, the bench script compares the numbers without floating point support
+        file << std::fixed << std::setprecision(4);
+        file << "{\n";
+        file << "  \"app\": ";
+        TraceWriter::writeString(file, m_appName.c_str());
+        file << ",\n  \"device\": ";
+        TraceWriter::writeString(file, m_vkCtx.getDeviceProperties().deviceName);
+        file << ",\n";
+        file << "  \"headless\": " << (m_headless ? "true" : "false") << ",\n";
+        file << "  \"init_ms\": " << m_initTime << ",\n";
+        file << "  \"warmup_frames\": " << m_warmupFrames << ",\n";
+        file << "  \"frames\": " << frameCount << ",\n";
+        file << "  \"window_frames\": " << m_frameStats.getWindowFrameCount() << ",\n"; // what the metrics percentiles cover
+        file << "  \"submits\": " << submitCount << ",\n";
+        file << "  \"submits_per_frame\": " << (frameCount > 0 ? static_cast<double>(submitCount) / frameCount : 0.0) << ",\n";
+        file << "  \"allocated_bytes\": " << m_vkCtx.getAllocatedBytes() << ",\n";
+        file << "  \"pipelines\": {\"count\": " << m_vkCtx.getPipelineCreateCount()
+             << ", \"create_ms\": " << m_vkCtx.getPipelineCreateTime() * 1000.0
+             << ", \"batch_ms\": " << m_vkCtx.getPipelineBatchTime() * 1000.0 << "},\n";
+        file << "  \"memory\": {";
 
-        SDL_GetWindowSize(m_window, &w, &h);
+        for (size_t i = 0; i < static_cast<size_t>(MemoryCategory::Count); i++) {
+            MemoryCategory category = static_cast<MemoryCategory>(i);
 
+            file << (i == 0 ? "" : ", ") << "\"" << VulkanContext::getMemoryCategoryName(category) << "\": " << m_vkCtx.getCategoryBytes(category);
+        }
+
+        file << "},\n";
+        file << "  \"metrics\": {";
+
+        for (size_t i = 0; i < static_cast<size_t>(FrameMetric::Count); i++) {
+            FrameSummary summary = m_frameStats.getSummary(static_cast<FrameMetric>(i));
+
+            file << (i == 0 ? "\n" : ",\n")
+                 << "    \"" << FrameStats::getMetricName(static_cast<FrameMetric>(i)) << "\": {"
+                 << "\"mean\": " << summary.mean
+                 << ", \"p50\": " << summary.p50
+                 << ", \"p95\": " << summary.p95
+                 << ", \"p99\": " << summary.p99
+                 << ", \"max\": " << summary.max << "}";
+        }
+
+        file << "\n  }\n}\n";
+    }
+
+    void App::writeMemoryStats()
+    {
+        if (m_memoryStatsPath.empty()) {
+            return;
+        }
+
+        if (!m_vkCtx.writeMemoryStats(m_memoryStatsPath)) {
+            std::cout << "Cannot write memory stats to " << m_memoryStatsPath << std::endl;
+            return;
+        }
+
+        std::cout << "Memory stats written to " << m_memoryStatsPath << std::endl;
+    }
+
+    void App::printPipelineStats()
+    {
+        std::ios::fmtflags flags = std::cout.flags();
+
+        // create time is summed over the worker threads, batch time is the wall clock the batches took
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "Pipelines: " << m_vkCtx.getPipelineCreateCount() << " created, " << m_vkCtx.getPipelineCreateTime() * 1000.0
+                  << " ms create time, " << m_vkCtx.getPipelineBatchTime() * 1000.0 << " ms in parallel batches" << std::endl;
+        std::cout.flags(flags);
+    }
+
+    void App::printMemoryStats()
+    {
+        std::vector<HeapBudget> budgets;
+        std::ios::fmtflags flags = std::cout.flags();
+        auto toMiB = [](VkDeviceSize bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+
+        m_vkCtx.getHeapBudgets(budgets);
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "Memory heaps (MiB, budget " << (m_vkCtx.getFeatures().memoryBudget ? "from VK_EXT_memory_budget" : "estimated") << ")" << std::endl;
+
+        for (size_t i = 0; i < budgets.size(); i++) {
+            std::cout << "  heap " << i << ((budgets[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? " (device)" : " (host)")
+                      << ": usage " << toMiB(budgets[i].usage) << " / budget " << toMiB(budgets[i].budget)
+                      << ", blocks " << toMiB(budgets[i].blockBytes) << ", allocations " << toMiB(budgets[i].allocationBytes)
+                      << ", size " << toMiB(budgets[i].size) << std::endl;
+        }
+
+        std::cout << "Resources (MiB):";
+
+        for (size_t i = 0; i < static_cast<size_t>(MemoryCategory::Count); i++) {
+            MemoryCategory category = static_cast<MemoryCategory>(i);
+
+            std::cout << " " << VulkanContext::getMemoryCategoryName(category) << " " << toMiB(m_vkCtx.getCategoryBytes(category));
+        }
+
+        std::cout << std::endl;
+        std::cout.flags(flags);
+    }
+
+    bool App::getEnvFlag(const char* name)
+    {
+        const char* value = std::getenv(name);
+
+        return value != nullptr && value[0] != '\0' && std::strcmp(value, "0") != 0;
+    }
+
+    void App::getClientSizeRect(VkRect2D& rect)
+    {
+        // the swapchain extent, not the window size: they differ on high-DPI displays and
+        // while a resize has not been picked up by the swapchain yet
         rect.offset.x = 0;
         rect.offset.y = 0;
-        rect.extent.width = static_cast<uint32_t>(w);
-        rect.extent.height = static_cast<uint32_t>(h);
+        rect.extent = m_vkCtx.getSwapchainExtent();
     }
 }
@@ -0,0 +1,233 @@
+#include <framework/BindlessTable.h>
+
+namespace frm
+{
+    const uint32_t BindlessTable::g_invalidIndex;
+    const uint32_t BindlessTable::g_maxImages;
+    const uint32_t BindlessTable::g_maxSamplers;
+
+    BindlessTable::BindlessTable(VulkanContext& context) :
+        m_context(context),
+        m_setLayout(nullptr),
+        m_pool(nullptr),
+        m_set(nullptr),
+        m_imageCapacity(0),
+        m_samplerCapacity(0)
+    {
+        VkDevice device = m_context.getDevice();
+        VkPhysicalDeviceProperties2 properties{};
+        VkPhysicalDeviceVulkan12Properties properties12{};
+        VkDescriptorSetLayoutBinding bindings[2] = {};
+        VkDescriptorBindingFlags bindingFlags[2] = {};
+        VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+        VkDescriptorSetLayoutCreateInfo setLayoutInfo{};
+        VkDescriptorPoolSize poolSizes[2] = {};
+        VkDescriptorPoolCreateInfo poolInfo{};
+        VkDescriptorSetAllocateInfo allocInfo{};
+
+        // update-after-bind descriptors have their own (much higher) limits
+        properties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties.pNext = &properties12;
+        vkGetPhysicalDeviceProperties2(m_context.getPhysicalDevice(), &properties);
+
+        m_samplerCapacity = std::min({ g_maxSamplers,
+                                       properties12.maxDescriptorSetUpdateAfterBindSamplers,
+                                       properties12.maxPerStageDescriptorUpdateAfterBindSamplers });
+        // the samplers count against the per-stage resource limit as well, some devices report a limit below our sampler count
+        m_imageCapacity = std::min({ g_maxImages,
+                                     properties12.maxDescriptorSetUpdateAfterBindSampledImages,
+                                     properties12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                                     properties12.maxPerStageUpdateAfterBindResources - std::min(m_samplerCapacity, properties12.maxPerStageUpdateAfterBindResources) });
+
+        bindings[0].binding = 0;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        bindings[0].descriptorCount = m_imageCapacity;
+        bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+
+        bindings[1].binding = 1;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+        bindings[1].descriptorCount = m_samplerCapacity;
+        bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+        // unused entries may be left unwritten, and writing an entry no pending command uses is fine
+        for (auto& flags : bindingFlags) {
+            flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                    VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                    VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+        }
+
+        bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        bindingFlagsInfo.bindingCount = 2;
+        bindingFlagsInfo.pBindingFlags = bindingFlags;
+
+        setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        setLayoutInfo.pNext = &bindingFlagsInfo;
+        setLayoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        setLayoutInfo.bindingCount = 2;
+        setLayoutInfo.pBindings = bindings;
+
+        // not from the object cache, it doesn't take pNext chains
+        if (VK_FAILED(vkCreateDescriptorSetLayout(device, &setLayoutInfo, nullptr, &m_setLayout))) {
+            throw std::runtime_error("Cannot create bindless descriptor set layout");
+        }
+
+        poolSizes[0].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        poolSizes[0].descriptorCount = m_imageCapacity;
+        poolSizes[1].type = VK_DESCRIPTOR_TYPE_SAMPLER;
+        poolSizes[1].descriptorCount = m_samplerCapacity;
+
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+        poolInfo.maxSets = 1;
+        poolInfo.poolSizeCount = 2;
+        poolInfo.pPoolSizes = poolSizes;
+
+        m_context.createDescriptorPool(poolInfo, &m_pool);
+
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = m_pool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &m_setLayout;
+
+        if (VK_FAILED(vkAllocateDescriptorSets(device, &allocInfo, &m_set))) {
+            throw std::runtime_error("Cannot allocate bindless descriptor set");
+        }
+
+        std::cout << "Bindless table: " << m_imageCapacity << " images, " << m_samplerCapacity << " samplers" << std::endl;
+    }
+
+    BindlessTable::~BindlessTable()
+    {
+        VkDevice device = m_context.getDevice();
+
+        for (auto& slot : m_images) {
+            if (slot.ownsView && slot.view != nullptr) {
+                vkDestroyImageView(device, slot.view, nullptr);
+            }
+        }
+
+        vkDestroyDescriptorPool(device, m_pool, nullptr);
+        vkDestroyDescriptorSetLayout(device, m_setLayout, nullptr);
+    }
+
+    uint32_t BindlessTable::addImage(VkImageView imageView, VkImageLayout layout, bool ownsView)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        VkDescriptorImageInfo imageInfo{};
+        VkWriteDescriptorSet write{};
+        uint32_t index;
+
+        if (!m_freeImages.empty()) {
+            index = m_freeImages.back();
+            m_freeImages.pop_back();
+        }
+        else if (m_images.size() < m_imageCapacity) {
+            index = static_cast<uint32_t>(m_images.size());
+            m_images.push_back({});
+        }
+        else {
+            throw std::runtime_error("Cannot add image, the bindless table is full");
+        }
+
+        m_images[index] = { imageView, ownsView };
+
+        imageInfo.imageView = imageView;
+        imageInfo.imageLayout = layout;
+
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = m_set;
+        write.dstBinding = 0;
+        write.dstArrayElement = index;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        write.pImageInfo = &imageInfo;
+
+        vkUpdateDescriptorSets(m_context.getDevice(), 1, &write, 0, nullptr);
+
+        return index;
+    }
+
+    void BindlessTable::removeImage(uint32_t index)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        RetiredSlot retiredSlot{};
+
+        // work recorded with the slot has been submitted by now, it's done once the queues get past this point
+        retiredSlot.index = index;
+
+        for (size_t i = 0; i < static_cast<size_t>(QueueType::Count); i++) {
+            retiredSlot.lastSubmits[i] = m_context.getLastSubmit(static_cast<QueueType>(i));
+        }
+
+        m_retiredImages.push_back(retiredSlot);
+    }
+
+    uint32_t BindlessTable::addSampler(VkSampler sampler)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        VkDescriptorImageInfo samplerInfo{};
+        VkWriteDescriptorSet write{};
+        auto it = m_samplers.find(sampler);
+        uint32_t index;
+
+        if (it != m_samplers.end()) {
+            return it->second;
+        }
+
+        if (m_samplers.size() >= m_samplerCapacity) {
+            throw std::runtime_error("Cannot add sampler, the bindless table is full");
+        }
+
+        index = static_cast<uint32_t>(m_samplers.size());
+        m_samplers[sampler] = index;
+
+        samplerInfo.sampler = sampler;
+
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = m_set;
+        write.dstBinding = 1;
+        write.dstArrayElement = index;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+        write.pImageInfo = &samplerInfo;
+
+        vkUpdateDescriptorSets(m_context.getDevice(), 1, &write, 0, nullptr);
+
+        return index;
+    }
+
+    void BindlessTable::nextFrame()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        VkDevice device = m_context.getDevice();
+        size_t retiredCount = 0;
+
+        // The tickets only grow with the removal order, the first slot the GPU isn't done with ends the search
+        for (auto& retiredSlot : m_retiredImages) {
+            ImageSlot& slot = m_images[retiredSlot.index];
+            bool complete = std::all_of(std::begin(retiredSlot.lastSubmits), std::end(retiredSlot.lastSubmits), [this](const SubmitTicket& ticket) {
+                return m_context.isComplete(ticket);
+            });
+
+            if (!complete) {
+                break;
+            }
+
+            if (slot.ownsView) {
+                vkDestroyImageView(device, slot.view, nullptr);
+            }
+
+            slot = {};
+            m_freeImages.push_back(retiredSlot.index);
+            retiredCount++;
+        }
+
+        m_retiredImages.erase(m_retiredImages.begin(), m_retiredImages.begin() + retiredCount);
+    }
+
+    void BindlessTable::bind(VkCommandBuffer cmdBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, uint32_t set) const
+    {
+        vkCmdBindDescriptorSets(cmdBuffer, bindPoint, pipelineLayout, set, 1, &m_set, 0, nullptr);
+    }
+}
@@ -0,0 +1,97 @@
+#include <framework/Capabilities.h>
+
+namespace frm
+{
+    void Capabilities::queryInstance()
+    {
+        uint32_t count;
+        std::vector<VkLayerProperties> layers;
+        std::vector<VkExtensionProperties> extensions;
+
+        vkEnumerateInstanceLayerProperties(&count, nullptr);
+        layers.resize(count);
+        vkEnumerateInstanceLayerProperties(&count, layers.data());
+
+        vkEnumerateInstanceExtensionProperties(nullptr, &count, nullptr);
+        extensions.resize(count);
+        vkEnumerateInstanceExtensionProperties(nullptr, &count, extensions.data());
+
+        m_availableLayers.clear();
+        m_availableInstanceExtensions.clear();
+
+        for (auto& layer : layers) {
+            m_availableLayers.push_back(layer.layerName);
+        }
+
+        for (auto& ext : extensions) {
+            m_availableInstanceExtensions.push_back(ext.extensionName);
+        }
+    }
+
+    void Capabilities::queryDevice(VkPhysicalDevice physicalDevice)
+    {
+        uint32_t count;
+        std::vector<VkExtensionProperties> extensions;
+
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &count, nullptr);
+        extensions.resize(count);
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &count, extensions.data());
+
+        m_availableDeviceExtensions.clear();
+        m_enabledDeviceExtensions.clear();
+
+        for (auto& ext : extensions) {
+            m_availableDeviceExtensions.push_back(ext.extensionName);
+        }
+    }
+
+    bool Capabilities::requestLayer(const char* name, bool required)
+    {
+        return request(m_availableLayers, m_enabledLayers, name, required, "layer");
+    }
+
+    bool Capabilities::requestInstanceExtension(const char* name, bool required)
+    {
+        return request(m_availableInstanceExtensions, m_enabledInstanceExtensions, name, required, "instance extension");
+    }
+
+    bool Capabilities::requestDeviceExtension(const char* name, bool required)
+    {
+        return request(m_availableDeviceExtensions, m_enabledDeviceExtensions, name, required, "device extension");
+    }
+
+    bool Capabilities::request(const std::vector<std::string>& available,
+                               std::vector<std::string>& enabled,
+                               const char* name,
+                               bool required,
+                               const char* kind)
+    {
+        if (!contains(available, name)) {
+            if (required) {
+                throw std::runtime_error(std::string("Cannot find required ") + kind + " " + name);
+            }
+
+            return false;
+        }
+
+        if (!contains(enabled, name)) {
+            enabled.push_back(name);
+        }
+
+        return true;
+    }
+
+    bool Capabilities::contains(const std::vector<std::string>& list, const char* name)
+    {
+        return std::find(list.begin(), list.end(), name) != list.end();
+    }
+
+    void Capabilities::getNames(const std::vector<std::string>& list, std::vector<const char*>& names)
+    {
+        names.clear();
+
+        for (auto& name : list) {
+            names.push_back(name.c_str());
+        }
+    }
+}
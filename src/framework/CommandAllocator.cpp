@@ -0,0 +1,94 @@
+#include <framework/CommandAllocator.h>
+
+namespace frm
+{
+    CommandAllocator::CommandAllocator(VulkanContext& context, uint32_t framesInFlight, QueueType queue) :
+        m_context(context),
+        m_queue(queue),
+        m_framesInFlight(framesInFlight),
+        m_frameIndex(0)
+    {
+    }
+
+    CommandAllocator::~CommandAllocator()
+    {
+        VkDevice device = m_context.getDevice();
+
+        for (auto& [id, threadPools] : m_threads) {
+            for (auto& frame : threadPools->frames) {
+                vkDestroyCommandPool(device, frame.pool, nullptr); // frees its buffers too
+            }
+        }
+    }
+
+    VkCommandBuffer CommandAllocator::allocate(VkCommandBufferLevel level)
+    {
+        FramePool& frame = getThreadPools().frames[m_frameIndex];
+        size_t levelIndex = level == VK_COMMAND_BUFFER_LEVEL_PRIMARY ? 0 : 1;
+        std::vector<VkCommandBuffer>& buffers = frame.buffers[levelIndex];
+        uint32_t& used = frame.used[levelIndex];
+
+        // only grows the first time a frame needs this many buffers
+        if (used == buffers.size()) {
+            VkCommandBufferAllocateInfo cmdBufferInfo{};
+            VkCommandBuffer cmdBuffer;
+
+            cmdBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            cmdBufferInfo.commandPool = frame.pool;
+            cmdBufferInfo.level = level;
+            cmdBufferInfo.commandBufferCount = 1;
+
+            if (VK_FAILED(vkAllocateCommandBuffers(m_context.getDevice(), &cmdBufferInfo, &cmdBuffer))) {
+                throw std::runtime_error("Cannot allocate command buffer");
+            }
+
+            buffers.push_back(cmdBuffer);
+        }
+
+        return buffers[used++];
+    }
+
+    void CommandAllocator::beginFrame(uint32_t frameIndex)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        VkDevice device = m_context.getDevice();
+
+        m_frameIndex = frameIndex;
+
+        for (auto& [id, threadPools] : m_threads) {
+            FramePool& frame = threadPools->frames[frameIndex];
+
+            if (frame.used[0] == 0 && frame.used[1] == 0) {
+                continue; // this thread didn't record anything in that frame
+            }
+
+            vkResetCommandPool(device, frame.pool, 0);
+            frame.used[0] = 0;
+            frame.used[1] = 0;
+        }
+    }
+
+    uint32_t CommandAllocator::getThreadCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return static_cast<uint32_t>(m_threads.size());
+    }
+
+    CommandAllocator::ThreadPools& CommandAllocator::getThreadPools()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::unique_ptr<ThreadPools>& threadPools = m_threads[std::this_thread::get_id()];
+
+        // first allocation from this thread, give it a pool for every frame slot
+        if (!threadPools) {
+            threadPools = std::make_unique<ThreadPools>();
+            threadPools->frames.resize(m_framesInFlight);
+
+            for (auto& frame : threadPools->frames) {
+                m_context.createCommandPool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, &frame.pool, m_queue);
+            }
+        }
+
+        return *threadPools;
+    }
+}
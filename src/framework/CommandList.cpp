@@ -0,0 +1,144 @@
+#include <framework/CommandList.h>
+
+namespace frm
+{
+    CommandList::CommandList(const VulkanContext& context, VkCommandBuffer cmdBuffer) :
+        m_context(context),
+        m_cmdBuffer(cmdBuffer)
+    {
+    }
+
+    void CommandList::resetDynamicState(const VkRect2D& renderArea, uint32_t colorAttachmentCount)
+    {
+        const DeviceFeatures& features = m_context.getFeatures();
+
+        setViewport(renderArea);
+        setScissor(renderArea);
+
+        // the same defaults a zero-initialized create info gives, with triangles and no culling
+        if (features.extendedDynamicState) {
+            setCullMode(VK_CULL_MODE_NONE);
+            setFrontFace(VK_FRONT_FACE_COUNTER_CLOCKWISE);
+            setPrimitiveTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+            setDepthTestEnable(false);
+            setDepthWriteEnable(false);
+            setDepthCompareOp(VK_COMPARE_OP_LESS_OR_EQUAL);
+            setStencilTestEnable(false);
+        }
+
+        if (features.extendedDynamicState2) {
+            setRasterizerDiscardEnable(false);
+            setDepthBiasEnable(false);
+            setPrimitiveRestartEnable(false);
+        }
+
+        if (features.extendedDynamicState3) {
+            setPolygonMode(VK_POLYGON_MODE_FILL);
+
+            for (uint32_t i = 0; i < colorAttachmentCount; i++) {
+                setColorBlendEnable(i, false);
+                setColorWriteMask(i, VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT);
+            }
+        }
+    }
+
+    void CommandList::setViewport(const VkViewport& viewport)
+    {
+        vkCmdSetViewport(m_cmdBuffer, 0, 1, &viewport);
+    }
+
+    void CommandList::setViewport(const VkRect2D& rect)
+    {
+        VkViewport viewport{};
+
+        viewport.x = static_cast<float>(rect.offset.x);
+        viewport.y = static_cast<float>(rect.offset.y);
+        viewport.width = static_cast<float>(rect.extent.width);
+        viewport.height = static_cast<float>(rect.extent.height);
+        viewport.maxDepth = 1.f;
+
+        setViewport(viewport);
+    }
+
+    void CommandList::setScissor(const VkRect2D& scissor)
+    {
+        vkCmdSetScissor(m_cmdBuffer, 0, 1, &scissor);
+    }
+
+    void CommandList::setCullMode(VkCullModeFlags cullMode)
+    {
+        require(m_context.getFunctions().cmdSetCullMode, "cull mode")(m_cmdBuffer, cullMode);
+    }
+
+    void CommandList::setFrontFace(VkFrontFace frontFace)
+    {
+        require(m_context.getFunctions().cmdSetFrontFace, "front face")(m_cmdBuffer, frontFace);
+    }
+
+    void CommandList::setPrimitiveTopology(VkPrimitiveTopology topology)
+    {
+        require(m_context.getFunctions().cmdSetPrimitiveTopology, "primitive topology")(m_cmdBuffer, topology);
+    }
+
+    void CommandList::setDepthTestEnable(bool enable)
+    {
+        require(m_context.getFunctions().cmdSetDepthTestEnable, "depth test")(m_cmdBuffer, enable ? VK_TRUE : VK_FALSE);
+    }
+
+    void CommandList::setDepthWriteEnable(bool enable)
+    {
+        require(m_context.getFunctions().cmdSetDepthWriteEnable, "depth write")(m_cmdBuffer, enable ? VK_TRUE : VK_FALSE);
+    }
+
+    void CommandList::setDepthCompareOp(VkCompareOp compareOp)
+    {
+        require(m_context.getFunctions().cmdSetDepthCompareOp, "depth compare op")(m_cmdBuffer, compareOp);
+    }
+
+    void CommandList::setStencilTestEnable(bool enable)
+    {
+        require(m_context.getFunctions().cmdSetStencilTestEnable, "stencil test")(m_cmdBuffer, enable ? VK_TRUE : VK_FALSE);
+    }
+
+    void CommandList::setRasterizerDiscardEnable(bool enable)
+    {
+        require(m_context.getFunctions().cmdSetRasterizerDiscardEnable, "rasterizer discard")(m_cmdBuffer, enable ? VK_TRUE : VK_FALSE);
+    }
+
+    void CommandList::setDepthBiasEnable(bool enable)
+    {
+        require(m_context.getFunctions().cmdSetDepthBiasEnable, "depth bias")(m_cmdBuffer, enable ? VK_TRUE : VK_FALSE);
+    }
+
+    void CommandList::setPrimitiveRestartEnable(bool enable)
+    {
+        require(m_context.getFunctions().cmdSetPrimitiveRestartEnable, "primitive restart")(m_cmdBuffer, enable ? VK_TRUE : VK_FALSE);
+    }
+
+    void CommandList::setPolygonMode(VkPolygonMode polygonMode)
+    {
+        require(m_context.getFunctions().cmdSetPolygonMode, "polygon mode")(m_cmdBuffer, polygonMode);
+    }
+
+    void CommandList::setColorBlendEnable(uint32_t attachment, bool enable)
+    {
+        VkBool32 value = enable ? VK_TRUE : VK_FALSE;
+
+        require(m_context.getFunctions().cmdSetColorBlendEnable, "color blend enable")(m_cmdBuffer, attachment, 1, &value);
+    }
+
+    void CommandList::setColorWriteMask(uint32_t attachment, VkColorComponentFlags writeMask)
+    {
+        require(m_context.getFunctions().cmdSetColorWriteMask, "color write mask")(m_cmdBuffer, attachment, 1, &writeMask);
+    }
+
+    template<class Fn>
+    Fn CommandList::require(Fn fn, const char* name)
+    {
+        if (fn == nullptr) {
+            throw std::runtime_error(std::string("Cannot set ") + name + ", the extended dynamic state is not enabled");
+        }
+
+        return fn;
+    }
+}
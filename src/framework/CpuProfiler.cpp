@@ -0,0 +1,234 @@
+#include <framework/CpuProfiler.h>
+
+namespace frm
+{
+    namespace
+    {
+        thread_local const char* g_threadName = nullptr;
+    }
+
+    std::atomic<CpuProfiler*> CpuProfiler::g_active(nullptr);
+    std::atomic<uint32_t> CpuProfiler::g_generation(0);
+
+    CpuProfiler::CpuProfiler(TraceWriter& trace, uint32_t recordsPerThread) :
+        m_trace(trace),
+        m_ringSize(1),
+        m_generation(++g_generation),
+        m_stop(false)
+    {
+        CpuProfiler* expected = nullptr;
+
+        while (m_ringSize < recordsPerThread) {
+            m_ringSize *= 2;
+        }
+
+        if (!g_active.compare_exchange_strong(expected, this, std::memory_order_acq_rel)) {
+            throw std::runtime_error("Cannot create a second CPU profiler");
+        }
+
+        m_collector = std::thread(&CpuProfiler::collectorLoop, this);
+    }
+
+    CpuProfiler::~CpuProfiler()
+    {
+        uint32_t droppedCount;
+
+        g_active.store(nullptr, std::memory_order_release);
+
+        {
+            std::lock_guard<std::mutex> lock(m_stopMutex);
+            m_stop = true;
+        }
+
+        m_stopCondition.notify_one();
+        m_collector.join();
+
+        collect(); // scopes still open now are never closed and don't show up
+        droppedCount = getDroppedCount();
+
+        if (droppedCount > 0) {
+            std::cout << "CPU profiler: " << droppedCount << " scopes dropped" << std::endl;
+        }
+    }
+
+    uint32_t CpuProfiler::getDroppedCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_buffersMutex);
+        uint32_t droppedCount = 0;
+
+        for (auto& buffer : m_buffers) {
+            droppedCount += buffer->droppedCount.load(std::memory_order_relaxed);
+        }
+
+        return droppedCount;
+    }
+
+    bool CpuProfiler::begin(const char* name)
+    {
+        CpuProfiler* profiler = g_active.load(std::memory_order_acquire);
+        ThreadBuffer* buffer;
+        uint64_t used;
+
+        if (profiler == nullptr) {
+            return false;
+        }
+
+        buffer = getThreadBuffer(profiler);
+        buffer->depth++;
+
+        // nested in a dropped scope, its end record can't be matched either
+        if (buffer->skipDepth != ~0u) {
+            buffer->droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // room for this begin and the end of every open scope, so ends never have to be dropped
+        used = buffer->head.load(std::memory_order_relaxed) - buffer->tail.load(std::memory_order_acquire);
+
+        if (profiler->m_ringSize - used < buffer->openCount + 2) {
+            buffer->skipDepth = buffer->depth;
+            buffer->droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        push(*buffer, { name, TraceWriter::now() });
+        buffer->openCount++;
+
+        return true;
+    }
+
+    void CpuProfiler::end()
+    {
+        CpuProfiler* profiler = g_active.load(std::memory_order_acquire);
+        ThreadBuffer* buffer;
+
+        if (profiler == nullptr) {
+            return;
+        }
+
+        buffer = getThreadBuffer(profiler);
+
+        if (buffer->depth == 0) {
+            return; // begun before this profiler existed
+        }
+
+        if (buffer->skipDepth != ~0u) {
+            if (buffer->depth == buffer->skipDepth) {
+                buffer->skipDepth = ~0u;
+            }
+
+            buffer->depth--;
+            return;
+        }
+
+        push(*buffer, { nullptr, TraceWriter::now() });
+        buffer->openCount--;
+        buffer->depth--;
+    }
+
+    void CpuProfiler::setThreadName(const char* name)
+    {
+        CpuProfiler* profiler = g_active.load(std::memory_order_acquire);
+
+        g_threadName = name;
+
+        if (profiler != nullptr) {
+            profiler->m_trace.setThreadName(TraceWriter::g_cpuProcess, getThreadBuffer(profiler)->tid, name);
+        }
+    }
+
+    CpuProfiler::ThreadBuffer* CpuProfiler::getThreadBuffer(CpuProfiler* profiler)
+    {
+        // a thread outlives profilers, the generation tells whether its buffer belongs to this one
+        static thread_local ThreadBuffer* buffer = nullptr;
+        static thread_local uint32_t generation = 0;
+        std::unique_ptr<ThreadBuffer> newBuffer;
+
+        if (generation == profiler->m_generation) {
+            return buffer;
+        }
+
+        newBuffer = std::make_unique<ThreadBuffer>();
+        newBuffer->records.resize(profiler->m_ringSize);
+        newBuffer->head.store(0, std::memory_order_relaxed);
+        newBuffer->tail.store(0, std::memory_order_relaxed);
+        newBuffer->droppedCount.store(0, std::memory_order_relaxed);
+        newBuffer->openCount = 0;
+        newBuffer->depth = 0;
+        newBuffer->skipDepth = ~0u;
+
+        buffer = newBuffer.get();
+        generation = profiler->m_generation;
+
+        {
+            std::lock_guard<std::mutex> lock(profiler->m_buffersMutex);
+
+            buffer->tid = static_cast<uint32_t>(profiler->m_buffers.size());
+            profiler->m_buffers.push_back(std::move(newBuffer));
+        }
+
+        if (g_threadName != nullptr) {
+            profiler->m_trace.setThreadName(TraceWriter::g_cpuProcess, buffer->tid, g_threadName);
+        }
+        else {
+            profiler->m_trace.setThreadName(TraceWriter::g_cpuProcess, buffer->tid, "Thread " + std::to_string(buffer->tid));
+        }
+
+        return buffer;
+    }
+
+    void CpuProfiler::push(ThreadBuffer& buffer, const Record& record)
+    {
+        uint64_t head = buffer.head.load(std::memory_order_relaxed);
+
+        // the release publishes the record to the collector's acquire of head
+        buffer.records[head & (buffer.records.size() - 1)] = record;
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+    void CpuProfiler::collectorLoop()
+    {
+        std::unique_lock<std::mutex> lock(m_stopMutex);
+
+        while (!m_stopCondition.wait_for(lock, std::chrono::milliseconds(5), [this]() { return m_stop; })) {
+            collect();
+        }
+    }
+
+    void CpuProfiler::collect()
+    {
+        std::vector<TraceEvent> events;
+
+        {
+            std::lock_guard<std::mutex> lock(m_buffersMutex);
+
+            for (auto& buffer : m_buffers) {
+                uint64_t head = buffer->head.load(std::memory_order_acquire);
+                uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+                uint64_t mask = buffer->records.size() - 1;
+
+                // a scope can begin in one drain and end in a later one, open begins carry over
+                for (; tail != head; tail++) {
+                    const Record& record = buffer->records[tail & mask];
+
+                    if (record.name != nullptr) {
+                        buffer->openScopes.push_back(record);
+                    }
+                    else if (!buffer->openScopes.empty()) {
+                        const Record& begin = buffer->openScopes.back();
+
+                        events.push_back({ begin.name, "cpu", TraceWriter::g_cpuProcess, buffer->tid, begin.time, record.time - begin.time });
+                        buffer->openScopes.pop_back();
+                    }
+                }
+
+                // hands the slots back to the thread
+                buffer->tail.store(head, std::memory_order_release);
+            }
+        }
+
+        if (!events.empty()) {
+            m_trace.add(events);
+        }
+    }
+}
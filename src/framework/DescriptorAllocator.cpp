@@ -0,0 +1,114 @@
+#include <framework/DescriptorAllocator.h>
+
+namespace frm
+{
+    DescriptorAllocator::DescriptorAllocator(VulkanContext& context, uint32_t setsPerPool) :
+        DescriptorAllocator(context,
+                            setsPerPool,
+                            {
+                                { VK_DESCRIPTOR_TYPE_SAMPLER, 0.5f },
+                                { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.f },
+                                { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4.f },
+                                { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.f },
+                                { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.f },
+                                { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.f },
+                                { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.f },
+                            })
+    {
+    }
+
+    DescriptorAllocator::DescriptorAllocator(VulkanContext& context, uint32_t setsPerPool, const std::vector<PoolRatio>& ratios) :
+        m_context(context),
+        m_setsPerPool(setsPerPool),
+        m_ratios(ratios),
+        m_currentPool(nullptr)
+    {
+    }
+
+    DescriptorAllocator::~DescriptorAllocator()
+    {
+        VkDevice device = m_context.getDevice();
+
+        for (auto pool : m_usedPools) {
+            vkDestroyDescriptorPool(device, pool, nullptr);
+        }
+
+        for (auto pool : m_freePools) {
+            vkDestroyDescriptorPool(device, pool, nullptr);
+        }
+    }
+
+    VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout)
+    {
+        VkDescriptorSetAllocateInfo allocInfo{};
+        VkDescriptorSet set;
+        VkResult result;
+
+        if (m_currentPool == nullptr) {
+            m_currentPool = grabPool();
+        }
+
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = m_currentPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &layout;
+
+        result = vkAllocateDescriptorSets(m_context.getDevice(), &allocInfo, &set);
+
+        if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+            // The current pool is full, carry on with a fresh one
+            m_currentPool = grabPool();
+            allocInfo.descriptorPool = m_currentPool;
+            result = vkAllocateDescriptorSets(m_context.getDevice(), &allocInfo, &set);
+        }
+
+        if (VK_FAILED(result)) {
+            throw std::runtime_error("Cannot allocate descriptor set");
+        }
+
+        return set;
+    }
+
+    void DescriptorAllocator::reset()
+    {
+        VkDevice device = m_context.getDevice();
+
+        for (auto pool : m_usedPools) {
+            vkResetDescriptorPool(device, pool, 0);
+            m_freePools.push_back(pool);
+        }
+
+        m_usedPools.clear();
+        m_currentPool = nullptr;
+    }
+
+    VkDescriptorPool DescriptorAllocator::grabPool()
+    {
+        VkDescriptorPool pool;
+
+        if (!m_freePools.empty()) {
+            pool = m_freePools.back();
+            m_freePools.pop_back();
+        }
+        else {
+            std::vector<VkDescriptorPoolSize> poolSizes;
+            VkDescriptorPoolCreateInfo poolInfo{};
+
+            for (auto& ratio : m_ratios) {
+                uint32_t count = static_cast<uint32_t>(ratio.ratio * static_cast<float>(m_setsPerPool));
+                poolSizes.push_back({ ratio.type, std::max(1u, count) });
+            }
+
+            poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            poolInfo.maxSets = m_setsPerPool;
+            poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+            poolInfo.pPoolSizes = poolSizes.data();
+
+            m_context.createDescriptorPool(poolInfo, &pool);
+        }
+
+        m_usedPools.push_back(pool);
+
+        return pool;
+    }
+}
@@ -0,0 +1,235 @@
+#include <framework/FrameStats.h>
+#include <cmath>
+#include <iomanip>
+
+namespace frm
+{
+    const uint32_t FrameStats::g_bucketsPerOctave;
+    const uint32_t FrameStats::g_bucketCount;
+    const uint32_t FrameStats::g_maxWindowSize;
+
+    static const double g_firstBucketLimit = 1.0 / 16.0; // ms
+    static const char* g_metricNames[] = { "cpu_frame", "prepare_wait", "submit_wait", "present" };
+
+    FrameStats::FrameStats(uint32_t windowSize) :
+        m_windowSize(std::min(std::max(1u, windowSize), g_maxWindowSize)),
+        m_frameCount(0),
+        m_streamedCount(0),
+        m_streamJson(false)
+    {
+        m_window.reserve(m_windowSize);
+
+        for (auto& histogram : m_histograms) {
+            histogram.resize(g_bucketCount, 0);
+        }
+    }
+
+    FrameStats::~FrameStats()
+    {
+        closeStream();
+    }
+
+    void FrameStats::addFrame(const FrameSample& sample)
+    {
+        if (m_window.size() < m_windowSize) {
+            m_window.push_back(sample);
+        }
+        else {
+            m_window[m_frameCount % m_windowSize] = sample;
+        }
+
+        for (size_t i = 0; i < static_cast<size_t>(FrameMetric::Count); i++) {
+            m_histograms[i][getBucket(sample.times[i])]++;
+        }
+
+        if (m_stream.is_open()) {
+            if (m_streamJson) {
+                m_stream << (m_streamedCount == 0 ? "\n" : ",\n") << "{\"frame\":" << m_streamedCount;
+
+                for (size_t i = 0; i < static_cast<size_t>(FrameMetric::Count); i++) {
+                    m_stream << ",\"" << g_metricNames[i] << "\":" << sample.times[i];
+                }
+
+                m_stream << "}";
+            }
+            else {
+                m_stream << m_streamedCount;
+
+                for (size_t i = 0; i < static_cast<size_t>(FrameMetric::Count); i++) {
+                    m_stream << "," << sample.times[i];
+                }
+
+                m_stream << "\n";
+            }
+
+            m_streamedCount++;
+        }
+
+        m_frameCount++;
+    }
+
+    void FrameStats::reset()
+    {
+        m_window.clear();
+        m_frameCount = 0;
+
+        for (auto& histogram : m_histograms) {
+            std::fill(histogram.begin(), histogram.end(), 0);
+        }
+    }
+
+    void FrameStats::setWindowSize(uint32_t windowSize)
+    {
+        m_windowSize = std::min(std::max(1u, windowSize), g_maxWindowSize);
+        m_window.clear();
+        m_window.shrink_to_fit();
+        m_window.reserve(m_windowSize);
+        reset();
+    }
+
+    FrameSummary FrameStats::getSummary(FrameMetric metric) const
+    {
+        FrameSummary summary{};
+        std::vector<double> times;
+        size_t index = static_cast<size_t>(metric);
+
+        if (m_window.empty()) {
+            return summary;
+        }
+
+        times.reserve(m_window.size());
+
+        for (auto& sample : m_window) {
+            times.push_back(sample.times[index]);
+            summary.mean += sample.times[index];
+        }
+
+        // nearest rank, a window of a thousand frames is cheap enough to sort
+        std::sort(times.begin(), times.end());
+
+        auto percentile = [&times](double p) {
+            size_t rank = static_cast<size_t>(std::ceil(p * times.size()));
+            return times[std::min(times.size(), std::max<size_t>(rank, 1)) - 1];
+        };
+
+        summary.mean /= static_cast<double>(times.size());
+        summary.p50 = percentile(0.50);
+        summary.p95 = percentile(0.95);
+        summary.p99 = percentile(0.99);
+        summary.max = times.back();
+
+        return summary;
+    }
+
+    void FrameStats::print(std::ostream& stream) const
+    {
+        const std::vector<uint64_t>& histogram = getHistogram(FrameMetric::CpuFrame);
+        uint64_t maxCount = *std::max_element(histogram.begin(), histogram.end());
+        uint32_t first = 0;
+        uint32_t last = g_bucketCount;
+        std::ios::fmtflags flags = stream.flags();
+
+        stream << "Frame stats over the last " << m_window.size() << " of " << m_frameCount << " frames (ms):" << std::endl;
+        stream << std::fixed << std::setprecision(3);
+
+        for (size_t i = 0; i < static_cast<size_t>(FrameMetric::Count); i++) {
+            FrameSummary summary = getSummary(static_cast<FrameMetric>(i));
+
+            stream << "  " << std::left << std::setw(14) << g_metricNames[i] << std::right
+                   << " mean " << std::setw(9) << summary.mean
+                   << "  p50 " << std::setw(9) << summary.p50
+                   << "  p95 " << std::setw(9) << summary.p95
+                   << "  p99 " << std::setw(9) << summary.p99
+                   << "  max " << std::setw(9) << summary.max << std::endl;
+        }
+
+        if (maxCount == 0) {
+            stream.flags(flags);
+            return;
+        }
+
+        // only the populated range of buckets
+        while (histogram[first] == 0) {
+            first++;
+        }
+
+        while (histogram[last - 1] == 0) {
+            last--;
+        }
+
+        stream << "CPU frame histogram (whole run):" << std::endl;
+
+        for (uint32_t i = first; i < last; i++) {
+            size_t barLength = static_cast<size_t>((histogram[i] * 40 + maxCount - 1) / maxCount);
+
+            stream << "  <" << std::setw(9) << getBucketLimit(i) << " " << std::setw(8) << histogram[i] << " " << std::string(barLength, '#') << std::endl;
+        }
+
+        stream.flags(flags);
+    }
+
+    bool FrameStats::openStream(const std::string& path)
+    {
+        closeStream();
+
+        m_streamedCount = 0;
+        m_streamJson = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+        m_stream.open(path, std::ios::out | std::ios::trunc);
+
+        if (!m_stream.is_open()) {
+            return false;
+        }
+
+        // every frame from here on is streamed, warm-up frames included, numbered from 0
+        if (m_streamJson) {
+            m_stream << "[";
+        }
+        else {
+            m_stream << "frame";
+
+            for (auto name : g_metricNames) {
+                m_stream << "," << name;
+            }
+
+            m_stream << "\n";
+        }
+
+        return true;
+    }
+
+    void FrameStats::closeStream()
+    {
+        if (!m_stream.is_open()) {
+            return;
+        }
+
+        if (m_streamJson) {
+            m_stream << "\n]\n";
+        }
+
+        m_stream.close();
+    }
+
+    double FrameStats::getBucketLimit(uint32_t bucket)
+    {
+        return g_firstBucketLimit * std::exp2(static_cast<double>(bucket + 1) / g_bucketsPerOctave);
+    }
+
+    const char* FrameStats::getMetricName(FrameMetric metric)
+    {
+        return g_metricNames[static_cast<size_t>(metric)];
+    }
+
+    uint32_t FrameStats::getBucket(double time)
+    {
+        double bucket;
+
+        if (!(time > g_firstBucketLimit)) {
+            return 0;
+        }
+
+        bucket = std::floor(std::log2(time / g_firstBucketLimit) * g_bucketsPerOctave);
+
+        return static_cast<uint32_t>(std::min(bucket, static_cast<double>(g_bucketCount - 1)));
+    }
+}
@@ -25,4 +25,41 @@ namespace frm
     {
         vmaDestroyImage(m_allocator, m_resource, m_allocation);
     }
+
+    ImageResource::ImageResource(VmaAllocator allocator, VkImage image, VmaAllocation allocation, const VkImageCreateInfo& createInfo) :
+        GPUResource(allocator, image, allocation),
+        m_format(createInfo.format),
+        m_aspect(VK_IMAGE_ASPECT_COLOR_BIT),
+        m_mipLevels(createInfo.mipLevels),
+        m_arrayLayers(createInfo.arrayLayers)
+    {
+        ImageSubresourceState state{};
+
+        switch (createInfo.format) {
+            case VK_FORMAT_D16_UNORM:
+            case VK_FORMAT_X8_D24_UNORM_PACK32:
+            case VK_FORMAT_D32_SFLOAT:
+                m_aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+                break;
+            case VK_FORMAT_S8_UINT:
+                m_aspect = VK_IMAGE_ASPECT_STENCIL_BIT;
+                break;
+            case VK_FORMAT_D16_UNORM_S8_UINT:
+            case VK_FORMAT_D24_UNORM_S8_UINT:
+            case VK_FORMAT_D32_SFLOAT_S8_UINT:
+                m_aspect = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+                break;
+            default:
+                break;
+        }
+
+        // nothing has touched the image yet
+        state.layout = createInfo.initialLayout;
+        m_states.resize(static_cast<size_t>(m_mipLevels) * m_arrayLayers, state);
+    }
+
+    void ImageResource::setState(const ImageSubresourceState& state)
+    {
+        std::fill(m_states.begin(), m_states.end(), state);
+    }
 }
@@ -0,0 +1,209 @@
+#include <framework/GpuProfiler.h>
+
+namespace frm
+{
+    GpuProfiler::GpuProfiler(VulkanContext& context, uint32_t maxScopesPerFrame) :
+        m_context(context),
+        m_maxQueries(maxScopesPerFrame * 2),
+        m_currentFrame(0),
+        m_timestampMask(),
+        m_timestampPeriod(context.getDeviceLimits().timestampPeriod),
+        m_gpuToCpu(0),
+        m_droppedCount(0)
+    {
+        VkDevice device = context.getDevice();
+        VkQueryPoolCreateInfo poolInfo{};
+        uint32_t queueFamilyCount;
+        std::vector<VkQueueFamilyProperties> queueFamilyProps;
+
+        if (!context.getFeatures().hostQueryReset) {
+            throw std::runtime_error("Cannot profile the GPU, host query reset is not supported");
+        }
+
+        vkGetPhysicalDeviceQueueFamilyProperties(context.getPhysicalDevice(), &queueFamilyCount, nullptr);
+        queueFamilyProps.resize(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(context.getPhysicalDevice(), &queueFamilyCount, queueFamilyProps.data());
+
+        // timestamps only have timestampValidBits significant bits, and some queues (often transfer) have none
+        for (size_t i = 0; i < static_cast<size_t>(QueueType::Count); i++) {
+            uint32_t validBits = queueFamilyProps[context.getQueueIndex(static_cast<QueueType>(i))].timestampValidBits;
+
+            m_timestampMask[i] = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+        }
+
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = m_maxQueries;
+
+        m_frames.resize(context.getFramesInFlight());
+
+        for (auto& frame : m_frames) {
+            if (VK_FAILED(vkCreateQueryPool(device, &poolInfo, nullptr, &frame.pool))) {
+                throw std::runtime_error("Cannot create timestamp query pool");
+            }
+
+            vkResetQueryPool(device, frame.pool, 0, m_maxQueries);
+            frame.queryCount = 0;
+        }
+
+        calibrate();
+    }
+
+    GpuProfiler::~GpuProfiler()
+    {
+        for (auto& frame : m_frames) {
+            vkDestroyQueryPool(m_context.getDevice(), frame.pool, nullptr);
+        }
+
+        if (m_droppedCount > 0) {
+            std::cout << "GPU profiler: " << m_droppedCount << " scopes dropped" << std::endl;
+        }
+    }
+
+    uint32_t GpuProfiler::beginScope(VkCommandBuffer cmdBuffer, const char* name, QueueType queue)
+    {
+        FrameQueries& frame = m_frames[m_currentFrame];
+        uint32_t query;
+
+        if (m_timestampMask[static_cast<size_t>(queue)] == 0) {
+            return ~0u;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if (frame.queryCount + 2 > m_maxQueries) {
+                m_droppedCount++;
+                return ~0u;
+            }
+
+            query = frame.queryCount;
+            frame.queryCount += 2;
+            frame.scopes.push_back({ name, queue, query });
+        }
+
+        vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.pool, query);
+
+        return query;
+    }
+
+    void GpuProfiler::endScope(VkCommandBuffer cmdBuffer, uint32_t query)
+    {
+        // scopes never span frames, the slot is still the one the scope began in
+        vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_frames[m_currentFrame].pool, query + 1);
+    }
+
+    void GpuProfiler::beginFrame(uint32_t frameIndex)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        resolve(m_frames[frameIndex]);
+        m_currentFrame = frameIndex;
+    }
+
+    void GpuProfiler::resolveAll()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (auto& frame : m_frames) {
+            resolve(frame);
+        }
+    }
+
+    void GpuProfiler::exportTrace(TraceWriter& trace)
+    {
+        static const char* queueNames[] = { "Graphics queue", "Transfer queue", "Compute queue" };
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (uint32_t i = 0; i < static_cast<uint32_t>(QueueType::Count); i++) {
+            trace.setThreadName(TraceWriter::g_gpuProcess, i, queueNames[i]);
+        }
+
+        trace.add(m_events);
+        m_events.clear();
+    }
+
+    void GpuProfiler::calibrate()
+    {
+        VkQueryPool pool = m_frames[0].pool;
+        VkCommandPool cmdPool;
+        VkCommandBuffer cmdBuffer;
+        VkCommandBufferBeginInfo beginInfo{};
+        VkSubmitInfo submit{};
+        uint64_t ticks = 0;
+
+        if (m_timestampMask[static_cast<size_t>(QueueType::Graphics)] == 0) {
+            return;
+        }
+
+        // One timestamp, read right after the GPU finished it. Puts the GPU clock on the CPU's steady clock
+        // up to the submission latency, close enough to line up CPU and GPU scopes in a trace.
+        m_context.createCommandPool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, &cmdPool);
+        m_context.createCommandBuffer(cmdPool, &cmdBuffer);
+
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        vkBeginCommandBuffer(cmdBuffer, &beginInfo);
+        vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pool, 0);
+        vkEndCommandBuffer(cmdBuffer);
+
+        submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit.commandBufferCount = 1;
+        submit.pCommandBuffers = &cmdBuffer;
+
+        m_context.wait(m_context.queueSubmitAsync(QueueType::Graphics, submit));
+
+        vkGetQueryPoolResults(m_context.getDevice(), pool, 0, 1, sizeof(ticks), &ticks, sizeof(ticks), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+
+        m_gpuToCpu = TraceWriter::now() - static_cast<int64_t>(static_cast<double>(ticks) * m_timestampPeriod);
+
+        vkResetQueryPool(m_context.getDevice(), pool, 0, 1);
+        vkDestroyCommandPool(m_context.getDevice(), cmdPool, nullptr);
+    }
+
+    void GpuProfiler::resolve(FrameQueries& frame)
+    {
+        std::vector<uint64_t> results(static_cast<size_t>(frame.queryCount) * 2);
+
+        if (frame.queryCount == 0) {
+            return;
+        }
+
+        // value + availability per query, unfinished scopes are dropped instead of waited for
+        vkGetQueryPoolResults(m_context.getDevice(),
+                              frame.pool,
+                              0,
+                              frame.queryCount,
+                              results.size() * sizeof(uint64_t),
+                              results.data(),
+                              2 * sizeof(uint64_t),
+                              VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+        for (auto& scope : frame.scopes) {
+            const uint64_t* begin = &results[static_cast<size_t>(scope.query) * 2];
+            const uint64_t* end = begin + 2;
+            uint64_t mask = m_timestampMask[static_cast<size_t>(scope.queue)];
+            TraceEvent event{};
+
+            // unfinished, or more than the trace would take anyway
+            if (begin[1] == 0 || end[1] == 0 || m_events.size() >= TraceWriter::g_defaultMaxEvents) {
+                m_droppedCount++;
+                continue;
+            }
+
+            event.name = scope.name;
+            event.category = "gpu";
+            event.pid = TraceWriter::g_gpuProcess;
+            event.tid = static_cast<uint32_t>(scope.queue);
+            event.start = static_cast<int64_t>(static_cast<double>(begin[0] & mask) * m_timestampPeriod) + m_gpuToCpu;
+            event.duration = static_cast<int64_t>(static_cast<double>((end[0] - begin[0]) & mask) * m_timestampPeriod);
+
+            m_events.push_back(event);
+        }
+
+        vkResetQueryPool(m_context.getDevice(), frame.pool, 0, frame.queryCount);
+        frame.scopes.clear();
+        frame.queryCount = 0;
+    }
+}
@@ -0,0 +1,266 @@
+#include <framework/ImageTracker.h>
+
+namespace frm
+{
+    ImageTracker::ImageTracker(VulkanContext& context) :
+        m_context(context),
+        m_skippedCount(0)
+    {
+    }
+
+    void ImageTracker::transition(const ImageResourceRef& image,
+                                  VkImageLayout newLayout,
+                                  VkPipelineStageFlags2KHR dstStage,
+                                  VkAccessFlags2KHR dstAccess,
+                                  const VkImageSubresourceRange* range)
+    {
+        uint32_t mipLevels = image->getMipLevels();
+        uint32_t arrayLayers = image->getArrayLayers();
+        uint32_t baseMip = range != nullptr ? range->baseMipLevel : 0;
+        uint32_t baseLayer = range != nullptr ? range->baseArrayLayer : 0;
+        uint32_t mipCount = range != nullptr && range->levelCount != VK_REMAINING_MIP_LEVELS ? range->levelCount : mipLevels - std::min(baseMip, mipLevels);
+        uint32_t layerCount = range != nullptr && range->layerCount != VK_REMAINING_ARRAY_LAYERS ? range->layerCount : arrayLayers - std::min(baseLayer, arrayLayers);
+        std::vector<Run> runs;
+        uint32_t skippedCount = 0;
+
+        if (baseMip >= mipLevels || mipCount == 0 || mipCount > mipLevels - baseMip) {
+            throw std::runtime_error("Cannot transition mip levels outside of the image");
+        }
+
+        if (baseLayer >= arrayLayers || layerCount == 0 || layerCount > arrayLayers - baseLayer) {
+            throw std::runtime_error("Cannot transition array layers outside of the image");
+        }
+
+        for (uint32_t layer = baseLayer; layer < baseLayer + layerCount; layer++) {
+            for (uint32_t mip = baseMip; mip < baseMip + mipCount; mip++) {
+                const ImageSubresourceState& state = image->getState(mip, layer);
+
+                if (state.layout == newLayout && !hasWrite(state.access) && !hasWrite(dstAccess) &&
+                    (dstStage & ~state.stage) == 0 && (dstAccess & ~state.access) == 0) {
+                    // read after read in the same layout, only new stages have to wait for the last write
+                    skippedCount++;
+                    continue;
+                }
+
+                // neighbouring mips with the same old state share a barrier
+                if (!runs.empty()) {
+                    Run& last = runs.back();
+
+                    if (last.arrayLayer == layer && last.mipLevel + last.mipCount == mip &&
+                        last.oldState.layout == state.layout && last.oldState.stage == state.stage && last.oldState.access == state.access) {
+                        last.mipCount++;
+                        continue;
+                    }
+                }
+
+                runs.push_back({ state, mip, 1, layer });
+            }
+        }
+
+        // everything is checked before anything changes, a throw leaves the tracker and the image as they were
+        for (auto& run : runs) {
+            if (isPending(*image, run.mipLevel, run.mipCount, run.arrayLayer)) {
+                throw std::runtime_error("Cannot transition an image subresource twice without flushing");
+            }
+        }
+
+        for (auto& run : runs) {
+            queueBarrier(*image, run.oldState, newLayout, dstStage, dstAccess, run.mipLevel, run.mipCount, run.arrayLayer);
+
+            for (uint32_t mip = run.mipLevel; mip < run.mipLevel + run.mipCount; mip++) {
+                ImageSubresourceState& state = image->getState(mip, run.arrayLayer);
+
+                if (state.layout == newLayout && !hasWrite(state.access) && !hasWrite(dstAccess)) {
+                    // more readers, a later write has to wait for all of them
+                    state.stage |= dstStage;
+                    state.access |= dstAccess;
+                }
+                else {
+                    state.layout = newLayout;
+                    state.stage = dstStage;
+                    state.access = dstAccess;
+                }
+            }
+        }
+
+        m_skippedCount += skippedCount;
+
+        if (!runs.empty()) {
+            m_pendingImages.push_back(image);
+        }
+    }
+
+    void ImageTracker::flush(VkCommandBuffer cmdBuffer)
+    {
+        VkDependencyInfoKHR dependency{};
+
+        if (m_barriers.empty()) {
+            return;
+        }
+
+        if (m_context.getFunctions().cmdPipelineBarrier2 != nullptr) {
+            dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+            dependency.imageMemoryBarrierCount = static_cast<uint32_t>(m_barriers.size());
+            dependency.pImageMemoryBarriers = m_barriers.data();
+
+            m_context.getFunctions().cmdPipelineBarrier2(cmdBuffer, &dependency);
+        }
+        else {
+            recordLegacy(cmdBuffer);
+        }
+
+        m_barriers.clear();
+        m_pendingImages.clear();
+    }
+
+    void ImageTracker::queueBarrier(ImageResource& image,
+                                    const ImageSubresourceState& oldState,
+                                    VkImageLayout newLayout,
+                                    VkPipelineStageFlags2KHR dstStage,
+                                    VkAccessFlags2KHR dstAccess,
+                                    uint32_t mipLevel,
+                                    uint32_t mipCount,
+                                    uint32_t arrayLayer)
+    {
+        VkImageMemoryBarrier2KHR barrier{};
+
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+        barrier.srcStageMask = oldState.stage;
+        barrier.srcAccessMask = hasWrite(oldState.access) ? oldState.access : 0; // reads don't need to be made available
+        barrier.dstStageMask = dstStage;
+        barrier.dstAccessMask = dstAccess;
+        barrier.oldLayout = oldState.layout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image.get();
+        barrier.subresourceRange.aspectMask = image.getAspect();
+        barrier.subresourceRange.baseMipLevel = mipLevel;
+        barrier.subresourceRange.levelCount = mipCount;
+        barrier.subresourceRange.baseArrayLayer = arrayLayer;
+        barrier.subresourceRange.layerCount = 1;
+
+        // extend the previous layer's barrier when this one continues it
+        if (!m_barriers.empty()) {
+            VkImageMemoryBarrier2KHR& last = m_barriers.back();
+
+            if (last.image == barrier.image &&
+                last.srcStageMask == barrier.srcStageMask &&
+                last.srcAccessMask == barrier.srcAccessMask &&
+                last.dstStageMask == barrier.dstStageMask &&
+                last.dstAccessMask == barrier.dstAccessMask &&
+                last.oldLayout == barrier.oldLayout &&
+                last.newLayout == barrier.newLayout &&
+                last.subresourceRange.baseMipLevel == mipLevel &&
+                last.subresourceRange.levelCount == mipCount &&
+                last.subresourceRange.baseArrayLayer + last.subresourceRange.layerCount == arrayLayer) {
+                last.subresourceRange.layerCount++;
+                return;
+            }
+        }
+
+        m_barriers.push_back(barrier);
+    }
+
+    bool ImageTracker::isPending(const ImageResource& image, uint32_t mipLevel, uint32_t mipCount, uint32_t arrayLayer) const
+    {
+        // barriers of one flush are unordered, a second transition of the same subresource would race with the first
+        for (auto& pending : m_barriers) {
+            const VkImageSubresourceRange& r = pending.subresourceRange;
+
+            if (pending.image == image.get() &&
+                mipLevel < r.baseMipLevel + r.levelCount && r.baseMipLevel < mipLevel + mipCount &&
+                arrayLayer < r.baseArrayLayer + r.layerCount && r.baseArrayLayer <= arrayLayer) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void ImageTracker::recordLegacy(VkCommandBuffer cmdBuffer)
+    {
+        std::vector<VkImageMemoryBarrier> barriers;
+        VkPipelineStageFlags srcStages = 0;
+        VkPipelineStageFlags dstStages = 0;
+
+        // sync1 has one pair of stage masks per call, the union of all barriers
+        for (auto& barrier2 : m_barriers) {
+            VkImageMemoryBarrier barrier{};
+
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcAccessMask = toLegacyAccess(barrier2.srcAccessMask);
+            barrier.dstAccessMask = toLegacyAccess(barrier2.dstAccessMask);
+            barrier.oldLayout = barrier2.oldLayout;
+            barrier.newLayout = barrier2.newLayout;
+            barrier.srcQueueFamilyIndex = barrier2.srcQueueFamilyIndex;
+            barrier.dstQueueFamilyIndex = barrier2.dstQueueFamilyIndex;
+            barrier.image = barrier2.image;
+            barrier.subresourceRange = barrier2.subresourceRange;
+
+            srcStages |= toLegacyStages(barrier2.srcStageMask, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+            dstStages |= toLegacyStages(barrier2.dstStageMask, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+            barriers.push_back(barrier);
+        }
+
+        vkCmdPipelineBarrier(cmdBuffer,
+                             srcStages,
+                             dstStages,
+                             0,
+                             0,
+                             nullptr,
+                             0,
+                             nullptr,
+                             static_cast<uint32_t>(barriers.size()),
+                             barriers.data());
+    }
+
+    bool ImageTracker::hasWrite(VkAccessFlags2KHR access)
+    {
+        static const VkAccessFlags2KHR writeAccess =
+            VK_ACCESS_2_SHADER_WRITE_BIT_KHR |
+            VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR |
+            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR |
+            VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR |
+            VK_ACCESS_2_HOST_WRITE_BIT_KHR |
+            VK_ACCESS_2_MEMORY_WRITE_BIT_KHR |
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR;
+
+        return (access & writeAccess) != 0;
+    }
+
+    VkPipelineStageFlags ImageTracker::toLegacyStages(VkPipelineStageFlags2KHR stages, VkPipelineStageFlags none)
+    {
+        // the lower 32 bits are the sync1 stages, the split up ones above map back to what contains them
+        VkPipelineStageFlags legacy = static_cast<VkPipelineStageFlags>(stages & 0xFFFFFFFFull);
+
+        if (stages & (VK_PIPELINE_STAGE_2_COPY_BIT_KHR | VK_PIPELINE_STAGE_2_RESOLVE_BIT_KHR | VK_PIPELINE_STAGE_2_BLIT_BIT_KHR | VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR)) {
+            legacy |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+        }
+
+        if (stages & (VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT_KHR | VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT_KHR)) {
+            legacy |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+        }
+
+        if (stages & VK_PIPELINE_STAGE_2_PRE_RASTERIZATION_SHADERS_BIT_KHR) {
+            legacy |= VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT; // tessellation and geometry stages may not be enabled
+        }
+
+        return legacy != 0 ? legacy : none;
+    }
+
+    VkAccessFlags ImageTracker::toLegacyAccess(VkAccessFlags2KHR access)
+    {
+        VkAccessFlags legacy = static_cast<VkAccessFlags>(access & 0xFFFFFFFFull);
+
+        if (access & (VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR | VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR)) {
+            legacy |= VK_ACCESS_SHADER_READ_BIT;
+        }
+
+        if (access & VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR) {
+            legacy |= VK_ACCESS_SHADER_WRITE_BIT;
+        }
+
+        return legacy;
+    }
+}
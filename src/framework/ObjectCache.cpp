@@ -0,0 +1,255 @@
+#include <framework/ObjectCache.h>
+
+namespace frm
+{
+    namespace
+    {
+        // Appends members one at a time instead of copying whole structs, so padding bytes never end up in a key
+        class KeyWriter
+        {
+        public:
+            KeyWriter(const void* pNext)
+            {
+                if (pNext != nullptr) {
+                    throw std::runtime_error("Cannot cache an object created with a pNext chain");
+                }
+            }
+
+            template<class T>
+            void write(const T& value)
+            {
+                m_key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+            }
+
+            template<class T>
+            void writeArray(const T* values, uint32_t count)
+            {
+                write(count);
+
+                if (values != nullptr) {
+                    m_key.append(reinterpret_cast<const char*>(values), sizeof(T) * count);
+                }
+            }
+
+            void writeRef(const VkAttachmentReference& ref)
+            {
+                write(ref.attachment);
+                write(ref.layout);
+            }
+
+            void writeRefs(const VkAttachmentReference* refs, uint32_t count)
+            {
+                write(refs != nullptr);
+
+                if (refs != nullptr) {
+                    for (uint32_t i = 0; i < count; i++) {
+                        writeRef(refs[i]);
+                    }
+                }
+            }
+
+            std::string&& get() { return std::move(m_key); }
+
+        private:
+            std::string m_key;
+        };
+    }
+
+    ObjectCache::ObjectCache(VulkanContext& context) :
+        m_context(context),
+        m_hits(0),
+        m_misses(0)
+    {
+    }
+
+    ObjectCache::~ObjectCache()
+    {
+        VkDevice device = m_context.getDevice();
+
+        std::cout << "Object cache: " << m_hits << " hits, " << m_misses << " misses" << std::endl;
+
+        for (auto& [key, renderPass] : m_renderPasses) {
+            vkDestroyRenderPass(device, renderPass, nullptr);
+        }
+
+        for (auto& [key, pipelineLayout] : m_pipelineLayouts) {
+            vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+        }
+
+        for (auto& [key, setLayout] : m_setLayouts) {
+            vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+        }
+
+        for (auto& [key, sampler] : m_samplers) {
+            vkDestroySampler(device, sampler, nullptr);
+        }
+
+        for (auto& [key, shaderModule] : m_shaderModules) {
+            vkDestroyShaderModule(device, shaderModule, nullptr);
+        }
+    }
+
+    VkShaderModule ObjectCache::getShaderModule(const std::vector<uint8_t>& shaderBlob)
+    {
+        Key key(shaderBlob.begin(), shaderBlob.end());
+
+        return getOrCreate(m_shaderModules, std::move(key), [&](VkShaderModule* shaderModule) {
+            m_context.createShaderModule(shaderBlob, shaderModule);
+        });
+    }
+
+    VkSampler ObjectCache::getSampler(const VkSamplerCreateInfo& createInfo)
+    {
+        KeyWriter key(createInfo.pNext);
+
+        key.write(createInfo.flags);
+        key.write(createInfo.magFilter);
+        key.write(createInfo.minFilter);
+        key.write(createInfo.mipmapMode);
+        key.write(createInfo.addressModeU);
+        key.write(createInfo.addressModeV);
+        key.write(createInfo.addressModeW);
+        key.write(createInfo.mipLodBias);
+        key.write(createInfo.anisotropyEnable);
+        key.write(createInfo.maxAnisotropy);
+        key.write(createInfo.compareEnable);
+        key.write(createInfo.compareOp);
+        key.write(createInfo.minLod);
+        key.write(createInfo.maxLod);
+        key.write(createInfo.borderColor);
+        key.write(createInfo.unnormalizedCoordinates);
+
+        return getOrCreate(m_samplers, key.get(), [&](VkSampler* sampler) {
+            m_context.createSampler(createInfo, sampler);
+        });
+    }
+
+    VkDescriptorSetLayout ObjectCache::getDescriptorLayout(const VkDescriptorSetLayoutCreateInfo& createInfo)
+    {
+        KeyWriter key(createInfo.pNext);
+
+        key.write(createInfo.flags);
+        key.write(createInfo.bindingCount);
+
+        for (uint32_t i = 0; i < createInfo.bindingCount; i++) {
+            const VkDescriptorSetLayoutBinding& binding = createInfo.pBindings[i];
+
+            key.write(binding.binding);
+            key.write(binding.descriptorType);
+            key.write(binding.stageFlags);
+            key.writeArray(binding.pImmutableSamplers, binding.pImmutableSamplers != nullptr ? binding.descriptorCount : 0);
+            key.write(binding.descriptorCount);
+        }
+
+        return getOrCreate(m_setLayouts, key.get(), [&](VkDescriptorSetLayout* setLayout) {
+            m_context.createDescriptorLayout(createInfo, setLayout);
+        });
+    }
+
+    VkPipelineLayout ObjectCache::getPipelineLayout(const VkPipelineLayoutCreateInfo& createInfo)
+    {
+        KeyWriter key(createInfo.pNext);
+
+        key.write(createInfo.flags);
+        key.writeArray(createInfo.pSetLayouts, createInfo.setLayoutCount);
+        key.write(createInfo.pushConstantRangeCount);
+
+        for (uint32_t i = 0; i < createInfo.pushConstantRangeCount; i++) {
+            key.write(createInfo.pPushConstantRanges[i].stageFlags);
+            key.write(createInfo.pPushConstantRanges[i].offset);
+            key.write(createInfo.pPushConstantRanges[i].size);
+        }
+
+        return getOrCreate(m_pipelineLayouts, key.get(), [&](VkPipelineLayout* pipelineLayout) {
+            m_context.createPipelineLayout(createInfo, pipelineLayout);
+        });
+    }
+
+    VkRenderPass ObjectCache::getRenderPass(const VkRenderPassCreateInfo& createInfo)
+    {
+        KeyWriter key(createInfo.pNext);
+
+        key.write(createInfo.flags);
+        key.write(createInfo.attachmentCount);
+
+        for (uint32_t i = 0; i < createInfo.attachmentCount; i++) {
+            const VkAttachmentDescription& attachment = createInfo.pAttachments[i];
+
+            key.write(attachment.flags);
+            key.write(attachment.format);
+            key.write(attachment.samples);
+            key.write(attachment.loadOp);
+            key.write(attachment.storeOp);
+            key.write(attachment.stencilLoadOp);
+            key.write(attachment.stencilStoreOp);
+            key.write(attachment.initialLayout);
+            key.write(attachment.finalLayout);
+        }
+
+        key.write(createInfo.subpassCount);
+
+        for (uint32_t i = 0; i < createInfo.subpassCount; i++) {
+            const VkSubpassDescription& subpass = createInfo.pSubpasses[i];
+
+            key.write(subpass.flags);
+            key.write(subpass.pipelineBindPoint);
+            key.write(subpass.inputAttachmentCount);
+            key.writeRefs(subpass.pInputAttachments, subpass.inputAttachmentCount);
+            key.write(subpass.colorAttachmentCount);
+            key.writeRefs(subpass.pColorAttachments, subpass.colorAttachmentCount);
+            key.writeRefs(subpass.pResolveAttachments, subpass.colorAttachmentCount);
+            key.writeRefs(subpass.pDepthStencilAttachment, 1);
+            key.writeArray(subpass.pPreserveAttachments, subpass.preserveAttachmentCount);
+        }
+
+        key.write(createInfo.dependencyCount);
+
+        for (uint32_t i = 0; i < createInfo.dependencyCount; i++) {
+            const VkSubpassDependency& dependency = createInfo.pDependencies[i];
+
+            key.write(dependency.srcSubpass);
+            key.write(dependency.dstSubpass);
+            key.write(dependency.srcStageMask);
+            key.write(dependency.dstStageMask);
+            key.write(dependency.srcAccessMask);
+            key.write(dependency.dstAccessMask);
+            key.write(dependency.dependencyFlags);
+        }
+
+        return getOrCreate(m_renderPasses, key.get(), [&](VkRenderPass* renderPass) {
+            m_context.createRenderPass(createInfo, renderPass);
+        });
+    }
+
+    uint64_t ObjectCache::getHitCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_hits;
+    }
+
+    uint64_t ObjectCache::getMissCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_misses;
+    }
+
+    template<class T, class CreateFn>
+    T ObjectCache::getOrCreate(std::unordered_map<Key, T>& objects, Key&& key, CreateFn&& create)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = objects.find(key);
+
+        if (it != objects.end()) {
+            m_hits++;
+            return it->second;
+        }
+
+        T object;
+
+        create(&object);
+        objects.emplace(std::move(key), object);
+        m_misses++;
+
+        return object;
+    }
+}
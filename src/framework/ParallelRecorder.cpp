@@ -0,0 +1,94 @@
+#include <framework/ParallelRecorder.h>
+#include <framework/CommandAllocator.h>
+
+namespace frm
+{
+    ParallelRecorder::ParallelRecorder(VulkanContext& context) :
+        m_context(context),
+        m_threadCount(0)
+    {
+        setThreadCount(0);
+    }
+
+    void ParallelRecorder::setThreadCount(uint32_t threadCount)
+    {
+        uint32_t maxThreads = m_context.getThreadPool().getThreadCount() + 1;
+
+        m_threadCount = threadCount == 0 ? maxThreads : std::min(threadCount, maxThreads);
+    }
+
+    void ParallelRecorder::recordRenderPass(VkCommandBuffer cmdBuffer, const VkRenderPassBeginInfo& rpBegin, uint32_t itemCount, const RecordFn& record)
+    {
+        VkCommandBufferInheritanceInfo inheritance{};
+        uint32_t chunkCount = std::max(1u, std::min(m_threadCount, itemCount));
+        uint32_t chunkSize = (itemCount + chunkCount - 1) / chunkCount;
+        std::exception_ptr error;
+
+        inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance.renderPass = rpBegin.renderPass;
+        inheritance.subpass = 0;
+        inheritance.framebuffer = rpBegin.framebuffer;
+
+        m_jobs.clear();
+        m_secondaries.clear();
+
+        for (uint32_t chunk = 0; chunk + 1 < chunkCount; chunk++) {
+            uint32_t first = chunk * chunkSize;
+            uint32_t count = std::min(chunkSize, itemCount - first);
+
+            m_jobs.push_back(m_context.getThreadPool().submit([this, &inheritance, &record, first, count]() {
+                return recordChunk(inheritance, first, count, record);
+            }));
+        }
+
+        // the calling thread takes the last chunk instead of just waiting
+        try {
+            uint32_t first = std::min((chunkCount - 1) * chunkSize, itemCount);
+            VkCommandBuffer last = recordChunk(inheritance, first, itemCount - first, record);
+
+            for (auto& job : m_jobs) {
+                m_secondaries.push_back(job.get());
+            }
+
+            m_secondaries.push_back(last);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+
+        // the jobs reference inheritance and record, none may still be running when we leave
+        for (auto& job : m_jobs) {
+            if (job.valid()) {
+                job.wait();
+            }
+        }
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+
+        vkCmdBeginRenderPass(cmdBuffer, &rpBegin, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        vkCmdExecuteCommands(cmdBuffer, static_cast<uint32_t>(m_secondaries.size()), m_secondaries.data());
+        vkCmdEndRenderPass(cmdBuffer);
+    }
+
+    VkCommandBuffer ParallelRecorder::recordChunk(const VkCommandBufferInheritanceInfo& inheritance, uint32_t first, uint32_t count, const RecordFn& record)
+    {
+        VkCommandBuffer cmdBuffer = m_context.getCommandAllocator().allocate(VK_COMMAND_BUFFER_LEVEL_SECONDARY); // this thread's pool
+        VkCommandBufferBeginInfo cmdBegin{};
+
+        cmdBegin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        cmdBegin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        cmdBegin.pInheritanceInfo = &inheritance;
+
+        vkBeginCommandBuffer(cmdBuffer, &cmdBegin);
+
+        if (count > 0) {
+            record(cmdBuffer, first, count);
+        }
+
+        vkEndCommandBuffer(cmdBuffer);
+
+        return cmdBuffer;
+    }
+}
@@ -0,0 +1,436 @@
+#include <framework/RenderGraph.h>
+#include <framework/ImageTracker.h>
+
+namespace frm
+{
+    RenderGraph::PassBuilder::PassBuilder(RenderGraph& graph, size_t passIndex) :
+        m_graph(graph),
+        m_passIndex(passIndex)
+    {
+    }
+
+    void RenderGraph::PassBuilder::read(ResourceHandle resource, ResourceUsage usage)
+    {
+        m_graph.addAccess(m_passIndex, resource, usage, false);
+    }
+
+    void RenderGraph::PassBuilder::write(ResourceHandle resource, ResourceUsage usage)
+    {
+        m_graph.addAccess(m_passIndex, resource, usage, true);
+    }
+
+    void RenderGraph::PassBuilder::sideEffects()
+    {
+        m_graph.m_passes[m_passIndex].sideEffects = true;
+    }
+
+    RenderGraph::RenderGraph() :
+        m_culledPassCount(0),
+        m_barrierCount(0),
+        m_compiled(false)
+    {
+        clearBatch(m_finalBarriers);
+    }
+
+    void RenderGraph::reset()
+    {
+        m_resources.clear();
+        m_passes.clear();
+        m_passBarriers.clear();
+        clearBatch(m_finalBarriers);
+        m_culledPassCount = 0;
+        m_barrierCount = 0;
+        m_compiled = false;
+    }
+
+    RenderGraph::ResourceHandle RenderGraph::importImage(const char* name,
+                                                         VkImage image,
+                                                         VkImageAspectFlags aspect,
+                                                         VkImageLayout initialLayout,
+                                                         VkPipelineStageFlags initialStage)
+    {
+        Resource resource{};
+
+        resource.name = name;
+        resource.image = image;
+        resource.aspect = aspect;
+        resource.initialState.layout = initialLayout;
+        resource.initialState.writeStage = initialStage;
+        resource.finalLayout = initialLayout;
+
+        m_resources.push_back(resource);
+        m_compiled = false;
+
+        return static_cast<ResourceHandle>(m_resources.size() - 1);
+    }
+
+    RenderGraph::ResourceHandle RenderGraph::importImage(const char* name, const ImageResourceRef& image)
+    {
+        ImageSubresourceState tracked = image->getState(0, 0);
+        ResourceHandle handle;
+
+        // the graph transitions whole images, what the subresources were used for is merged
+        for (uint32_t layer = 0; layer < image->getArrayLayers(); layer++) {
+            for (uint32_t mip = 0; mip < image->getMipLevels(); mip++) {
+                const ImageSubresourceState& state = image->getState(mip, layer);
+
+                if (state.layout != tracked.layout) {
+                    throw std::runtime_error(std::string("Cannot import ") + name + ", its subresources are in different layouts");
+                }
+
+                tracked.stage |= state.stage;
+                tracked.access |= state.access;
+            }
+        }
+
+        handle = importImage(name, image->get(), image->getAspect(), tracked.layout, ImageTracker::toLegacyStages(tracked.stage, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT));
+
+        ResourceState& initialState = m_resources[handle].initialState;
+
+        // a write has to be made visible, reads only have to finish before the next write
+        if (ImageTracker::hasWrite(tracked.access)) {
+            initialState.writeAccess = ImageTracker::toLegacyAccess(tracked.access);
+        }
+        else if (tracked.stage != 0) {
+            initialState.readStages = initialState.writeStage;
+            initialState.readAccess = ImageTracker::toLegacyAccess(tracked.access);
+        }
+
+        m_resources[handle].trackedImage = image;
+
+        return handle;
+    }
+
+    RenderGraph::ResourceHandle RenderGraph::importBuffer(const char* name, VkBuffer buffer, VkPipelineStageFlags initialStage)
+    {
+        Resource resource{};
+
+        resource.name = name;
+        resource.buffer = buffer;
+        resource.initialState.writeStage = initialStage;
+
+        m_resources.push_back(resource);
+        m_compiled = false;
+
+        return static_cast<ResourceHandle>(m_resources.size() - 1);
+    }
+
+    void RenderGraph::addPass(const char* name, const SetupFn& setup, const ExecuteFn& execute)
+    {
+        Pass pass{};
+        PassBuilder builder(*this, m_passes.size());
+
+        pass.name = name;
+        pass.execute = execute;
+
+        m_passes.push_back(pass);
+        m_compiled = false;
+
+        setup(builder);
+    }
+
+    void RenderGraph::setOutput(ResourceHandle resource)
+    {
+        m_resources[resource].output = true;
+        m_compiled = false;
+    }
+
+    void RenderGraph::setOutput(ResourceHandle resource, ResourceUsage finalUsage)
+    {
+        setOutput(resource);
+        m_resources[resource].hasFinalUsage = true;
+        m_resources[resource].finalUsage = finalUsage;
+    }
+
+    void RenderGraph::compile()
+    {
+        std::vector<ResourceState> states;
+
+        cull();
+
+        for (auto& resource : m_resources) {
+            states.push_back(resource.initialState);
+        }
+
+        m_passBarriers.resize(m_passes.size());
+        m_barrierCount = 0;
+
+        for (size_t i = 0; i < m_passes.size(); i++) {
+            BarrierBatch& batch = m_passBarriers[i];
+
+            clearBatch(batch);
+
+            if (m_passes[i].culled) {
+                continue;
+            }
+
+            for (auto& passAccess : m_passes[i].accesses) {
+                bool image = m_resources[passAccess.resource].image != nullptr;
+
+                transition(batch, passAccess.resource, states[passAccess.resource], getAccess(passAccess.usage, passAccess.read, passAccess.write, image));
+            }
+        }
+
+        clearBatch(m_finalBarriers);
+
+        for (ResourceHandle i = 0; i < m_resources.size(); i++) {
+            if (m_resources[i].hasFinalUsage) {
+                transition(m_finalBarriers, i, states[i], getAccess(m_resources[i].finalUsage, true, false, m_resources[i].image != nullptr));
+            }
+
+            m_resources[i].finalState = states[i];
+            m_resources[i].finalLayout = states[i].layout;
+        }
+
+        m_compiled = true;
+    }
+
+    void RenderGraph::execute(VkCommandBuffer cmdBuffer)
+    {
+        if (!m_compiled) {
+            compile();
+        }
+
+        for (size_t i = 0; i < m_passes.size(); i++) {
+            if (m_passes[i].culled) {
+                continue;
+            }
+
+            record(cmdBuffer, m_passBarriers[i]);
+            m_passes[i].execute(cmdBuffer);
+        }
+
+        record(cmdBuffer, m_finalBarriers);
+
+        // sync1 masks are valid sync2 masks
+        for (auto& resource : m_resources) {
+            const ResourceState& state = resource.finalState;
+
+            if (resource.trackedImage != nullptr) {
+                resource.trackedImage->setState({ state.layout, state.writeStage | state.readStages, state.writeAccess | state.readAccess });
+            }
+        }
+    }
+
+    void RenderGraph::addAccess(size_t passIndex, ResourceHandle resource, ResourceUsage usage, bool write)
+    {
+        Pass& pass = m_passes[passIndex];
+        auto it = std::find_if(pass.accesses.begin(), pass.accesses.end(), [resource](const PassAccess& passAccess) {
+            return passAccess.resource == resource;
+        });
+
+        if (resource >= m_resources.size()) {
+            throw std::runtime_error("Cannot use an unknown resource in pass " + pass.name);
+        }
+
+        if (it == pass.accesses.end()) {
+            pass.accesses.push_back({ resource, usage, !write, write });
+            return;
+        }
+
+        // reading and writing the same resource is fine, it just has to be the same kind of usage
+        if (it->usage != usage) {
+            throw std::runtime_error("Cannot use " + m_resources[resource].name + " in two different ways in pass " + pass.name);
+        }
+
+        it->read |= !write;
+        it->write |= write;
+    }
+
+    void RenderGraph::cull()
+    {
+        std::vector<bool> needed(m_resources.size(), false);
+
+        for (size_t i = 0; i < m_resources.size(); i++) {
+            needed[i] = m_resources[i].output;
+        }
+
+        // Walk back from the outputs: a pass stays if a later pass (or the output) needs something it writes
+        m_culledPassCount = 0;
+
+        for (size_t i = m_passes.size(); i-- > 0;) {
+            Pass& pass = m_passes[i];
+
+            pass.culled = !pass.sideEffects && std::none_of(pass.accesses.begin(), pass.accesses.end(), [&](const PassAccess& passAccess) {
+                return passAccess.write && needed[passAccess.resource];
+            });
+
+            if (pass.culled) {
+                m_culledPassCount++;
+                continue;
+            }
+
+            // a pure write replaces the contents, whoever wrote them before isn't needed for this pass
+            for (auto& passAccess : pass.accesses) {
+                if (passAccess.write && !passAccess.read) {
+                    needed[passAccess.resource] = false;
+                }
+            }
+
+            for (auto& passAccess : pass.accesses) {
+                if (passAccess.read) {
+                    needed[passAccess.resource] = true;
+                }
+            }
+        }
+    }
+
+    void RenderGraph::transition(BarrierBatch& batch, ResourceHandle resource, ResourceState& state, const Access& access)
+    {
+        const Resource& res = m_resources[resource];
+        bool image = res.image != nullptr;
+        VkImageLayout oldLayout = state.layout;
+        VkPipelineStageFlags srcStage;
+        VkAccessFlags srcAccess;
+
+        if (access.write || (image && oldLayout != access.layout)) {
+            // write after write/read, layout transitions count as writes too
+            srcStage = state.writeStage | state.readStages;
+            srcAccess = state.writeAccess;
+
+            state.writeStage = access.stage;
+            state.writeAccess = access.write ? access.access : 0;
+            state.readStages = access.write ? 0 : access.stage;
+            state.readAccess = access.write ? 0 : access.access;
+            state.layout = access.layout;
+        }
+        else {
+            // read after write, nothing to do when this stage has already waited for the write
+            if ((access.stage & ~state.readStages) == 0 && (access.access & ~state.readAccess) == 0) {
+                return;
+            }
+
+            srcStage = state.writeStage;
+            srcAccess = state.writeAccess;
+
+            state.readStages |= access.stage;
+            state.readAccess |= access.access;
+
+            if (srcStage == VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT && srcAccess == 0) {
+                return; // never written since it was imported
+            }
+        }
+
+        batch.srcStage |= srcStage != 0 ? srcStage : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        batch.dstStage |= access.stage;
+
+        if (image) {
+            VkImageMemoryBarrier barrier{};
+
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcAccessMask = srcAccess;
+            barrier.dstAccessMask = access.access;
+            barrier.oldLayout = oldLayout;
+            barrier.newLayout = access.layout;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = res.image;
+            barrier.subresourceRange.aspectMask = res.aspect;
+            barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+            barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+            batch.imageBarriers.push_back(barrier);
+            m_barrierCount++;
+        }
+        else {
+            // buffers share one global memory barrier per batch
+            if (batch.memoryBarrier.srcAccessMask == 0 && batch.memoryBarrier.dstAccessMask == 0) {
+                m_barrierCount++;
+            }
+
+            batch.memoryBarrier.srcAccessMask |= srcAccess;
+            batch.memoryBarrier.dstAccessMask |= access.access;
+        }
+    }
+
+    void RenderGraph::record(VkCommandBuffer cmdBuffer, BarrierBatch& batch)
+    {
+        bool memoryBarrier = batch.memoryBarrier.srcAccessMask != 0 || batch.memoryBarrier.dstAccessMask != 0;
+
+        if (batch.srcStage == 0) {
+            return;
+        }
+
+        vkCmdPipelineBarrier(cmdBuffer,
+                             batch.srcStage,
+                             batch.dstStage,
+                             0,
+                             memoryBarrier ? 1 : 0,
+                             &batch.memoryBarrier,
+                             0,
+                             nullptr,
+                             static_cast<uint32_t>(batch.imageBarriers.size()),
+                             batch.imageBarriers.data());
+    }
+
+    RenderGraph::Access RenderGraph::getAccess(ResourceUsage usage, bool read, bool write, bool image)
+    {
+        Access access{};
+        VkAccessFlags shaderRead = image ? VK_ACCESS_SHADER_READ_BIT : VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT;
+
+        access.write = write;
+        access.layout = VK_IMAGE_LAYOUT_UNDEFINED; // buffers don't have one
+
+        switch (usage) {
+            case ResourceUsage::ColorAttachment:
+                access.stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+                access.access = (read ? VK_ACCESS_COLOR_ATTACHMENT_READ_BIT : 0) | (write ? VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT : 0);
+                access.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                break;
+            case ResourceUsage::DepthStencilAttachment:
+                access.stage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+                access.access = (read ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT : 0) | (write ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT : 0);
+                access.layout = write ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+                break;
+            case ResourceUsage::VertexShader:
+            case ResourceUsage::FragmentShader:
+            case ResourceUsage::ComputeShader:
+                access.stage = usage == ResourceUsage::VertexShader ? VK_PIPELINE_STAGE_VERTEX_SHADER_BIT :
+                               usage == ResourceUsage::FragmentShader ? VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT :
+                               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+                access.access = (read ? shaderRead : 0) | (write ? VK_ACCESS_SHADER_WRITE_BIT : 0);
+                access.layout = write ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+                break;
+            case ResourceUsage::Transfer:
+                access.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+                access.access = (read ? VK_ACCESS_TRANSFER_READ_BIT : 0) | (write ? VK_ACCESS_TRANSFER_WRITE_BIT : 0);
+                access.layout = read && write ? VK_IMAGE_LAYOUT_GENERAL :
+                                write ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL :
+                                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+                break;
+            case ResourceUsage::VertexBuffer:
+                access.stage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+                access.access = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+                break;
+            case ResourceUsage::IndexBuffer:
+                access.stage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+                access.access = VK_ACCESS_INDEX_READ_BIT;
+                break;
+            case ResourceUsage::IndirectBuffer:
+                access.stage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+                access.access = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+                break;
+            case ResourceUsage::Present:
+                // the present semaphore takes care of the rest, the transition only has to happen before the submission ends
+                access.stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+                access.access = 0;
+                access.layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+                break;
+        }
+
+        if (!image) {
+            access.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        }
+
+        return access;
+    }
+
+    void RenderGraph::clearBatch(BarrierBatch& batch)
+    {
+        batch.srcStage = 0;
+        batch.dstStage = 0;
+        batch.memoryBarrier = {};
+        batch.memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        batch.imageBarriers.clear();
+    }
+}
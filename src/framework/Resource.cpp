@@ -1,10 +1,12 @@
 #include "stb/stb_image.h"
 #include <framework/Resource.h>
+#include <framework/CpuProfiler.h>
 
 namespace frm
 {
     bool Resource::loadBinary(const std::string& filepath, std::vector<uint8_t>& blob)
     {
+        FRM_CPU_SCOPE("loadBinary");
         std::ifstream file(filepath, std::ios::binary);
         size_t size = 0;
 
@@ -24,6 +26,7 @@ namespace frm
 
     bool Resource::loadImage(const std::string& filepath, ImageData& blob, int channelCount)
     {
+        FRM_CPU_SCOPE("loadImage");
         uint8_t* data = stbi_load(filepath.c_str(), &blob.width, &blob.height, &blob.channelCount, channelCount);
         size_t size = (size_t)blob.width * blob.height * blob.channelCount;
 
@@ -0,0 +1,62 @@
+#include <framework/ThreadPool.h>
+#include <framework/CpuProfiler.h>
+
+namespace frm
+{
+    ThreadPool::ThreadPool(uint32_t threadCount) :
+        m_stop(false)
+    {
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        for (uint32_t i = 0; i < threadCount; i++) {
+            m_threads.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+
+        m_jobAvailable.notify_all();
+
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    bool ThreadPool::isWorkerThread() const
+    {
+        auto id = std::this_thread::get_id();
+
+        return std::any_of(m_threads.begin(), m_threads.end(), [id](const std::thread& thread) { return thread.get_id() == id; });
+    }
+
+    void ThreadPool::workerLoop()
+    {
+        FRM_CPU_THREAD_NAME("Worker");
+
+        while (true) {
+            std::function<void()> job;
+
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+
+                m_jobAvailable.wait(lock, [this]() { return m_stop || !m_jobs.empty(); });
+
+                if (m_jobs.empty()) {
+                    return; // stopped and drained
+                }
+
+                job = std::move(m_jobs.front());
+                m_jobs.pop();
+            }
+
+            job();
+        }
+    }
+}
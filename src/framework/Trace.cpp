@@ -0,0 +1,144 @@
+#include <framework/Trace.h>
+#include <iomanip>
+
+namespace frm
+{
+    const uint32_t TraceWriter::g_cpuProcess;
+    const uint32_t TraceWriter::g_gpuProcess;
+    const size_t TraceWriter::g_defaultMaxEvents;
+
+    TraceWriter::TraceWriter(size_t maxEvents) :
+        m_maxEvents(maxEvents),
+        m_droppedCount(0)
+    {
+    }
+
+    void TraceWriter::add(const TraceEvent& event)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_events.size() >= m_maxEvents) {
+            m_droppedCount++;
+            return;
+        }
+
+        m_events.push_back(event);
+    }
+
+    void TraceWriter::add(const std::vector<TraceEvent>& events)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t count = std::min(events.size(), m_maxEvents - std::min(m_events.size(), m_maxEvents));
+
+        m_events.insert(m_events.end(), events.begin(), events.begin() + count);
+        m_droppedCount += events.size() - count;
+    }
+
+    void TraceWriter::setThreadName(uint32_t pid, uint32_t tid, const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (auto& threadName : m_threadNames) {
+            if (threadName.pid == pid && threadName.tid == tid) {
+                threadName.name = name;
+                return;
+            }
+        }
+
+        m_threadNames.push_back({ pid, tid, name });
+    }
+
+    size_t TraceWriter::getEventCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        return m_events.size();
+    }
+
+    uint64_t TraceWriter::getDroppedCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        return m_droppedCount;
+    }
+
+    bool TraceWriter::write(const std::string& path) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::ofstream file(path, std::ios::out | std::ios::trunc);
+        int64_t origin = INT64_MAX;
+
+        if (!file.is_open()) {
+            return false;
+        }
+
+        // timestamps relative to the first event keep the microsecond values short
+        for (auto& event : m_events) {
+            origin = std::min(origin, event.start);
+        }
+
+        file << "{\"traceEvents\":[\n";
+
+        file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << g_cpuProcess << ",\"args\":{\"name\":\"CPU\"}},\n";
+        file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << g_gpuProcess << ",\"args\":{\"name\":\"GPU\"}}";
+
+        for (auto& threadName : m_threadNames) {
+            file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << threadName.pid << ",\"tid\":" << threadName.tid << ",\"args\":{\"name\":";
+            writeString(file, threadName.name.c_str());
+            file << "}}";
+        }
+
+        file << std::fixed << std::setprecision(3);
+
+        for (auto& event : m_events) {
+            file << ",\n{\"name\":";
+            writeString(file, event.name);
+            file << ",\"cat\":";
+            writeString(file, event.category);
+            file << ",\"ph\":\"X\",\"pid\":" << event.pid
+                 << ",\"tid\":" << event.tid
+                 << ",\"ts\":" << static_cast<double>(event.start - origin) / 1000.0
+                 << ",\"dur\":" << static_cast<double>(event.duration) / 1000.0 << "}";
+        }
+
+        file << "\n]}\n";
+
+        return file.good();
+    }
+
+    int64_t TraceWriter::now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void TraceWriter::writeString(std::ostream& stream, const char* str)
+    {
+        stream << '"';
+
+        for (; *str != '\0'; str++) {
+            unsigned char c = static_cast<unsigned char>(*str);
+
+            if (c == '"' || c == '\\') {
+                stream << '\\' << *str;
+            }
+            else if (c == '\n') {
+                stream << "\\n";
+            }
+            else if (c == '\t') {
+                stream << "\\t";
+            }
+            else if (c < 0x20) {
+                // other control characters aren't allowed in JSON strings either
+                char escaped[8];
+
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                stream << escaped;
+            }
+            else {
+                stream << *str;
+            }
+        }
+
+        stream << '"';
+    }
+}
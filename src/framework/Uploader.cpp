@@ -0,0 +1,293 @@
+#include <framework/Uploader.h>
+
+namespace frm
+{
+    Uploader::Uploader(VulkanContext& context) :
+        m_context(context),
+        m_transferPool(nullptr),
+        m_acquirePool(nullptr)
+    {
+        m_context.createCommandPool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, &m_transferPool, QueueType::Transfer);
+        m_context.createCommandPool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, &m_acquirePool, QueueType::Graphics);
+    }
+
+    Uploader::~Uploader()
+    {
+        VkDevice device = m_context.getDevice();
+
+        for (auto& batch : m_batches) {
+            m_context.wait(batch.ticket);
+        }
+
+        collect();
+
+        vkDestroyCommandPool(device, m_acquirePool, nullptr);
+        vkDestroyCommandPool(device, m_transferPool, nullptr);
+    }
+
+    void Uploader::uploadBuffer(const BufferResourceRef& dst,
+                                const void* data,
+                                VkDeviceSize size,
+                                VkDeviceSize dstOffset,
+                                VkPipelineStageFlags dstStage,
+                                VkAccessFlags dstAccess)
+    {
+        PendingBuffer pending{};
+
+        pending.dst = dst;
+        pending.size = size;
+        pending.dstOffset = dstOffset;
+        pending.dstStage = dstStage;
+        pending.dstAccess = dstAccess;
+
+        createStaging(data, size, pending.staging);
+        m_pendingBuffers.push_back(pending);
+    }
+
+    void Uploader::uploadImage(const ImageResourceRef& dst,
+                               const void* data,
+                               VkDeviceSize size,
+                               uint32_t width,
+                               uint32_t height,
+                               VkImageLayout dstLayout,
+                               VkPipelineStageFlags dstStage,
+                               VkAccessFlags dstAccess)
+    {
+        PendingImage pending{};
+
+        pending.dst = dst;
+        pending.width = width;
+        pending.height = height;
+        pending.dstLayout = dstLayout;
+        pending.dstStage = dstStage;
+        pending.dstAccess = dstAccess;
+
+        createStaging(data, size, pending.staging);
+        m_pendingImages.push_back(pending);
+    }
+
+    SubmitTicket Uploader::flush()
+    {
+        VkDevice device = m_context.getDevice();
+        bool ownershipTransfer = m_context.hasDedicatedQueue(QueueType::Transfer);
+        uint32_t srcQueueFamily = ownershipTransfer ? m_context.getQueueIndex(QueueType::Transfer) : VK_QUEUE_FAMILY_IGNORED;
+        uint32_t dstQueueFamily = ownershipTransfer ? m_context.getQueueIndex(QueueType::Graphics) : VK_QUEUE_FAMILY_IGNORED;
+        VkPipelineStageFlags dstStages = 0;
+        std::vector<VkImageMemoryBarrier> copyBarriers;
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+        std::vector<VkBufferMemoryBarrier> bufferBarriers;
+        VkCommandBufferAllocateInfo cmdBufferInfo{};
+        VkCommandBufferBeginInfo beginInfo{};
+        VkSubmitInfo submit{};
+        Batch batch{};
+
+        collect();
+
+        if (m_pendingBuffers.empty() && m_pendingImages.empty()) {
+            return m_lastTicket;
+        }
+
+        batch.buffers.swap(m_pendingBuffers);
+        batch.images.swap(m_pendingImages);
+
+        // Barriers for the copy itself, and the ones that hand the resources over to the graphics queue.
+        // With an ownership transfer, the same barriers are recorded twice: as a release on the transfer
+        // queue (dst access ignored) and as an acquire on the graphics queue (src access ignored).
+        for (auto& img : batch.images) {
+            VkImageMemoryBarrier barrier{};
+
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = img.dst->get();
+            // the whole image, so every subresource ends up in the state recorded below
+            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            barrier.subresourceRange.baseMipLevel = 0;
+            barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+            barrier.subresourceRange.baseArrayLayer = 0;
+            barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+            copyBarriers.push_back(barrier);
+
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = img.dstAccess;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = img.dstLayout;
+            barrier.srcQueueFamilyIndex = srcQueueFamily;
+            barrier.dstQueueFamilyIndex = dstQueueFamily;
+
+            imageBarriers.push_back(barrier);
+            dstStages |= img.dstStage;
+
+            // what ImageTracker and RenderGraph see once the upload is done, sync1 masks are valid sync2 masks
+            img.dst->setState({ img.dstLayout, img.dstStage, img.dstAccess });
+        }
+
+        for (auto& buf : batch.buffers) {
+            VkBufferMemoryBarrier barrier{};
+
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = buf.dstAccess;
+            barrier.srcQueueFamilyIndex = srcQueueFamily;
+            barrier.dstQueueFamilyIndex = dstQueueFamily;
+            barrier.buffer = buf.dst->get();
+            barrier.offset = buf.dstOffset;
+            barrier.size = buf.size;
+
+            bufferBarriers.push_back(barrier);
+            dstStages |= buf.dstStage;
+        }
+
+        cmdBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        cmdBufferInfo.commandPool = m_transferPool;
+        cmdBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        cmdBufferInfo.commandBufferCount = 1;
+
+        if (VK_FAILED(vkAllocateCommandBuffers(device, &cmdBufferInfo, &batch.transferCmd))) {
+            throw std::runtime_error("Cannot create upload command buffer");
+        }
+
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        vkBeginCommandBuffer(batch.transferCmd, &beginInfo);
+
+        if (!copyBarriers.empty()) {
+            vkCmdPipelineBarrier(batch.transferCmd,
+                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0,
+                0,
+                nullptr,
+                0,
+                nullptr,
+                static_cast<uint32_t>(copyBarriers.size()),
+                copyBarriers.data());
+        }
+
+        for (auto& buf : batch.buffers) {
+            VkBufferCopy region{};
+            region.srcOffset = 0;
+            region.dstOffset = buf.dstOffset;
+            region.size = buf.size;
+
+            vkCmdCopyBuffer(batch.transferCmd, buf.staging->get(), buf.dst->get(), 1, &region);
+        }
+
+        for (auto& img : batch.images) {
+            VkBufferImageCopy region{};
+            region.bufferOffset = 0;
+            region.bufferRowLength = 0; // tightly packed
+            region.bufferImageHeight = 0;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = 0;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = 1;
+            region.imageExtent.width = img.width;
+            region.imageExtent.height = img.height;
+            region.imageExtent.depth = 1;
+
+            vkCmdCopyBufferToImage(batch.transferCmd, img.staging->get(), img.dst->get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        }
+
+        // Release. The transfer queue may not support the consumer stages, the acquire side takes care of them.
+        vkCmdPipelineBarrier(batch.transferCmd,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            ownershipTransfer ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : dstStages,
+            0,
+            0,
+            nullptr,
+            static_cast<uint32_t>(bufferBarriers.size()),
+            bufferBarriers.data(),
+            static_cast<uint32_t>(imageBarriers.size()),
+            imageBarriers.data());
+        vkEndCommandBuffer(batch.transferCmd);
+
+        submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit.commandBufferCount = 1;
+        submit.pCommandBuffers = &batch.transferCmd;
+
+        batch.ticket = m_context.queueSubmitAsync(QueueType::Transfer, submit);
+
+        if (ownershipTransfer) {
+            // Acquire on the graphics queue. The submission waits on the GPU for the transfer queue,
+            // the CPU and the frames already queued on the graphics queue are not blocked.
+            for (auto& barrier : imageBarriers) {
+                barrier.srcAccessMask = 0;
+            }
+
+            for (auto& barrier : bufferBarriers) {
+                barrier.srcAccessMask = 0;
+            }
+
+            cmdBufferInfo.commandPool = m_acquirePool;
+
+            if (VK_FAILED(vkAllocateCommandBuffers(device, &cmdBufferInfo, &batch.acquireCmd))) {
+                throw std::runtime_error("Cannot create upload acquire command buffer");
+            }
+
+            vkBeginCommandBuffer(batch.acquireCmd, &beginInfo);
+            vkCmdPipelineBarrier(batch.acquireCmd,
+                dstStages,
+                dstStages,
+                0,
+                0,
+                nullptr,
+                static_cast<uint32_t>(bufferBarriers.size()),
+                bufferBarriers.data(),
+                static_cast<uint32_t>(imageBarriers.size()),
+                imageBarriers.data());
+            vkEndCommandBuffer(batch.acquireCmd);
+
+            submit.pCommandBuffers = &batch.acquireCmd;
+
+            batch.ticket = m_context.queueSubmitAsync(QueueType::Graphics, submit, { { batch.ticket, dstStages } });
+        }
+
+        m_lastTicket = batch.ticket;
+        m_batches.push_back(std::move(batch));
+
+        return m_lastTicket;
+    }
+
+    void Uploader::collect()
+    {
+        VkDevice device = m_context.getDevice();
+
+        for (auto it = m_batches.begin(); it != m_batches.end();) {
+            if (!m_context.isComplete(it->ticket)) {
+                ++it;
+                continue;
+            }
+
+            vkFreeCommandBuffers(device, m_transferPool, 1, &it->transferCmd);
+
+            if (it->acquireCmd != nullptr) {
+                vkFreeCommandBuffers(device, m_acquirePool, 1, &it->acquireCmd);
+            }
+
+            it = m_batches.erase(it); // drops the staging buffers
+        }
+    }
+
+    void Uploader::createStaging(const void* data, VkDeviceSize size, BufferResourceRef& staging)
+    {
+        VkBufferCreateInfo stagingInfo{};
+        void* mapped = nullptr;
+
+        stagingInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        stagingInfo.size = size;
+        stagingInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+        m_context.createBuffer(stagingInfo, VMA_MEMORY_USAGE_CPU_ONLY, staging);
+
+        staging->map(&mapped);
+        std::memcpy(mapped, data, static_cast<size_t>(size));
+        staging->unmap();
+    }
+}
@@ -1,22 +1,123 @@
 #include <framework/VulkanContext.h>
+#include <framework/Uploader.h>
+#include <framework/GpuProfiler.h>
+#include <framework/CpuProfiler.h>
+#include <framework/ObjectCache.h>
+#include <framework/DescriptorAllocator.h>
+#include <framework/BindlessTable.h>
+#include <framework/CommandAllocator.h>
+#include <framework/Resource.h>
 
 namespace frm
 {
+    // Semaphore values of a submission. They come from a VkTimelineSemaphoreSubmitInfo the caller chained,
+    // 0 (ignored for binary semaphores) otherwise. Returns the rest of the pNext chain, without the caller's
+    // timeline info since the submit functions chain their own with the merged values.
+    static const void* getSubmitValues(const VkSubmitInfo& submitInfo, std::vector<uint64_t>& waitValues, std::vector<uint64_t>& signalValues)
+    {
+        auto first = static_cast<const VkBaseInStructure*>(submitInfo.pNext);
+        const VkTimelineSemaphoreSubmitInfo* callerInfo;
+
+        waitValues.assign(submitInfo.waitSemaphoreCount, 0);
+        signalValues.assign(submitInfo.signalSemaphoreCount, 0);
+
+        if (first == nullptr || first->sType != VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO) {
+            // the chain is const, a timeline info further down can't be taken out of it
+            for (auto next = first; next != nullptr; next = next->pNext) {
+                if (next->sType == VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO) {
+                    throw std::runtime_error("Cannot submit, VkTimelineSemaphoreSubmitInfo must come first in pNext");
+                }
+            }
+
+            return submitInfo.pNext;
+        }
+
+        callerInfo = reinterpret_cast<const VkTimelineSemaphoreSubmitInfo*>(first);
+
+        if ((callerInfo->waitSemaphoreValueCount != 0 && callerInfo->waitSemaphoreValueCount != submitInfo.waitSemaphoreCount) ||
+            (callerInfo->signalSemaphoreValueCount != 0 && callerInfo->signalSemaphoreValueCount != submitInfo.signalSemaphoreCount)) {
+            throw std::runtime_error("Cannot submit, VkTimelineSemaphoreSubmitInfo value counts don't match the semaphore counts");
+        }
+
+        if (callerInfo->waitSemaphoreValueCount != 0) {
+            waitValues.assign(callerInfo->pWaitSemaphoreValues, callerInfo->pWaitSemaphoreValues + callerInfo->waitSemaphoreValueCount);
+        }
+
+        if (callerInfo->signalSemaphoreValueCount != 0) {
+            signalValues.assign(callerInfo->pSignalSemaphoreValues, callerInfo->pSignalSemaphoreValues + callerInfo->signalSemaphoreValueCount);
+        }
+
+        return callerInfo->pNext;
+    }
+
+    // Waits for the whole batch even after a failure, so no worker is still creating a pipeline
+    // when the finished ones are destroyed. Rethrows the first error.
+    static void waitForPipelines(VkDevice device, std::vector<std::future<VkPipeline>>& futures, std::vector<VkPipeline>& pipelines)
+    {
+        std::exception_ptr error;
+
+        pipelines.clear();
+        pipelines.reserve(futures.size());
+
+        for (auto& future : futures) {
+            try {
+                pipelines.push_back(future.get());
+            }
+            catch (...) {
+                if (error == nullptr) {
+                    error = std::current_exception();
+                }
+            }
+        }
+
+        if (error != nullptr) {
+            for (auto pipeline : pipelines) {
+                vkDestroyPipeline(device, pipeline, nullptr);
+            }
+
+            pipelines.clear();
+            std::rethrow_exception(error);
+        }
+    }
+
     VulkanContext::VulkanContext() :
         m_instance(nullptr),
         m_physicalDevice(nullptr),
         m_pdFeatures(),
+        m_pdProperties(),
+        m_pdMemoryProperties(),
         m_surface(nullptr),
         m_device(nullptr),
         m_allocator(nullptr),
-        m_deviceQueue(nullptr),
-        m_deviceQueueIndex(0),
+        m_queues(),
+        m_window(nullptr),
         m_swapchain(nullptr),
-        m_swapbufferAvailable(nullptr),
-        m_submitFence(nullptr),
+        m_swapchainExtent(),
+        m_presentMode(VK_PRESENT_MODE_FIFO_KHR),
+        m_requestedPresentMode(VK_PRESENT_MODE_FIFO_KHR),
+        m_requestedSwapbufferCount(3),
+        m_swapchainGeneration(0),
+        m_swapchainDirty(false),
+        m_swapchainInitPool(nullptr),
+        m_swapchainInitCmd(nullptr),
+        m_virtualSwapbufferIndex(0),
+        m_currentFrame(0),
+        m_memoryTotals(std::make_shared<MemoryTotals>()),
+        m_allocatorFrame(0),
+        m_pipelineCache(nullptr),
+        m_pipelineCacheLoaded(false),
+        m_pipelineCreateTime(0.0),
+        m_pipelineBatchTime(0.0),
+        m_pipelineCreateCount(0),
+        m_submitTime(0.0),
+        m_submitCount(0),
+        m_features(),
+        m_functions(),
+        m_validation(false),
+        m_gpuProfiling(false),
+        m_headless(false),
         m_initialized(false)
     {
-        init();
     }
 
     VulkanContext::~VulkanContext()
@@ -24,30 +125,67 @@ namespace frm
         shutdown();
     }
 
-    void VulkanContext::initDevice(SDL_Window* window)
+    void VulkanContext::initDevice(SDL_Window* window, uint32_t framesInFlight)
     {
-        static const float queuePriority = 1.0f;
-        uint32_t queueFamilyCount;
-        std::vector<VkQueueFamilyProperties> queueFamilyProps;
-        uint32_t currentQueueIndex = 0;
-        uint32_t graphicsQueueIndex = -1;
-        std::vector<VkLayerProperties> layerExts;
-        std::vector<VkExtensionProperties> deviceExts;
-        VkDeviceQueueCreateInfo queueCreateInfo{};
-        VkDeviceCreateInfo deviceInfo{};
-        VmaAllocatorCreateInfo allocatorInfo{};
-        VkFenceCreateInfo fenceInfo{};
-
         if (m_initialized) {
             return;
         }
 
+        m_window = window;
+        m_headless = false;
+
+        init();
+
         // create surface
         if (!SDL_Vulkan_CreateSurface(window, m_instance, &m_surface)) {
             throw std::runtime_error("Cannot create surface");
         }
 
-        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_physicalDevice, m_surface, &m_surfaceCaps);
+        createDevice(framesInFlight);
+    }
+
+    void VulkanContext::initHeadlessDevice(uint32_t width, uint32_t height, uint32_t framesInFlight)
+    {
+        if (m_initialized) {
+            return;
+        }
+
+        m_headless = true;
+        m_swapchainExtent.width = width;
+        m_swapchainExtent.height = height;
+
+        init();
+        createDevice(framesInFlight);
+    }
+
+    void VulkanContext::createDevice(uint32_t framesInFlight)
+    {
+        static const float queuePriority = 1.0f;
+        uint32_t queueFamilyCount;
+        std::vector<VkQueueFamilyProperties> queueFamilyProps;
+        uint32_t currentQueueIndex = 0;
+        uint32_t graphicsQueueIndex = -1;
+        uint32_t transferQueueIndex = -1;
+        uint32_t computeQueueIndex = -1;
+        std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+        VkDeviceCreateInfo deviceInfo{};
+        VmaAllocatorCreateInfo allocatorInfo{};
+        VkPhysicalDeviceFeatures2 supportedFeatures{};
+        VkPhysicalDeviceVulkan12Features supportedFeatures12{};
+        VkPhysicalDeviceVulkan12Features features12{};
+        VkPhysicalDeviceSynchronization2FeaturesKHR supportedSync2{};
+        VkPhysicalDeviceSynchronization2FeaturesKHR sync2{};
+        VkPhysicalDeviceDynamicRenderingFeaturesKHR supportedDynamicRendering{};
+        VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRendering{};
+        VkPhysicalDeviceExtendedDynamicStateFeaturesEXT supportedDynamicState{};
+        VkPhysicalDeviceExtendedDynamicStateFeaturesEXT dynamicState{};
+        VkPhysicalDeviceExtendedDynamicState2FeaturesEXT supportedDynamicState2{};
+        VkPhysicalDeviceExtendedDynamicState2FeaturesEXT dynamicState2{};
+        VkPhysicalDeviceExtendedDynamicState3FeaturesEXT supportedDynamicState3{};
+        VkPhysicalDeviceExtendedDynamicState3FeaturesEXT dynamicState3{};
+        void** featureChain;
+        std::vector<const char*> layers;
+        std::vector<const char*> extensions;
 
         // query physical device queue families
         vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queueFamilyCount, nullptr);
@@ -56,9 +194,11 @@ namespace frm
 
         // find graphics queue
         for (auto& qf : queueFamilyProps) {
-            VkBool32 presentQueueSupported;
+            VkBool32 presentQueueSupported = VK_TRUE; // nothing to present to when headless
 
-            vkGetPhysicalDeviceSurfaceSupportKHR(m_physicalDevice, currentQueueIndex, m_surface, &presentQueueSupported);
+            if (m_surface != nullptr) {
+                vkGetPhysicalDeviceSurfaceSupportKHR(m_physicalDevice, currentQueueIndex, m_surface, &presentQueueSupported);
+            }
 
             if ((qf.queueFlags & VK_QUEUE_GRAPHICS_BIT) && presentQueueSupported) {
                 graphicsQueueIndex = currentQueueIndex;
@@ -72,33 +212,233 @@ namespace frm
             throw std::runtime_error("No graphics queue found!");
         }
 
-        m_deviceQueueIndex = graphicsQueueIndex;
+        // find dedicated transfer queue, these families are usually backed by DMA engines
+        // that can copy data while the graphics queue keeps rendering
+        currentQueueIndex = 0;
+
+        for (auto& qf : queueFamilyProps) {
+            if ((qf.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(qf.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+                transferQueueIndex = currentQueueIndex;
+                break;
+            }
+
+            currentQueueIndex++;
+        }
+
+        if (transferQueueIndex == -1) {
+            transferQueueIndex = graphicsQueueIndex; // no dedicated transfer queue, share the graphics queue
+        }
+
+        // find async compute queue, work submitted there can overlap with rasterization on the graphics queue
+        currentQueueIndex = 0;
+
+        for (auto& qf : queueFamilyProps) {
+            if ((qf.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(qf.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+                computeQueueIndex = currentQueueIndex;
+                break;
+            }
+
+            currentQueueIndex++;
+        }
+
+        if (computeQueueIndex == -1) {
+            computeQueueIndex = graphicsQueueIndex; // graphics queues always support compute
+        }
+
+        // prepare queue create info, one queue for each distinct family
+        for (uint32_t familyIndex : { graphicsQueueIndex, transferQueueIndex, computeQueueIndex }) {
+            VkDeviceQueueCreateInfo queueCreateInfo{};
+
+            if (std::any_of(queueCreateInfos.begin(), queueCreateInfos.end(),
+                            [familyIndex](const VkDeviceQueueCreateInfo& info) { return info.queueFamilyIndex == familyIndex; })) {
+                continue;
+            }
+
+            queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+            queueCreateInfo.queueFamilyIndex = familyIndex;
+            queueCreateInfo.queueCount = 1;
+            queueCreateInfo.pQueuePriorities = &queuePriority;
+
+            queueCreateInfos.push_back(queueCreateInfo);
+        }
+
+        // device extensions, the swapchain is enabled headless too so VK_IMAGE_LAYOUT_PRESENT_SRC_KHR stays valid
+        m_caps.queryDevice(m_physicalDevice);
+        m_caps.requestDeviceExtension(VK_KHR_SWAPCHAIN_EXTENSION_NAME, !m_headless);
+
+        // query the optional features, extension structures may only be chained when the extension exists
+        supportedFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        supportedSync2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+        supportedDynamicRendering.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+        supportedDynamicState.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+        supportedDynamicState2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT;
+        supportedDynamicState3.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+        supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        supportedFeatures.pNext = &supportedFeatures12;
+        featureChain = &supportedFeatures12.pNext;
+
+        if (m_caps.isDeviceExtensionAvailable(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) {
+            *featureChain = &supportedSync2;
+            featureChain = &supportedSync2.pNext;
+        }
+
+        if (m_caps.isDeviceExtensionAvailable(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)) {
+            *featureChain = &supportedDynamicRendering;
+            featureChain = &supportedDynamicRendering.pNext;
+        }
+
+        if (m_caps.isDeviceExtensionAvailable(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)) {
+            *featureChain = &supportedDynamicState;
+            featureChain = &supportedDynamicState.pNext;
+        }
+
+        if (m_caps.isDeviceExtensionAvailable(VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME)) {
+            *featureChain = &supportedDynamicState2;
+            featureChain = &supportedDynamicState2.pNext;
+        }
+
+        if (m_caps.isDeviceExtensionAvailable(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME)) {
+            *featureChain = &supportedDynamicState3;
+            featureChain = &supportedDynamicState3.pNext;
+        }
+
+        vkGetPhysicalDeviceFeatures2(m_physicalDevice, &supportedFeatures);
+
+        // timeline semaphores back the asynchronous submit tickets, they are the only hard requirement
+        if (!supportedFeatures12.timelineSemaphore) {
+            throw std::runtime_error("Timeline semaphores are not supported");
+        }
+
+        features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        features12.timelineSemaphore = VK_TRUE;
+        featureChain = &features12.pNext;
+        m_features.timelineSemaphore = true;
+
+        if (supportedFeatures12.hostQueryReset) {
+            features12.hostQueryReset = VK_TRUE;
+            m_features.hostQueryReset = true;
+        }
+
+        if (supportedSync2.synchronization2 && m_caps.requestDeviceExtension(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) {
+            sync2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+            sync2.synchronization2 = VK_TRUE;
+            *featureChain = &sync2;
+            featureChain = &sync2.pNext;
+            m_features.synchronization2 = true;
+        }
+
+        if (supportedDynamicRendering.dynamicRendering && m_caps.requestDeviceExtension(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)) {
+            dynamicRendering.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+            dynamicRendering.dynamicRendering = VK_TRUE;
+            *featureChain = &dynamicRendering;
+            featureChain = &dynamicRendering.pNext;
+            m_features.dynamicRendering = true;
+        }
+
+        // Extended dynamic state turns baked pipeline state into commands, so one pipeline covers what used to be
+        // several permutations. Each level only builds on the previous one.
+        if (supportedDynamicState.extendedDynamicState && m_caps.requestDeviceExtension(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)) {
+            dynamicState.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+            dynamicState.extendedDynamicState = VK_TRUE;
+            *featureChain = &dynamicState;
+            featureChain = &dynamicState.pNext;
+            m_features.extendedDynamicState = true;
+        }
+
+        if (m_features.extendedDynamicState &&
+            supportedDynamicState2.extendedDynamicState2 &&
+            m_caps.requestDeviceExtension(VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME)) {
+            dynamicState2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT;
+            dynamicState2.extendedDynamicState2 = VK_TRUE;
+            *featureChain = &dynamicState2;
+            featureChain = &dynamicState2.pNext;
+            m_features.extendedDynamicState2 = true;
+        }
+
+        if (m_features.extendedDynamicState2 &&
+            supportedDynamicState3.extendedDynamicState3PolygonMode &&
+            supportedDynamicState3.extendedDynamicState3ColorBlendEnable &&
+            supportedDynamicState3.extendedDynamicState3ColorWriteMask &&
+            m_caps.requestDeviceExtension(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME)) {
+            dynamicState3.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+            dynamicState3.extendedDynamicState3PolygonMode = VK_TRUE;
+            dynamicState3.extendedDynamicState3ColorBlendEnable = VK_TRUE;
+            dynamicState3.extendedDynamicState3ColorWriteMask = VK_TRUE;
+            *featureChain = &dynamicState3;
+            featureChain = &dynamicState3.pNext;
+            m_features.extendedDynamicState3 = true;
+        }
+
+        // descriptor indexing is core in 1.2, the bindless table needs these four
+        if (supportedFeatures12.runtimeDescriptorArray &&
+            supportedFeatures12.descriptorBindingPartiallyBound &&
+            supportedFeatures12.descriptorBindingSampledImageUpdateAfterBind &&
+            supportedFeatures12.descriptorBindingUpdateUnusedWhilePending) {
+            features12.descriptorIndexing = supportedFeatures12.descriptorIndexing;
+            features12.shaderSampledImageArrayNonUniformIndexing = supportedFeatures12.shaderSampledImageArrayNonUniformIndexing;
+            features12.runtimeDescriptorArray = VK_TRUE;
+            features12.descriptorBindingPartiallyBound = VK_TRUE;
+            features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+            features12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+            m_features.descriptorIndexing = true;
+        }
+
+        m_features.memoryBudget = m_caps.requestDeviceExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
 
-        // prepare queue create info
-        queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-        queueCreateInfo.queueFamilyIndex = m_deviceQueueIndex;
-        queueCreateInfo.queueCount = 1;
-        queueCreateInfo.pQueuePriorities = &queuePriority;
+        // device layers are deprecated, but older loaders still expect the instance layers here
+        m_caps.getEnabledLayers(layers);
+        m_caps.getEnabledDeviceExtensions(extensions);
 
         // create logical device
         deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-        deviceInfo.queueCreateInfoCount = 1;
-        deviceInfo.pQueueCreateInfos = &queueCreateInfo; // the queue we want to create
-        deviceInfo.enabledLayerCount = GET_ARRAY_SIZE(g_deviceLayers);
-        deviceInfo.ppEnabledLayerNames = g_deviceLayers;
-        deviceInfo.enabledExtensionCount = GET_ARRAY_SIZE(g_deviceExtensions);
-        deviceInfo.ppEnabledExtensionNames = g_deviceExtensions;
+        deviceInfo.pNext = &features12;
+        deviceInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
+        deviceInfo.pQueueCreateInfos = queueCreateInfos.data(); // the queues we want to create
+        deviceInfo.enabledLayerCount = static_cast<uint32_t>(layers.size());
+        deviceInfo.ppEnabledLayerNames = layers.data();
+        deviceInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        deviceInfo.ppEnabledExtensionNames = extensions.data();
         deviceInfo.pEnabledFeatures = &m_pdFeatures;
 
         if (VK_FAILED(vkCreateDevice(m_physicalDevice, &deviceInfo, nullptr, &m_device))) {
             throw std::runtime_error("Cannot create device");
         }
 
-        // get our graphics queue from logical device
-        vkGetDeviceQueue(m_device, graphicsQueueIndex, 0, &m_deviceQueue);
+        loadDeviceFunctions();
+
+        std::cout << "Validation: " << (isValidationEnabled() ? "on" : "off")
+                  << ", synchronization2: " << (m_features.synchronization2 ? "on" : "off")
+                  << ", dynamic rendering: " << (m_features.dynamicRendering ? "on" : "off")
+                  << ", memory budget: " << (m_features.memoryBudget ? "on" : "off")
+                  << ", descriptor indexing: " << (m_features.descriptorIndexing ? "on" : "off")
+                  << ", extended dynamic state: " << (m_features.extendedDynamicState3 ? 3 : m_features.extendedDynamicState2 ? 2 : m_features.extendedDynamicState ? 1 : 0) << std::endl;
+
+        // get our queues from logical device
+        QueueContext& graphicsQueue = m_queues[static_cast<size_t>(QueueType::Graphics)];
+        QueueContext& transferQueue = m_queues[static_cast<size_t>(QueueType::Transfer)];
+        QueueContext& computeQueue = m_queues[static_cast<size_t>(QueueType::Compute)];
+
+        graphicsQueue.familyIndex = graphicsQueueIndex;
+        transferQueue.familyIndex = transferQueueIndex;
+        computeQueue.familyIndex = computeQueueIndex;
+        vkGetDeviceQueue(m_device, graphicsQueue.familyIndex, 0, &graphicsQueue.queue);
+        vkGetDeviceQueue(m_device, transferQueue.familyIndex, 0, &transferQueue.queue);
+        vkGetDeviceQueue(m_device, computeQueue.familyIndex, 0, &computeQueue.queue);
+
+        // queue types that fall back to the same VkQueue also share its lock
+        for (size_t i = 0; i < static_cast<size_t>(QueueType::Count); i++) {
+            size_t owner = 0;
+
+            while (m_queues[owner].queue != m_queues[i].queue) {
+                owner++;
+            }
+
+            m_queues[i].submitMutex = &m_queueMutexes[owner];
+        }
 
         // create memory allocator, used to allocate GPU resources such as buffer
         allocatorInfo.vulkanApiVersion = VK_API_VERSION_1_2;
+        allocatorInfo.flags = m_features.memoryBudget ? VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT : 0;
         allocatorInfo.physicalDevice = m_physicalDevice;
         allocatorInfo.device = m_device;
         allocatorInfo.instance = m_instance;
@@ -107,34 +447,193 @@ namespace frm
             throw std::runtime_error("Cannot create allocator");
         }
 
-        createSwapchain();
+        createPipelineCache();
 
-        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        m_workers = std::make_unique<ThreadPool>();
+        m_objectCache = std::make_unique<ObjectCache>(*this);
+        m_descriptorAllocator = std::make_unique<DescriptorAllocator>(*this);
+
+        if (m_features.descriptorIndexing) {
+            m_bindless = std::make_shared<BindlessTable>(*this);
+        }
+
+        createQueueTimelines();
 
-        if (VK_FAILED(vkCreateFence(m_device, &fenceInfo, nullptr, &m_submitFence))) {
-            throw std::runtime_error("Cannot create queue submit fence");
+        if (!createSwapchain()) {
+            throw std::runtime_error("Cannot create swapchain, the window has no drawable area");
+        }
+
+        createFrameContexts(std::max(1u, std::min(framesInFlight, g_maxFramesInFlight)));
+
+        m_uploader = std::make_unique<Uploader>(*this);
+
+        if (m_gpuProfiling) {
+            m_gpuProfiler = std::make_unique<GpuProfiler>(*this);
         }
 
         m_initialized = true;
     }
 
-    void VulkanContext::prepareNextSwapbuffer(uint32_t& nextSwapbufferIndex)
+    void VulkanContext::loadDeviceFunctions()
+    {
+        // extension commands aren't exported by the loader, they have to be fetched from the device
+        if (m_features.synchronization2) {
+            m_functions.cmdPipelineBarrier2 = reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>(vkGetDeviceProcAddr(m_device, "vkCmdPipelineBarrier2KHR"));
+        }
+
+        if (m_features.dynamicRendering) {
+            m_functions.cmdBeginRendering = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(vkGetDeviceProcAddr(m_device, "vkCmdBeginRenderingKHR"));
+            m_functions.cmdEndRendering = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(vkGetDeviceProcAddr(m_device, "vkCmdEndRenderingKHR"));
+        }
+
+        if (m_features.extendedDynamicState) {
+            m_functions.cmdSetCullMode = reinterpret_cast<PFN_vkCmdSetCullModeEXT>(vkGetDeviceProcAddr(m_device, "vkCmdSetCullModeEXT"));
+            m_functions.cmdSetFrontFace = reinterpret_cast<PFN_vkCmdSetFrontFaceEXT>(vkGetDeviceProcAddr(m_device, "vkCmdSetFrontFaceEXT"));
+            m_functions.cmdSetPrimitiveTopology = reinterpret_cast<PFN_vkCmdSetPrimitiveTopologyEXT>(vkGetDeviceProcAddr(m_device, "vkCmdSetPrimitiveTopologyEXT"));
+            m_functions.cmdSetDepthTestEnable = reinterpret_cast<PFN_vkCmdSetDepthTestEnableEXT>(vkGetDeviceProcAddr(m_device, "vkCmdSetDepthTestEnableEXT"));
+            m_functions.cmdSetDepthWriteEnable = reinterpret_cast<PFN_vkCmdSetDepthWriteEnableEXT>(vkGetDeviceProcAddr(m_device, "vkCmdSetDepthWriteEnableEXT"));
+            m_functions.cmdSetDepthCompareOp = reinterpret_cast<PFN_vkCmdSetDepthCompareOpEXT>(vkGetDeviceProcAddr(m_device, "vkCmdSetDepthCompareOpEXT"));
+            m_functions.cmdSetStencilTestEnable = reinterpret_cast<PFN_vkCmdSetStencilTestEnableEXT>(vkGetDeviceProcAddr(m_device, "vkCmdSetStencilTestEnableEXT"));
+        }
+
+        if (m_features.extendedDynamicState2) {
+            m_functions.cmdSetRasterizerDiscardEnable = reinterpret_cast<PFN_vkCmdSetRasterizerDiscardEnableEXT>(vkGetDeviceProcAddr(m_device, "vkCmdSetRasterizerDiscardEnableEXT"));
+            m_functions.cmdSetDepthBiasEnable = reinterpret_cast<PFN_vkCmdSetDepthBiasEnableEXT>(vkGetDeviceProcAddr(m_device, "vkCmdSetDepthBiasEnableEXT"));
+            m_functions.cmdSetPrimitiveRestartEnable = reinterpret_cast<PFN_vkCmdSetPrimitiveRestartEnableEXT>(vkGetDeviceProcAddr(m_device, "vkCmdSetPrimitiveRestartEnableEXT"));
+        }
+
+        if (m_features.extendedDynamicState3) {
+            m_functions.cmdSetPolygonMode = reinterpret_cast<PFN_vkCmdSetPolygonModeEXT>(vkGetDeviceProcAddr(m_device, "vkCmdSetPolygonModeEXT"));
+            m_functions.cmdSetColorBlendEnable = reinterpret_cast<PFN_vkCmdSetColorBlendEnableEXT>(vkGetDeviceProcAddr(m_device, "vkCmdSetColorBlendEnableEXT"));
+            m_functions.cmdSetColorWriteMask = reinterpret_cast<PFN_vkCmdSetColorWriteMaskEXT>(vkGetDeviceProcAddr(m_device, "vkCmdSetColorWriteMaskEXT"));
+        }
+    }
+
+    bool VulkanContext::prepareNextSwapbuffer(uint32_t& nextSwapbufferIndex)
+    {
+        FrameContext& frame = m_frames[m_currentFrame];
+        VkResult result;
+
+        // Nothing to render to while the window is minimized. The frame slot is left alone, there is
+        // no point in waiting for its fence and recycling its allocators for a frame that is skipped.
+        if (m_swapchainDirty && isMinimized()) {
+            return false;
+        }
+
+        // Only blocks when the ring is full, i.e. the GPU is still busy with the frame that used this slot
+        {
+            FRM_CPU_SCOPE("wait frame fence");
+            while (vkWaitForFences(m_device, 1, &frame.inFlightFence, VK_TRUE, UINT64_MAX) == VK_TIMEOUT);
+        }
+
+        // The GPU is done with this slot, recycle its command buffers and transient descriptor sets
+        m_cmdAllocator->beginFrame(m_currentFrame);
+        frame.cmdBuffer = m_cmdAllocator->allocate();
+        frame.descriptors->reset();
+
+        // also makes the allocator fetch a fresh budget from VK_EXT_memory_budget
+        vmaSetCurrentFrameIndex(m_allocator, ++m_allocatorFrame);
+
+        if (m_gpuProfiler) {
+            m_gpuProfiler->beginFrame(m_currentFrame);
+        }
+
+        if (m_bindless) {
+            m_bindless->nextFrame();
+        }
+
+        // Stays dirty while the window is minimized, the frame is skipped until it has a size again
+        if (m_swapchainDirty && !recreateSwapchain()) {
+            return false;
+        }
+
+        if (m_headless) {
+            // There is no presentation engine holding on to images, just cycle through them. Reusing an image
+            // is ordered after the frame that last rendered to it since everything goes through the graphics queue.
+            nextSwapbufferIndex = m_virtualSwapbufferIndex;
+            frame.swapbufferIndex = nextSwapbufferIndex;
+            m_virtualSwapbufferIndex = (m_virtualSwapbufferIndex + 1) % static_cast<uint32_t>(m_swapchainImages.size());
+
+            return true;
+        }
+
+        {
+            FRM_CPU_SCOPE("acquire swapbuffer");
+            result = vkAcquireNextImageKHR(m_device, m_swapchain, UINT64_MAX, frame.swapbufferAcquired, VK_NULL_HANDLE, &nextSwapbufferIndex);
+        }
+
+        if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            // Nothing was acquired and the semaphore is left untouched, try again with a new swapchain
+            m_swapchainDirty = true;
+            return false;
+        }
+
+        if (result == VK_SUBOPTIMAL_KHR) {
+            m_swapchainDirty = true; // still presentable, recreate it on the next frame
+        }
+        else if (VK_FAILED(result)) {
+            throw std::runtime_error("Cannot acquire next swapbuffer");
+        }
+
+        // submitFrame signals the render complete semaphore of this image
+        frame.swapbufferIndex = nextSwapbufferIndex;
+
+        return true;
+    }
+
+    bool VulkanContext::isMinimized() const
     {
-        vkAcquireNextImageKHR(m_device, m_swapchain, UINT64_MAX, VK_NULL_HANDLE, m_swapbufferAvailable, &nextSwapbufferIndex);
-        vkWaitForFences(m_device, 1, &m_swapbufferAvailable, VK_TRUE, UINT64_MAX);
-        vkResetFences(m_device, 1, &m_swapbufferAvailable);
+        VkSurfaceCapabilitiesKHR surfaceCaps;
+        VkExtent2D extent;
+
+        if (m_headless) {
+            return false;
+        }
+
+        extent = getSurfaceExtent(surfaceCaps);
+
+        return extent.width == 0 || extent.height == 0;
     }
 
     void VulkanContext::present(uint32_t swapbufferIndex)
     {
+        FrameContext& frame = m_frames[m_currentFrame];
         VkPresentInfoKHR presentInfo = { };
+        VkResult result;
+
+        if (!frame.submitted) {
+            // Nothing was rendered this frame, but the acquire semaphore still has to be consumed
+            // and the render complete semaphore signaled before we can present.
+            VkSubmitInfo emptySubmit{};
+            emptySubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+            submitFrame(emptySubmit);
+        }
+
+        frame.submitted = false;
+        m_currentFrame = (m_currentFrame + 1) % static_cast<uint32_t>(m_frames.size());
+
+        if (m_headless) {
+            return; // the image just stays in the virtual swapchain
+        }
 
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = &m_renderComplete[swapbufferIndex];
         presentInfo.swapchainCount = 1;
         presentInfo.pSwapchains = &m_swapchain;
         presentInfo.pImageIndices = &swapbufferIndex;
 
-        if (VK_FAILED(vkQueuePresentKHR(m_deviceQueue, &presentInfo))) {
+        {
+            FRM_CPU_SCOPE("present");
+            std::lock_guard<std::mutex> lock(*m_queues[static_cast<size_t>(QueueType::Graphics)].submitMutex);
+            result = vkQueuePresentKHR(getQueue(QueueType::Graphics), &presentInfo);
+        }
+
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+            m_swapchainDirty = true; // the surface has changed, e.g. the window was resized
+        }
+        else if (VK_FAILED(result)) {
             throw std::runtime_error("Swapbuffer presentation failed");
         }
     }
@@ -142,46 +641,272 @@ namespace frm
     void VulkanContext::queueSubmit(const VkSubmitInfo& submitInfo)
     {
         // Synchronized queue submission
-        if (VK_FAILED(vkQueueSubmit(m_deviceQueue, 1, &submitInfo, m_submitFence))) {
-            throw std::runtime_error("Queue submission failed");
+        wait(queueSubmitAsync(submitInfo));
+    }
+
+    SubmitTicket VulkanContext::queueSubmitAsync(const VkSubmitInfo& submitInfo)
+    {
+        return queueSubmitAsync(QueueType::Graphics, submitInfo);
+    }
+
+    SubmitTicket VulkanContext::queueSubmitAsync(QueueType queue, const VkSubmitInfo& submitInfo, const std::vector<SubmitWait>& waits)
+    {
+        QueueContext& queueCtx = m_queues[static_cast<size_t>(queue)];
+        SubmitTicket ticket{ queueCtx.timeline, 0 };
+        VkSubmitInfo timelineSubmit = submitInfo;
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        std::vector<VkSemaphore> waitSemaphores(submitInfo.pWaitSemaphores, submitInfo.pWaitSemaphores + submitInfo.waitSemaphoreCount);
+        std::vector<VkPipelineStageFlags> waitStages(submitInfo.pWaitDstStageMask, submitInfo.pWaitDstStageMask + submitInfo.waitSemaphoreCount);
+        std::vector<uint64_t> waitValues;
+        std::vector<VkSemaphore> signalSemaphores(submitInfo.pSignalSemaphores, submitInfo.pSignalSemaphores + submitInfo.signalSemaphoreCount);
+        std::vector<uint64_t> signalValues;
+        const void* next = getSubmitValues(submitInfo, waitValues, signalValues);
+
+        // GPU-side waits on other submissions, this is how work is handed off between queues
+        for (auto& wait : waits) {
+            if (wait.ticket.timeline == VK_NULL_HANDLE) {
+                continue;
+            }
+
+            waitSemaphores.push_back(wait.ticket.timeline);
+            waitStages.push_back(wait.stageMask);
+            waitValues.push_back(wait.ticket.value);
+        }
+
+        signalSemaphores.push_back(ticket.timeline);
+        signalValues.push_back(0); // the ticket value, picked under the queue lock
+
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.pNext = next;
+        timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+        timelineInfo.pWaitSemaphoreValues = waitValues.data();
+        timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+        timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+        timelineSubmit.pNext = &timelineInfo;
+        timelineSubmit.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+        timelineSubmit.pWaitSemaphores = waitSemaphores.data();
+        timelineSubmit.pWaitDstStageMask = waitStages.data();
+        timelineSubmit.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+        timelineSubmit.pSignalSemaphores = signalSemaphores.data();
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        {
+            // the value has to be bumped and submitted in one go, or two threads could signal the same one
+            std::lock_guard<std::mutex> lock(*queueCtx.submitMutex);
+
+            ticket.value = queueCtx.timelineValue + 1;
+            signalValues.back() = ticket.value;
+
+            if (VK_FAILED(vkQueueSubmit(queueCtx.queue, 1, &timelineSubmit, VK_NULL_HANDLE))) {
+                throw std::runtime_error("Queue submission failed");
+            }
+
+            queueCtx.timelineValue = ticket.value;
+        }
+
+        addSubmitTime(start, 1);
+
+        return ticket;
+    }
+
+    bool VulkanContext::isComplete(const SubmitTicket& ticket) const
+    {
+        uint64_t completedValue = 0;
+
+        if (ticket.timeline == VK_NULL_HANDLE) {
+            return true;
+        }
+
+        if (VK_FAILED(vkGetSemaphoreCounterValue(m_device, ticket.timeline, &completedValue))) {
+            throw std::runtime_error("Cannot query timeline semaphore");
+        }
+
+        return completedValue >= ticket.value;
+    }
+
+    SubmitTicket VulkanContext::getLastSubmit(QueueType queue) const
+    {
+        const QueueContext& queueCtx = m_queues[static_cast<size_t>(queue)];
+
+        return { queueCtx.timeline, queueCtx.timelineValue.load() };
+    }
+
+    void VulkanContext::wait(const SubmitTicket& ticket) const
+    {
+        VkSemaphoreWaitInfo waitInfo{};
+
+        if (ticket.timeline == VK_NULL_HANDLE) {
+            return;
+        }
+
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &ticket.timeline;
+        waitInfo.pValues = &ticket.value;
+
+        FRM_CPU_SCOPE("wait submit");
+        auto start = std::chrono::high_resolution_clock::now();
+
+        while (vkWaitSemaphores(m_device, &waitInfo, UINT64_MAX) == VK_TIMEOUT);
+
+        addSubmitTime(start, 0);
+    }
+
+    void VulkanContext::submitFrame(const VkSubmitInfo& submitInfo, const std::vector<SubmitWait>& waits)
+    {
+        FrameContext& frame = m_frames[m_currentFrame];
+        QueueContext& queueCtx = m_queues[static_cast<size_t>(QueueType::Graphics)];
+        VkSubmitInfo frameSubmit = submitInfo;
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        std::vector<VkSemaphore> waitSemaphores(submitInfo.pWaitSemaphores, submitInfo.pWaitSemaphores + submitInfo.waitSemaphoreCount);
+        std::vector<VkPipelineStageFlags> waitStages(submitInfo.pWaitDstStageMask, submitInfo.pWaitDstStageMask + submitInfo.waitSemaphoreCount);
+        std::vector<uint64_t> waitValues;
+        std::vector<VkSemaphore> signalSemaphores(submitInfo.pSignalSemaphores, submitInfo.pSignalSemaphores + submitInfo.signalSemaphoreCount);
+        std::vector<uint64_t> signalValues;
+        const void* next = getSubmitValues(submitInfo, waitValues, signalValues);
+
+        if (frame.submitted) {
+            throw std::runtime_error("Frame has already been submitted");
+        }
+
+        // Wait until the presentation engine releases the swapbuffer before writing to it,
+        // then tell present() when rendering is done
+        if (!m_headless) {
+            waitSemaphores.push_back(frame.swapbufferAcquired);
+            waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+            waitValues.push_back(0);
+            signalSemaphores.push_back(m_renderComplete[frame.swapbufferIndex]);
+            signalValues.push_back(0);
         }
 
-        // Wait the submission to be done
-        while (vkWaitForFences(m_device, 1, &m_submitFence, VK_TRUE, UINT64_MAX) == VK_TIMEOUT);
-        vkResetFences(m_device, 1, &m_submitFence);
+        // Hand-off from other queues, e.g. async compute results consumed by this frame
+        for (auto& wait : waits) {
+            if (wait.ticket.timeline == VK_NULL_HANDLE) {
+                continue;
+            }
+
+            waitSemaphores.push_back(wait.ticket.timeline);
+            waitStages.push_back(wait.stageMask);
+            waitValues.push_back(wait.ticket.value);
+        }
+
+        // the frame moves the graphics timeline too, so getLastSubmit covers it
+        signalSemaphores.push_back(queueCtx.timeline);
+        signalValues.push_back(0); // picked under the queue lock
+
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.pNext = next;
+        timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+        timelineInfo.pWaitSemaphoreValues = waitValues.data();
+        timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+        timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+        frameSubmit.pNext = &timelineInfo;
+        frameSubmit.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+        frameSubmit.pWaitSemaphores = waitSemaphores.data();
+        frameSubmit.pWaitDstStageMask = waitStages.data();
+        frameSubmit.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+        frameSubmit.pSignalSemaphores = signalSemaphores.data();
+
+        vkResetFences(m_device, 1, &frame.inFlightFence);
+
+        // Asynchronous, the fence is only waited on when this frame slot is reused
+        auto start = std::chrono::high_resolution_clock::now();
+
+        {
+            std::lock_guard<std::mutex> lock(*queueCtx.submitMutex);
+
+            signalValues.back() = queueCtx.timelineValue + 1;
+
+            if (VK_FAILED(vkQueueSubmit(queueCtx.queue, 1, &frameSubmit, frame.inFlightFence))) {
+                throw std::runtime_error("Frame submission failed");
+            }
+
+            queueCtx.timelineValue = signalValues.back();
+        }
+
+        addSubmitTime(start, 1);
+
+        frame.submitted = true;
     }
 
     void VulkanContext::waitIdle()
     {
+        FRM_CPU_SCOPE("wait idle");
         vkDeviceWaitIdle(m_device);
     }
 
+    void VulkanContext::setPresentMode(VkPresentModeKHR presentMode)
+    {
+        if (presentMode != m_requestedPresentMode) {
+            m_requestedPresentMode = presentMode;
+            m_swapchainDirty = true;
+        }
+    }
+
+    void VulkanContext::setSwapbufferCount(uint32_t count)
+    {
+        if (count != m_requestedSwapbufferCount) {
+            m_requestedSwapbufferCount = count;
+            m_swapchainDirty = true;
+        }
+    }
+
     void VulkanContext::createBuffer(const VkBufferCreateInfo& createInfo, VmaMemoryUsage usage, BufferResourceRef& buffer)
     {
         VkBuffer buf;
         VmaAllocation alloc;
+        VmaAllocationInfo allocationInfo;
         VmaAllocationCreateInfo allocInfo{};
+        MemoryCategory category = MemoryCategory::Other;
         allocInfo.usage = usage;
 
-        if (VK_FAILED(vmaCreateBuffer(m_allocator, &createInfo, &allocInfo, &buf, &alloc, nullptr))) {
+        if (VK_FAILED(vmaCreateBuffer(m_allocator, &createInfo, &allocInfo, &buf, &alloc, &allocationInfo))) {
             throw std::runtime_error("Cannot create buffer");
         }
 
+        if (createInfo.usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) {
+            category = MemoryCategory::Vertex;
+        }
+        else if (createInfo.usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT) {
+            category = MemoryCategory::Index;
+        }
+        else if ((createInfo.usage & VK_BUFFER_USAGE_TRANSFER_SRC_BIT) && (usage == VMA_MEMORY_USAGE_CPU_ONLY || usage == VMA_MEMORY_USAGE_CPU_TO_GPU)) {
+            category = MemoryCategory::Staging;
+        }
+
         buffer = std::make_shared<BufferResource>(m_allocator, buf, alloc);
+        buffer->setMemoryCategory(m_memoryTotals, category, allocationInfo.size);
     }
 
-    void VulkanContext::createImage(const VkImageCreateInfo& createInfo, VmaMemoryUsage usage, ImageResourceRef& buffer)
+    void VulkanContext::createImage(const VkImageCreateInfo& createInfo, VmaMemoryUsage usage, ImageResourceRef& buffer, bool bindless)
     {
         VkImage img;
         VmaAllocation alloc;
+        VmaAllocationInfo allocationInfo;
         VmaAllocationCreateInfo allocInfo{};
+        MemoryCategory category = MemoryCategory::Other;
+        VkImageUsageFlags attachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
         allocInfo.usage = usage;
 
-        if (VK_FAILED(vmaCreateImage(m_allocator, &createInfo, &allocInfo, &img, &alloc, nullptr))) {
+        if (VK_FAILED(vmaCreateImage(m_allocator, &createInfo, &allocInfo, &img, &alloc, &allocationInfo))) {
             throw std::runtime_error("Cannot create buffer");
         }
 
-        buffer = std::make_shared<ImageResource>(m_allocator, img, alloc);
+        // sampled render targets count as render targets
+        if ((createInfo.usage & VK_IMAGE_USAGE_SAMPLED_BIT) && !(createInfo.usage & attachmentUsage)) {
+            category = MemoryCategory::Texture;
+        }
+
+        buffer = std::make_shared<ImageResource>(m_allocator, img, alloc, createInfo);
+        buffer->setMemoryCategory(m_memoryTotals, category, allocationInfo.size);
+
+        // a single view can only sample the depth aspect, depth/stencil images are left out
+        if (bindless && m_bindless && (createInfo.usage & VK_IMAGE_USAGE_SAMPLED_BIT) && buffer->getAspect() == VK_IMAGE_ASPECT_COLOR_BIT) {
+            addToBindlessTable(createInfo, buffer);
+        }
     }
 
     void VulkanContext::createImageView(const VkImageViewCreateInfo& createInfo, VkImageView* imageView)
@@ -191,13 +916,13 @@ namespace frm
         }
     }
 
-    void VulkanContext::createCommandPool(uint32_t flags, VkCommandPool* cmdPool)
+    void VulkanContext::createCommandPool(uint32_t flags, VkCommandPool* cmdPool, QueueType queue)
     {
         VkCommandPoolCreateInfo cmdPoolInfo{};
 
         cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
         cmdPoolInfo.flags = static_cast<VkCommandPoolCreateFlags>(flags);
-        cmdPoolInfo.queueFamilyIndex = m_deviceQueueIndex;
+        cmdPoolInfo.queueFamilyIndex = getQueueIndex(queue);
 
         if (VK_FAILED(vkCreateCommandPool(m_device, &cmdPoolInfo, nullptr, cmdPool))) {
             throw std::runtime_error("Cannot create command pool");
@@ -247,9 +972,104 @@ namespace frm
 
     void VulkanContext::createGraphicsPipeline(const VkGraphicsPipelineCreateInfo& createInfo, VkPipeline* pipeline)
     {
-        if (VK_FAILED(vkCreateGraphicsPipelines(m_device, nullptr, 1, &createInfo, nullptr, pipeline))) {
+        FRM_CPU_SCOPE("create graphics pipeline");
+        auto start = std::chrono::high_resolution_clock::now();
+
+        if (VK_FAILED(vkCreateGraphicsPipelines(m_device, m_pipelineCache, 1, &createInfo, nullptr, pipeline))) {
             throw std::runtime_error("Cannot create graphics pipeline");
         }
+
+        addPipelineCreateTime(start);
+    }
+
+    void VulkanContext::createComputePipeline(const VkComputePipelineCreateInfo& createInfo, VkPipeline* pipeline)
+    {
+        FRM_CPU_SCOPE("create compute pipeline");
+        auto start = std::chrono::high_resolution_clock::now();
+
+        if (VK_FAILED(vkCreateComputePipelines(m_device, m_pipelineCache, 1, &createInfo, nullptr, pipeline))) {
+            throw std::runtime_error("Cannot create compute pipeline");
+        }
+
+        addPipelineCreateTime(start);
+    }
+
+    void VulkanContext::createGraphicsPipelines(const std::vector<VkGraphicsPipelineCreateInfo>& createInfos, std::vector<VkPipeline>& pipelines)
+    {
+        FRM_CPU_SCOPE("create graphics pipelines");
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<std::future<VkPipeline>> futures;
+        bool onWorker = m_workers->isWorkerThread();
+
+        futures.reserve(createInfos.size());
+
+        for (auto& createInfo : createInfos) {
+            auto job = [this, &createInfo]() {
+                VkPipeline pipeline;
+                createGraphicsPipeline(createInfo, &pipeline);
+                return pipeline;
+            };
+
+            // a worker waiting on the pool could deadlock it, it compiles the batch itself when the results are collected
+            futures.push_back(onWorker ? std::async(std::launch::deferred, job) : m_workers->submit(job));
+        }
+
+        waitForPipelines(m_device, futures, pipelines);
+        addPipelineBatchTime(start);
+    }
+
+    void VulkanContext::createComputePipelines(const std::vector<VkComputePipelineCreateInfo>& createInfos, std::vector<VkPipeline>& pipelines)
+    {
+        FRM_CPU_SCOPE("create compute pipelines");
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<std::future<VkPipeline>> futures;
+        bool onWorker = m_workers->isWorkerThread();
+
+        futures.reserve(createInfos.size());
+
+        for (auto& createInfo : createInfos) {
+            auto job = [this, &createInfo]() {
+                VkPipeline pipeline;
+                createComputePipeline(createInfo, &pipeline);
+                return pipeline;
+            };
+
+            // a worker waiting on the pool could deadlock it, it compiles the batch itself when the results are collected
+            futures.push_back(onWorker ? std::async(std::launch::deferred, job) : m_workers->submit(job));
+        }
+
+        waitForPipelines(m_device, futures, pipelines);
+        addPipelineBatchTime(start);
+    }
+
+    void VulkanContext::getDynamicStates(std::vector<VkDynamicState>& states) const
+    {
+        states.clear();
+        states.push_back(VK_DYNAMIC_STATE_VIEWPORT);
+        states.push_back(VK_DYNAMIC_STATE_SCISSOR);
+
+        if (m_features.extendedDynamicState) {
+            // the topology can only change within the same class (points, lines, triangles) as the pipeline's
+            states.push_back(VK_DYNAMIC_STATE_CULL_MODE_EXT);
+            states.push_back(VK_DYNAMIC_STATE_FRONT_FACE_EXT);
+            states.push_back(VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT);
+            states.push_back(VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT);
+            states.push_back(VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT);
+            states.push_back(VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT);
+            states.push_back(VK_DYNAMIC_STATE_STENCIL_TEST_ENABLE_EXT);
+        }
+
+        if (m_features.extendedDynamicState2) {
+            states.push_back(VK_DYNAMIC_STATE_RASTERIZER_DISCARD_ENABLE_EXT);
+            states.push_back(VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE_EXT);
+            states.push_back(VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE_EXT);
+        }
+
+        if (m_features.extendedDynamicState3) {
+            states.push_back(VK_DYNAMIC_STATE_POLYGON_MODE_EXT);
+            states.push_back(VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT);
+            states.push_back(VK_DYNAMIC_STATE_COLOR_WRITE_MASK_EXT);
+        }
     }
 
     void VulkanContext::createFramebuffer(const VkFramebufferCreateInfo& createInfo, VkFramebuffer* framebuffer)
@@ -283,7 +1103,7 @@ namespace frm
         allocInfo.pSetLayouts = &layout;
 
         if (VK_FAILED(vkAllocateDescriptorSets(m_device, &allocInfo, set))) {
-            throw std::runtime_error("Cannot create render pass");
+            throw std::runtime_error("Cannot allocate descriptor set");
         }
     }
 
@@ -294,13 +1114,116 @@ namespace frm
         }
     }
 
+    void VulkanContext::cmdDispatchThreads(VkCommandBuffer cmdBuffer, const glm::uvec3& threadCount, const glm::uvec3& localSize)
+    {
+        glm::uvec3 groupCount = (threadCount + localSize - 1u) / localSize;
+
+        vkCmdDispatch(cmdBuffer, groupCount.x, groupCount.y, groupCount.z);
+    }
+
+    void VulkanContext::cmdBeginRendering(VkCommandBuffer cmdBuffer,
+                                          const VkRect2D& renderArea,
+                                          const std::vector<RenderingAttachment>& colorAttachments,
+                                          const RenderingAttachment* depthAttachment,
+                                          const RenderingAttachment* stencilAttachment) const
+    {
+        static const size_t maxColorAttachments = 8;
+        VkRenderingAttachmentInfoKHR colors[maxColorAttachments] = {};
+        VkRenderingAttachmentInfoKHR depth{};
+        VkRenderingAttachmentInfoKHR stencil{};
+        VkRenderingInfoKHR renderingInfo{};
+
+        if (m_functions.cmdBeginRendering == nullptr) {
+            throw std::runtime_error("Cannot begin rendering, dynamic rendering is not enabled");
+        }
+
+        if (colorAttachments.size() > maxColorAttachments) {
+            throw std::runtime_error("Cannot begin rendering with more than 8 color attachments");
+        }
+
+        auto fill = [](const RenderingAttachment& attachment, VkRenderingAttachmentInfoKHR& info) {
+            info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+            info.imageView = attachment.view;
+            info.imageLayout = attachment.layout;
+            info.resolveMode = VK_RESOLVE_MODE_NONE;
+            info.loadOp = attachment.loadOp;
+            info.storeOp = attachment.storeOp;
+            info.clearValue = attachment.clearValue;
+        };
+
+        for (size_t i = 0; i < colorAttachments.size(); i++) {
+            fill(colorAttachments[i], colors[i]);
+        }
+
+        renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+        renderingInfo.renderArea = renderArea;
+        renderingInfo.layerCount = 1;
+        renderingInfo.colorAttachmentCount = static_cast<uint32_t>(colorAttachments.size());
+        renderingInfo.pColorAttachments = colors;
+
+        if (depthAttachment != nullptr) {
+            fill(*depthAttachment, depth);
+            renderingInfo.pDepthAttachment = &depth;
+        }
+
+        if (stencilAttachment != nullptr) {
+            fill(*stencilAttachment, stencil);
+            renderingInfo.pStencilAttachment = &stencil;
+        }
+
+        m_functions.cmdBeginRendering(cmdBuffer, &renderingInfo);
+    }
+
+    void VulkanContext::cmdEndRendering(VkCommandBuffer cmdBuffer) const
+    {
+        if (m_functions.cmdEndRendering == nullptr) {
+            throw std::runtime_error("Cannot end rendering, dynamic rendering is not enabled");
+        }
+
+        m_functions.cmdEndRendering(cmdBuffer);
+    }
+
+    void VulkanContext::getQueueFamilies(std::vector<uint32_t>& families) const
+    {
+        families.clear();
+
+        for (auto& queueCtx : m_queues) {
+            if (std::find(families.begin(), families.end(), queueCtx.familyIndex) == families.end()) {
+                families.push_back(queueCtx.familyIndex);
+            }
+        }
+    }
+
     void VulkanContext::init()
     {
         VkInstanceCreateInfo instanceInfo{};
         VkApplicationInfo appInfo{};
-        uint32_t physicalDeviceCount;
-        std::vector<VkPhysicalDevice> physicalDevices;
-        bool discreteGpuFound = false;
+        std::vector<const char*> layers;
+        std::vector<const char*> extensions;
+
+        m_caps.queryInstance();
+
+        // validation costs a lot of CPU time, it's only enabled when asked for
+        if (m_validation && !m_caps.requestLayer(g_validationLayer)) {
+            std::cout << "Validation requested but " << g_validationLayer << " is not installed" << std::endl;
+        }
+
+        if (!m_headless) {
+            // whatever surface extensions SDL needs for this window system (win32, xcb, xlib, wayland...)
+            unsigned int sdlExtensionCount = 0;
+            std::vector<const char*> sdlExtensions;
+
+            SDL_Vulkan_GetInstanceExtensions(m_window, &sdlExtensionCount, nullptr);
+            sdlExtensions.resize(sdlExtensionCount);
+            SDL_Vulkan_GetInstanceExtensions(m_window, &sdlExtensionCount, sdlExtensions.data());
+
+            for (auto ext : sdlExtensions) {
+                m_caps.requestInstanceExtension(ext, true);
+            }
+        }
+
+        m_caps.getEnabledLayers(layers);
+        m_caps.getEnabledInstanceExtensions(extensions);
 
         appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
         appInfo.pApplicationName = "vulkan-learn";
@@ -311,60 +1234,221 @@ namespace frm
 
         instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
         instanceInfo.pApplicationInfo = &appInfo;
-        instanceInfo.ppEnabledLayerNames = g_instanceLayers;
-        instanceInfo.enabledLayerCount = GET_ARRAY_SIZE(g_instanceLayers);
-        instanceInfo.ppEnabledExtensionNames = g_instanceExtensions;
-        instanceInfo.enabledExtensionCount = GET_ARRAY_SIZE(g_instanceExtensions);
-        
+        instanceInfo.ppEnabledLayerNames = layers.data();
+        instanceInfo.enabledLayerCount = static_cast<uint32_t>(layers.size());
+        instanceInfo.ppEnabledExtensionNames = extensions.data();
+        instanceInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+
         if (VK_FAILED(vkCreateInstance(&instanceInfo, nullptr, &m_instance))) {
             throw std::runtime_error("Cannot create instance");
         }
 
+        selectPhysicalDevice();
+
+        vkGetPhysicalDeviceFeatures(m_physicalDevice, &m_pdFeatures); // get current gpu feature
+        vkGetPhysicalDeviceProperties(m_physicalDevice, &m_pdProperties);
+        vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &m_pdMemoryProperties);
+    }
+
+    void VulkanContext::selectPhysicalDevice()
+    {
+        uint32_t physicalDeviceCount;
+        std::vector<VkPhysicalDevice> physicalDevices;
+        std::vector<int64_t> scores;
+        const char* deviceOverride = std::getenv("VKL_DEVICE");
+        size_t selected = SIZE_MAX;
+
         vkEnumeratePhysicalDevices(m_instance, &physicalDeviceCount, nullptr);
         physicalDevices.resize(physicalDeviceCount);
         vkEnumeratePhysicalDevices(m_instance, &physicalDeviceCount, physicalDevices.data());
 
-        // find discrete gpu (AMD, NVIDIA, etc)
-        for (auto p : physicalDevices) {
-            VkPhysicalDeviceProperties prop{};
+        if (physicalDevices.empty()) {
+            throw std::runtime_error("No Vulkan device found");
+        }
+
+        for (size_t i = 0; i < physicalDevices.size(); i++) {
+            scores.push_back(scorePhysicalDevice(physicalDevices[i]));
 
-            vkGetPhysicalDeviceProperties(p, &prop);
+            if (scores[i] >= 0 && (selected == SIZE_MAX || scores[i] > scores[selected])) {
+                selected = i;
+            }
+        }
 
-            if (prop.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
-                m_physicalDevice = p;
-                discreteGpuFound = true;
+        // VKL_DEVICE=<index> or VKL_DEVICE=<part of the device name, case insensitive>
+        if (deviceOverride != nullptr && deviceOverride[0] != '\0') {
+            std::string wanted = deviceOverride;
+            bool isIndex = std::all_of(wanted.begin(), wanted.end(), [](char c) { return c >= '0' && c <= '9'; });
 
-                break;
+            std::transform(wanted.begin(), wanted.end(), wanted.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            selected = SIZE_MAX;
+
+            for (size_t i = 0; i < physicalDevices.size() && selected == SIZE_MAX; i++) {
+                VkPhysicalDeviceProperties props{};
+                std::string name;
+
+                vkGetPhysicalDeviceProperties(physicalDevices[i], &props);
+                name = props.deviceName;
+                std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+                if (isIndex ? std::strtoul(wanted.c_str(), nullptr, 10) == i : name.find(wanted) != std::string::npos) {
+                    selected = i;
+                }
+            }
+
+            if (selected == SIZE_MAX) {
+                throw std::runtime_error("VKL_DEVICE doesn't match any device");
+            }
+
+            if (scores[selected] < 0) {
+                throw std::runtime_error("The device selected by VKL_DEVICE doesn't meet the requirements");
             }
         }
 
-        if (!discreteGpuFound) {
-            m_physicalDevice = physicalDevices[0]; // select default gpu
+        if (selected == SIZE_MAX) {
+            throw std::runtime_error("No suitable Vulkan device found");
         }
 
-        vkGetPhysicalDeviceFeatures(m_physicalDevice, &m_pdFeatures); // get current gpu feature
+        // log the ranking, useful to tell which device a benchmark actually ran on
+        std::cout << "Vulkan devices:" << std::endl;
+
+        for (size_t i = 0; i < physicalDevices.size(); i++) {
+            VkPhysicalDeviceProperties props{};
+
+            vkGetPhysicalDeviceProperties(physicalDevices[i], &props);
+
+            std::cout << (i == selected ? " * " : "   ") << "[" << i << "] " << props.deviceName;
+
+            if (scores[i] < 0) {
+                std::cout << " (unsuitable)" << std::endl;
+            }
+            else {
+                std::cout << " (score " << scores[i] << ")" << std::endl;
+            }
+        }
+
+        m_physicalDevice = physicalDevices[selected];
+    }
+
+    int64_t VulkanContext::scorePhysicalDevice(VkPhysicalDevice physicalDevice)
+    {
+        VkPhysicalDeviceProperties props{};
+        VkPhysicalDeviceMemoryProperties memProps{};
+        VkPhysicalDeviceFeatures2 features{};
+        VkPhysicalDeviceVulkan12Features features12{};
+        uint32_t queueFamilyCount;
+        std::vector<VkQueueFamilyProperties> queueFamilyProps;
+        VkDeviceSize deviceLocalMemory = 0;
+        bool hasGraphics = false;
+        int64_t score = 0;
+
+        vkGetPhysicalDeviceProperties(physicalDevice, &props);
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProps);
+
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+        queueFamilyProps.resize(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilyProps.data());
+
+        // hard requirements: Vulkan 1.2, timeline semaphores and a graphics queue
+        if (props.apiVersion < VK_API_VERSION_1_2) {
+            return -1;
+        }
+
+        features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &features12;
+
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+        if (!features12.timelineSemaphore) {
+            return -1;
+        }
+
+        for (auto& qf : queueFamilyProps) {
+            hasGraphics |= (qf.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+
+            // dedicated transfer and async compute queues, see createDevice
+            if ((qf.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(qf.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+                score += 100;
+            }
+            else if ((qf.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(qf.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+                score += 100;
+            }
+        }
+
+        if (!hasGraphics) {
+            return -1;
+        }
+
+        // device type dominates, then the amount of device local memory (1 point per 16 MiB)
+        switch (props.deviceType) {
+            case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+                score += 100000;
+                break;
+            case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+                score += 50000;
+                break;
+            case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+                score += 20000;
+                break;
+            case VK_PHYSICAL_DEVICE_TYPE_CPU:
+                score += 1000;
+                break;
+            default:
+                break;
+        }
+
+        for (uint32_t i = 0; i < memProps.memoryHeapCount; i++) {
+            if (memProps.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+                deviceLocalMemory += memProps.memoryHeaps[i].size;
+            }
+        }
+
+        score += static_cast<int64_t>(deviceLocalMemory / (16ull << 20));
+
+        return score;
     }
 
     void VulkanContext::shutdown()
     {
-        vkDeviceWaitIdle(m_device);
+        m_workers.reset(); // finishes pending pipeline compiles
 
-        if (m_submitFence != nullptr) {
-            vkDestroyFence(m_device, m_submitFence, nullptr);
+        if (m_device != nullptr) {
+            vkDeviceWaitIdle(m_device);
         }
 
-        if (m_swapbufferAvailable != nullptr) {
-            vkDestroyFence(m_device, m_swapbufferAvailable, nullptr);
+        m_gpuProfiler.reset();
+
+        destroyFrameContexts();
+
+        m_uploader.reset();
+        m_bindless.reset();
+        m_descriptorAllocator.reset();
+        m_objectCache.reset();
+
+        destroyPipelineCache();
+
+        if (m_swapchainInitPool != nullptr) {
+            vkDestroyCommandPool(m_device, m_swapchainInitPool, nullptr);
+        }
+
+        for (auto& queueCtx : m_queues) {
+            if (queueCtx.timeline != nullptr) {
+                vkDestroySemaphore(m_device, queueCtx.timeline, nullptr);
+            }
         }
 
         for (auto swapchainImgView : m_swapchainImgViews) {
             vkDestroyImageView(m_device, swapchainImgView, nullptr);
         }
 
+        destroyRenderCompleteSemaphores();
+
         if (m_swapchain != nullptr) {
             vkDestroySwapchainKHR(m_device, m_swapchain, nullptr);
         }
 
+        m_virtualSwapbuffers.clear();
+
         if (m_allocator != nullptr) {
             vmaDestroyAllocator(m_allocator);
         }
@@ -382,43 +1466,28 @@ namespace frm
         }
     }
 
-    void VulkanContext::createSwapchain()
+    bool VulkanContext::createSwapchain()
     {
-        VkCommandPool cmdPool;
-        VkCommandBuffer cmdBuffer;
         uint32_t swapchainImageCount;
-        VkSwapchainCreateInfoKHR swapchainInfo{};
-        VkFenceCreateInfo swapchainFenceInfo{};
-        VkCommandPoolCreateInfo cmdPoolInfo{};
-        VkCommandBufferAllocateInfo cmdBufferInfo{};
+        std::vector<VkImageMemoryBarrier> initialLayoutBarriers;
         VkCommandBufferBeginInfo cmdBufferBegin{};
         VkSubmitInfo submitInfo{};
 
-        // create swapchain
-        swapchainInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-        swapchainInfo.surface = m_surface;
-        swapchainInfo.minImageCount = 2;
-        swapchainInfo.imageFormat = VK_FORMAT_B8G8R8A8_SRGB;
-        swapchainInfo.imageExtent.width = m_surfaceCaps.maxImageExtent.width;
-        swapchainInfo.imageExtent.height = m_surfaceCaps.maxImageExtent.height;
-        swapchainInfo.imageArrayLayers = 1;
-        swapchainInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-        swapchainInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        swapchainInfo.preTransform = m_surfaceCaps.currentTransform;
-        swapchainInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-        swapchainInfo.presentMode = VK_PRESENT_MODE_FIFO_KHR;
-        swapchainInfo.clipped = VK_TRUE;
-        swapchainInfo.oldSwapchain = VK_NULL_HANDLE;
+        if (m_headless) {
+            createVirtualSwapchain();
+        }
+        else if (!createSurfaceSwapchain()) {
+            return false; // minimized, keep the current swapchain until the window has a size again
+        }
 
-        if (VK_FAILED(vkCreateSwapchainKHR(m_device, &swapchainInfo, nullptr, &m_swapchain))) {
-            throw std::runtime_error("Cannot create swapchain");
+        // the views of the previous images go away, recreateSwapchain waited for the frames and presents using them
+        for (auto swapchainImgView : m_swapchainImgViews) {
+            vkDestroyImageView(m_device, swapchainImgView, nullptr);
         }
 
-        // fetch swapchain images and create views
-        vkGetSwapchainImagesKHR(m_device, m_swapchain, &swapchainImageCount, nullptr);
-        m_swapchainImages.resize(swapchainImageCount);
+        // create views for the new images
+        swapchainImageCount = static_cast<uint32_t>(m_swapchainImages.size());
         m_swapchainImgViews.resize(swapchainImageCount);
-        vkGetSwapchainImagesKHR(m_device, m_swapchain, &swapchainImageCount, m_swapchainImages.data());
 
         for (uint32_t i = 0; i < swapchainImageCount; i++) {
             VkImageViewCreateInfo imgViewInfo{};
@@ -426,7 +1495,7 @@ namespace frm
             imgViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
             imgViewInfo.image = m_swapchainImages[i];
             imgViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-            imgViewInfo.format = swapchainInfo.imageFormat;
+            imgViewInfo.format = getSwapchainFormat();
             imgViewInfo.components = { VK_COMPONENT_SWIZZLE_IDENTITY };
             imgViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
             imgViewInfo.subresourceRange.baseMipLevel = 0;
@@ -439,34 +1508,26 @@ namespace frm
             }
         }
 
-        swapchainFenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-
-        if (VK_FAILED(vkCreateFence(m_device, &swapchainFenceInfo, nullptr, &m_swapbufferAvailable))) {
-            throw std::runtime_error("Cannot create swapchain fence");
+        if (!m_headless) {
+            createRenderCompleteSemaphores();
         }
 
         // ------------------------- OPTIONAL SECTION -------------------------
         // Pre-determine swapchain layout to VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
         // This prevents validation error when flipping swapchain images when not in use.
+        // The transition is not waited on, later submissions on the graphics queue are ordered after it.
 
-        cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-        cmdPoolInfo.queueFamilyIndex = m_deviceQueueIndex;
-
-        if (VK_FAILED(vkCreateCommandPool(m_device, &cmdPoolInfo, nullptr, &cmdPool))) {
-            throw std::runtime_error("Cannot create command pool for swapchain initial layout transition");
+        if (m_swapchainInitPool == nullptr) {
+            createCommandPool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, &m_swapchainInitPool);
+            createCommandBuffer(m_swapchainInitPool, &m_swapchainInitCmd);
         }
-
-        cmdBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        cmdBufferInfo.commandPool = cmdPool;
-        cmdBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        cmdBufferInfo.commandBufferCount = 1;
-
-        if (VK_FAILED(vkAllocateCommandBuffers(m_device, &cmdBufferInfo, &cmdBuffer))) {
-            throw std::runtime_error("Cannot create command buffer for swapchain initial layout transition");
+        else {
+            wait(m_swapchainInitTicket); // long done by now, but the command buffer must not be pending
+            vkResetCommandPool(m_device, m_swapchainInitPool, 0);
         }
 
         cmdBufferBegin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        cmdBufferBegin.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+        cmdBufferBegin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
         for (auto swapbuffer : m_swapchainImages) {
             VkImageMemoryBarrier barrier = { };
@@ -475,8 +1536,8 @@ namespace frm
             barrier.dstAccessMask = 0;
             barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
             barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-            barrier.srcQueueFamilyIndex = m_deviceQueueIndex;
-            barrier.dstQueueFamilyIndex = m_deviceQueueIndex;
+            barrier.srcQueueFamilyIndex = getQueueIndex(QueueType::Graphics);
+            barrier.dstQueueFamilyIndex = getQueueIndex(QueueType::Graphics);
             barrier.image = swapbuffer;
             barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
             barrier.subresourceRange.baseMipLevel = 0;
@@ -484,53 +1545,552 @@ namespace frm
             barrier.subresourceRange.baseArrayLayer = 0;
             barrier.subresourceRange.layerCount = 1;
 
-            m_swapchainInitialLayoutBarriers.push_back(barrier);
+            initialLayoutBarriers.push_back(barrier);
         }
 
-        vkBeginCommandBuffer(cmdBuffer, &cmdBufferBegin);
-        vkCmdPipelineBarrier(cmdBuffer,
-            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        // The images are new, there is nothing to wait for. Everything that touches a swapbuffer later does so
+        // at the color attachment output stage (render passes, the acquire semaphore wait), so that's the only
+        // stage that has to wait for the transition.
+        vkBeginCommandBuffer(m_swapchainInitCmd, &cmdBufferBegin);
+        vkCmdPipelineBarrier(m_swapchainInitCmd,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
             0,
             0,
             nullptr,
             0,
             nullptr,
-            static_cast<uint32_t>(m_swapchainInitialLayoutBarriers.size()),
-            m_swapchainInitialLayoutBarriers.data());
-        vkEndCommandBuffer(cmdBuffer);
+            static_cast<uint32_t>(initialLayoutBarriers.size()),
+            initialLayoutBarriers.data());
+        vkEndCommandBuffer(m_swapchainInitCmd);
 
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
         submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &cmdBuffer;
+        submitInfo.pCommandBuffers = &m_swapchainInitCmd;
+
+        m_swapchainInitTicket = queueSubmitAsync(QueueType::Graphics, submitInfo);
+        m_swapchainGeneration++;
+
+        return true;
+    }
+
+    VkExtent2D VulkanContext::getSurfaceExtent(VkSurfaceCapabilitiesKHR& surfaceCaps) const
+    {
+        VkExtent2D extent;
+
+        // the surface follows the window, so its capabilities have to be queried again every time
+        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_physicalDevice, m_surface, &surfaceCaps);
 
-        if (VK_FAILED(vkQueueSubmit(m_deviceQueue, 1, &submitInfo, nullptr))) {
-            throw std::runtime_error("Cannot submit command buffer for swapchain initial layout transition");
+        if (surfaceCaps.currentExtent.width != UINT32_MAX) {
+            return surfaceCaps.currentExtent;
         }
 
-        vkDeviceWaitIdle(m_device);
+        // the surface size is defined by the swapchain, match the window drawable size
+        int w, h;
+
+        SDL_Vulkan_GetDrawableSize(m_window, &w, &h);
+
+        extent.width = std::max(surfaceCaps.minImageExtent.width, std::min(static_cast<uint32_t>(w), surfaceCaps.maxImageExtent.width));
+        extent.height = std::max(surfaceCaps.minImageExtent.height, std::min(static_cast<uint32_t>(h), surfaceCaps.maxImageExtent.height));
 
-        vkDestroyCommandPool(m_device, cmdPool, nullptr);
+        return extent;
     }
 
-    const char* VulkanContext::g_instanceLayers[] = {
-        "VK_LAYER_KHRONOS_validation" // IMPORTANT!!!!
-    };
+    bool VulkanContext::createSurfaceSwapchain()
+    {
+        VkSwapchainKHR oldSwapchain = m_swapchain;
+        uint32_t swapchainImageCount;
+        uint32_t presentModeCount;
+        std::vector<VkPresentModeKHR> presentModes;
+        VkExtent2D extent = getSurfaceExtent(m_surfaceCaps);
+        VkSwapchainCreateInfoKHR swapchainInfo{};
 
-    const char* VulkanContext::g_instanceExtensions[] = {
-        "VK_KHR_surface",
-#ifdef WIN32
-        "VK_KHR_win32_surface"
-#elif defined(__linux__)
-        "VK_KHR_xcb_surface"
-#endif
-    };
+        if (extent.width == 0 || extent.height == 0) {
+            return false; // minimized
+        }
+
+        m_swapchainExtent = extent;
+
+        // FIFO is the only present mode that is guaranteed to be supported
+        vkGetPhysicalDeviceSurfacePresentModesKHR(m_physicalDevice, m_surface, &presentModeCount, nullptr);
+        presentModes.resize(presentModeCount);
+        vkGetPhysicalDeviceSurfacePresentModesKHR(m_physicalDevice, m_surface, &presentModeCount, presentModes.data());
+
+        if (std::find(presentModes.begin(), presentModes.end(), m_requestedPresentMode) != presentModes.end()) {
+            m_presentMode = m_requestedPresentMode;
+        }
+        else {
+            m_presentMode = VK_PRESENT_MODE_FIFO_KHR;
+        }
+
+        // maxImageCount == 0 means there is no upper limit
+        swapchainImageCount = std::max(m_requestedSwapbufferCount, m_surfaceCaps.minImageCount);
+
+        if (m_surfaceCaps.maxImageCount != 0) {
+            swapchainImageCount = std::min(swapchainImageCount, m_surfaceCaps.maxImageCount);
+        }
+
+        // create swapchain
+        swapchainInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+        swapchainInfo.surface = m_surface;
+        swapchainInfo.minImageCount = swapchainImageCount;
+        swapchainInfo.imageFormat = getSwapchainFormat();
+        swapchainInfo.imageExtent = m_swapchainExtent;
+        swapchainInfo.imageArrayLayers = 1;
+        swapchainInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        swapchainInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        swapchainInfo.preTransform = m_surfaceCaps.currentTransform;
+        swapchainInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+        swapchainInfo.presentMode = m_presentMode;
+        swapchainInfo.clipped = VK_TRUE;
+        swapchainInfo.oldSwapchain = oldSwapchain; // lets the driver hand over resources of the old one
+
+        if (VK_FAILED(vkCreateSwapchainKHR(m_device, &swapchainInfo, nullptr, &m_swapchain))) {
+            throw std::runtime_error("Cannot create swapchain");
+        }
+
+        // the old swapchain is retired now, recreateSwapchain drained the presents that still used its images
+        if (oldSwapchain != nullptr) {
+            vkDestroySwapchainKHR(m_device, oldSwapchain, nullptr);
+        }
+
+        vkGetSwapchainImagesKHR(m_device, m_swapchain, &swapchainImageCount, nullptr);
+        m_swapchainImages.resize(swapchainImageCount);
+        vkGetSwapchainImagesKHR(m_device, m_swapchain, &swapchainImageCount, m_swapchainImages.data());
+
+        return true;
+    }
+
+    void VulkanContext::createVirtualSwapchain()
+    {
+        VkImageCreateInfo imageInfo{};
+        uint32_t imageCount = std::max(1u, m_requestedSwapbufferCount);
+
+        // Same format and layout as real swapbuffers. Transfer source so frames can be read back.
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = getSwapchainFormat();
+        imageInfo.extent.width = m_swapchainExtent.width;
+        imageInfo.extent.height = m_swapchainExtent.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        // the caller made sure the previous images are no longer in use
+        m_virtualSwapbuffers.clear();
+        m_virtualSwapbuffers.resize(imageCount);
+        m_swapchainImages.resize(imageCount);
+        m_virtualSwapbufferIndex = 0;
+
+        for (uint32_t i = 0; i < imageCount; i++) {
+            createImage(imageInfo, VMA_MEMORY_USAGE_GPU_ONLY, m_virtualSwapbuffers[i]);
+            m_swapchainImages[i] = m_virtualSwapbuffers[i]->get();
+        }
+    }
+
+    void VulkanContext::createRenderCompleteSemaphores()
+    {
+        VkSemaphoreCreateInfo semaphoreInfo{};
+
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        // the image count may have changed, recreateSwapchain made sure no present still waits on the old ones
+        destroyRenderCompleteSemaphores();
+        m_renderComplete.resize(m_swapchainImages.size(), VK_NULL_HANDLE);
+
+        for (auto& semaphore : m_renderComplete) {
+            if (VK_FAILED(vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &semaphore))) {
+                throw std::runtime_error("Cannot create render complete semaphores");
+            }
+        }
+    }
+
+    void VulkanContext::destroyRenderCompleteSemaphores()
+    {
+        for (auto semaphore : m_renderComplete) {
+            if (semaphore != VK_NULL_HANDLE) {
+                vkDestroySemaphore(m_device, semaphore, nullptr);
+            }
+        }
+
+        m_renderComplete.clear();
+    }
+
+    bool VulkanContext::recreateSwapchain()
+    {
+        // Frames in flight may still render to the old images through framebuffers the app is about
+        // to rebuild. Only those are drained, transfers and async compute keep running.
+        waitFramesInFlight();
+
+        // The frame fences only cover the graphics submits, not the presents queued after them, and those
+        // still read the old images and wait on the frame semaphores. Presents go through the graphics queue.
+        if (!m_headless) {
+            FRM_CPU_SCOPE("wait present");
+            std::lock_guard<std::mutex> lock(*m_queues[static_cast<size_t>(QueueType::Graphics)].submitMutex);
+            vkQueueWaitIdle(getQueue(QueueType::Graphics));
+        }
+
+        if (!createSwapchain()) {
+            return false;
+        }
+
+        m_swapchainDirty = false;
+
+        return true;
+    }
+
+    void VulkanContext::waitFramesInFlight()
+    {
+        for (auto& frame : m_frames) {
+            while (vkWaitForFences(m_device, 1, &frame.inFlightFence, VK_TRUE, UINT64_MAX) == VK_TIMEOUT);
+        }
+    }
+
+    void VulkanContext::createPipelineCache()
+    {
+        VkPipelineCacheCreateInfo cacheInfo{};
+        std::vector<uint8_t> cacheData;
+        char cacheName[96];
+        int len;
+
+        // one file per driver/device, the driver would reject a blob from another one anyway
+        len = std::snprintf(cacheName, sizeof(cacheName), "pipeline_cache_%08x_%08x_", m_pdProperties.vendorID, m_pdProperties.deviceID);
+
+        for (uint32_t i = 0; i < VK_UUID_SIZE; i++) {
+            len += std::snprintf(cacheName + len, sizeof(cacheName) - len, "%02x", m_pdProperties.pipelineCacheUUID[i]);
+        }
+
+        m_pipelineCachePath = std::string(cacheName) + ".bin";
+
+        if (Resource::loadBinary(m_pipelineCachePath, cacheData)) {
+            if (isPipelineCacheValid(cacheData)) {
+                cacheInfo.initialDataSize = cacheData.size();
+                cacheInfo.pInitialData = cacheData.data();
+                m_pipelineCacheLoaded = true;
+            }
+            else {
+                std::cout << "Ignoring stale pipeline cache " << m_pipelineCachePath << std::endl;
+            }
+        }
+
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+        if (VK_FAILED(vkCreatePipelineCache(m_device, &cacheInfo, nullptr, &m_pipelineCache))) {
+            throw std::runtime_error("Cannot create pipeline cache");
+        }
+    }
+
+    void VulkanContext::destroyPipelineCache()
+    {
+        size_t size = 0;
+        std::vector<uint8_t> cacheData;
+        std::string tmpPath = m_pipelineCachePath + ".tmp";
+
+        if (m_pipelineCache == nullptr) {
+            return;
+        }
+
+        std::cout << "Pipelines: " << m_pipelineCreateCount << " created in " << m_pipelineCreateTime * 1000.0 << " ms ("
+                  << (m_pipelineCacheLoaded ? "warm" : "cold") << " pipeline cache)" << std::endl;
+
+        vkGetPipelineCacheData(m_device, m_pipelineCache, &size, nullptr);
+        cacheData.resize(size);
+
+        if (size > 0 && vkGetPipelineCacheData(m_device, m_pipelineCache, &size, cacheData.data()) == VK_SUCCESS) {
+            std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+            std::error_code ec;
+
+            file.write(reinterpret_cast<const char*>(cacheData.data()), static_cast<std::streamsize>(size));
+            file.close();
+
+            // write to a temporary file first, so a crash or a concurrent run never leaves a truncated cache behind
+            if (file.good()) {
+                std::filesystem::rename(tmpPath, m_pipelineCachePath, ec);
+            }
+
+            if (!file.good() || ec) {
+                std::filesystem::remove(tmpPath, ec);
+            }
+        }
+
+        vkDestroyPipelineCache(m_device, m_pipelineCache, nullptr);
+        m_pipelineCache = nullptr;
+    }
+
+    void VulkanContext::addPipelineCreateTime(std::chrono::high_resolution_clock::time_point start)
+    {
+        double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(m_pipelineStatsMutex);
+        m_pipelineCreateTime += elapsed;
+        m_pipelineCreateCount++;
+    }
+
+    void VulkanContext::addPipelineBatchTime(std::chrono::high_resolution_clock::time_point start)
+    {
+        double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(m_pipelineStatsMutex);
+        m_pipelineBatchTime += elapsed;
+    }
+
+    double VulkanContext::getPipelineCreateTime() const
+    {
+        std::lock_guard<std::mutex> lock(m_pipelineStatsMutex);
+        return m_pipelineCreateTime;
+    }
+
+    double VulkanContext::getPipelineBatchTime() const
+    {
+        std::lock_guard<std::mutex> lock(m_pipelineStatsMutex);
+        return m_pipelineBatchTime;
+    }
+
+    uint32_t VulkanContext::getPipelineCreateCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_pipelineStatsMutex);
+        return m_pipelineCreateCount;
+    }
+
+    void VulkanContext::addSubmitTime(std::chrono::high_resolution_clock::time_point start, uint64_t submitCount) const
+    {
+        double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(m_submitStatsMutex);
+        m_submitTime += elapsed;
+        m_submitCount += submitCount;
+    }
+
+    double VulkanContext::getSubmitTime() const
+    {
+        std::lock_guard<std::mutex> lock(m_submitStatsMutex);
+        return m_submitTime;
+    }
+
+    uint64_t VulkanContext::getSubmitCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_submitStatsMutex);
+        return m_submitCount;
+    }
+
+    VkDeviceSize VulkanContext::getAllocatedBytes() const
+    {
+        VmaBudget budgets[VK_MAX_MEMORY_HEAPS]{};
+        VkDeviceSize allocatedBytes = 0;
+
+        // cheap, unlike vmaCalculateStats
+        vmaGetBudget(m_allocator, budgets);
+
+        for (uint32_t i = 0; i < m_pdMemoryProperties.memoryHeapCount; i++) {
+            allocatedBytes += budgets[i].allocationBytes;
+        }
+
+        return allocatedBytes;
+    }
+
+    void VulkanContext::getHeapBudgets(std::vector<HeapBudget>& budgets) const
+    {
+        VmaBudget vmaBudgets[VK_MAX_MEMORY_HEAPS]{};
+
+        vmaGetBudget(m_allocator, vmaBudgets);
+        budgets.resize(m_pdMemoryProperties.memoryHeapCount);
+
+        for (uint32_t i = 0; i < m_pdMemoryProperties.memoryHeapCount; i++) {
+            budgets[i].size = m_pdMemoryProperties.memoryHeaps[i].size;
+            budgets[i].flags = m_pdMemoryProperties.memoryHeaps[i].flags;
+            budgets[i].blockBytes = vmaBudgets[i].blockBytes;
+            budgets[i].allocationBytes = vmaBudgets[i].allocationBytes;
+            budgets[i].usage = vmaBudgets[i].usage;
+            budgets[i].budget = vmaBudgets[i].budget;
+        }
+    }
+
+    VkDeviceSize VulkanContext::getCategoryBytes(MemoryCategory category) const
+    {
+        return m_memoryTotals->bytes[static_cast<size_t>(category)];
+    }
+
+    bool VulkanContext::writeMemoryStats(const std::string& path) const
+    {
+        std::ofstream file(path, std::ios::out | std::ios::trunc);
+        char* stats = nullptr;
+
+        if (!file.is_open()) {
+            return false;
+        }
+
+        // walks every block, not something to do every frame
+        vmaBuildStatsString(m_allocator, &stats, VK_TRUE);
+        file << stats;
+        vmaFreeStatsString(m_allocator, stats);
+
+        return file.good();
+    }
+
+    const char* VulkanContext::getMemoryCategoryName(MemoryCategory category)
+    {
+        switch (category) {
+            case MemoryCategory::Vertex:
+                return "vertex";
+            case MemoryCategory::Index:
+                return "index";
+            case MemoryCategory::Texture:
+                return "texture";
+            case MemoryCategory::Staging:
+                return "staging";
+            default:
+                return "other";
+        }
+    }
+
+    bool VulkanContext::isPipelineCacheValid(const std::vector<uint8_t>& cacheData) const
+    {
+        // VkPipelineCacheHeaderVersionOne, see the "Pipeline Cache" chapter of the spec
+        uint32_t headerSize;
+        uint32_t headerVersion;
+        uint32_t vendorID;
+        uint32_t deviceID;
+
+        if (cacheData.size() < 16 + VK_UUID_SIZE) {
+            return false;
+        }
+
+        std::memcpy(&headerSize, cacheData.data(), 4);
+        std::memcpy(&headerVersion, cacheData.data() + 4, 4);
+        std::memcpy(&vendorID, cacheData.data() + 8, 4);
+        std::memcpy(&deviceID, cacheData.data() + 12, 4);
+
+        return headerSize >= 16 + VK_UUID_SIZE &&
+               headerSize <= cacheData.size() &&
+               headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+               vendorID == m_pdProperties.vendorID &&
+               deviceID == m_pdProperties.deviceID &&
+               std::memcmp(cacheData.data() + 16, m_pdProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    void VulkanContext::createQueueTimelines()
+    {
+        VkSemaphoreTypeCreateInfo timelineTypeInfo{};
+        VkSemaphoreCreateInfo timelineInfo{};
+
+        timelineTypeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        timelineTypeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        timelineTypeInfo.initialValue = 0;
+
+        timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        timelineInfo.pNext = &timelineTypeInfo;
+
+        // every queue gets its own timeline, even when it shares the VkQueue with another queue type
+        for (auto& queueCtx : m_queues) {
+            if (VK_FAILED(vkCreateSemaphore(m_device, &timelineInfo, nullptr, &queueCtx.timeline))) {
+                throw std::runtime_error("Cannot create queue timeline semaphore");
+            }
+
+            queueCtx.timelineValue = 0;
+        }
+    }
+
+    void VulkanContext::addToBindlessTable(const VkImageCreateInfo& createInfo, const ImageResourceRef& image)
+    {
+        VkImageViewCreateInfo viewInfo{};
+        VkImageView view;
+        std::weak_ptr<BindlessTable> table = m_bindless;
+        uint32_t index;
+
+        // a view of the whole image, shaders pick mips and layers themselves
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image->get();
+        viewInfo.format = createInfo.format;
+        viewInfo.components = { VK_COMPONENT_SWIZZLE_IDENTITY };
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.levelCount = createInfo.mipLevels;
+        viewInfo.subresourceRange.layerCount = createInfo.arrayLayers;
+
+        switch (createInfo.imageType) {
+            case VK_IMAGE_TYPE_1D:
+                viewInfo.viewType = createInfo.arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_1D_ARRAY : VK_IMAGE_VIEW_TYPE_1D;
+                break;
+            case VK_IMAGE_TYPE_3D:
+                viewInfo.viewType = VK_IMAGE_VIEW_TYPE_3D;
+                break;
+            default:
+                if ((createInfo.flags & VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT) && createInfo.arrayLayers == 6) {
+                    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
+                }
+                else {
+                    viewInfo.viewType = createInfo.arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+                }
+                break;
+        }
+
+        createImageView(viewInfo, &view);
+
+        index = m_bindless->addImage(view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, true);
+
+        // the table may already be gone when the app keeps images around past the context
+        image->setBindlessIndex(index, [table, index]() {
+            if (auto bindless = table.lock()) {
+                bindless->removeImage(index);
+            }
+        });
+    }
+
+    void VulkanContext::createFrameContexts(uint32_t count)
+    {
+        VkFenceCreateInfo fenceInfo{};
+        VkSemaphoreCreateInfo semaphoreInfo{};
+
+        // Fences start signaled so the first pass through the ring does not block
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        m_frames.resize(count);
+        m_currentFrame = 0;
+
+        // command buffers are handed out per frame by prepareNextSwapbuffer
+        m_cmdAllocator = std::make_unique<CommandAllocator>(*this, count);
+
+        for (auto& frame : m_frames) {
+            if (VK_FAILED(vkCreateFence(m_device, &fenceInfo, nullptr, &frame.inFlightFence))) {
+                throw std::runtime_error("Cannot create frame fence");
+            }
+
+            if (VK_FAILED(vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &frame.swapbufferAcquired))) {
+                throw std::runtime_error("Cannot create frame semaphores");
+            }
+
+            frame.swapbufferIndex = 0;
+
+            frame.descriptors = std::make_unique<DescriptorAllocator>(*this);
+        }
+    }
+
+    void VulkanContext::destroyFrameContexts()
+    {
+        for (auto& frame : m_frames) {
+            frame.descriptors.reset();
+
+            if (frame.swapbufferAcquired != nullptr) {
+                vkDestroySemaphore(m_device, frame.swapbufferAcquired, nullptr);
+            }
+
+            if (frame.inFlightFence != nullptr) {
+                vkDestroyFence(m_device, frame.inFlightFence, nullptr);
+            }
+        }
+
+        m_frames.clear();
+        m_cmdAllocator.reset();
+    }
 
-    const char* VulkanContext::g_deviceLayers[] = {
-        "VK_LAYER_KHRONOS_validation"
-    };
+    const uint32_t VulkanContext::g_maxFramesInFlight;
 
-    const char* VulkanContext::g_deviceExtensions[] = {
-        "VK_KHR_swapchain"
-    };
+    const char* VulkanContext::g_validationLayer = "VK_LAYER_KHRONOS_validation";
 }
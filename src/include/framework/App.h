@@ -2,22 +2,33 @@
 
 #include <SDL2/SDL.h>
 #include <framework/VulkanContext.h>
+#include <framework/Trace.h>
+#include <framework/FrameStats.h>
 
 #undef main
 
 namespace frm
 {
+    class CpuProfiler;
+
     class App
     {
     public:
         App();
         ~App();
 
-        void init(int w, int h);
+        void init(int w, int h, uint32_t framesInFlight = 2);
+        void parseArgs(int argc, char** argv); // --headless, --validation (or VKL_HEADLESS=1, VKL_VALIDATION=1) and --frames <n>, call before init
+                                               // --trace <path> writes a Chrome trace of the run, needs VKL_PROFILING
+                                               // --stats prints frame time percentiles at exit, --stats-out <path> streams every frame (.csv or .json)
+                                               // --warmup <n> frames are left out of the stats and run before the --frames limit
+                                               // --bench-out <path> writes init time, frame stats, submits and memory as JSON at exit
+                                               // --memory-stats <path> writes the allocator's JSON dump at exit, --stats prints heap budgets too
         void dispatch();
 
         virtual void onInit(VulkanContext& context);
         virtual void onDestroy(VulkanContext& context);
+        virtual void onSwapchainRecreated(VulkanContext& context); // rebuild anything that refers to the swapbuffers
         virtual void onUpdate(VulkanContext& context, double dt) = 0;
         virtual void onRender(VulkanContext& context, double dt) = 0;
         virtual void onGuiRender();
@@ -25,24 +36,50 @@ namespace frm
         VulkanContext& getContext() { return m_vkCtx; };
         const uint32_t getCurrentSwapbuffer() const { return m_currentSwapbuffer; }
         void getClientSizeRect(VkRect2D& rect);
+        bool isHeadless() const { return m_headless; }
+        const FrameStats& getFrameStats() const { return m_frameStats; }
+        bool hasArg(const char* name) const; // app specific command line options
+        const char* getArgValue(const char* name) const; // the argument following name, nullptr if there is none
 
         template<class T>
-        static int run(int w, int h);
+        static int run(int w, int h, int argc = 0, char** argv = nullptr);
 
     private:
         VulkanContext m_vkCtx;
         SDL_Window* m_window;
         uint32_t m_currentSwapbuffer;
+        uint32_t m_swapchainGeneration;
+        bool m_headless;
+        uint64_t m_frameLimit; // 0 runs until the window is closed
+        uint64_t m_warmupFrames;
+        double m_initTime; // ms
+        std::string m_appName;
+        std::string m_benchPath;
+        std::string m_memoryStatsPath;
+        std::vector<std::string> m_args;
+        std::string m_tracePath;
+        TraceWriter m_trace;
+        std::unique_ptr<CpuProfiler> m_cpuProfiler; // only while tracing
+        FrameStats m_frameStats;
+        bool m_printStats;
+
+        static bool getEnvFlag(const char* name);
 
         void prepareNextFrame();
         void swap();
+        void writeTrace();
+        void writeBenchResults(uint64_t submitCount);
+        void writeMemoryStats();
+        void printMemoryStats();
+        void printPipelineStats();
     };
 
     template<class T>
-    int App::run(int w, int h)
+    int App::run(int w, int h, int argc, char** argv)
     {
         T theApp;
 
+        theApp.parseArgs(argc, argv);
         theApp.init(w, h);
         theApp.dispatch();
 
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <framework/VulkanContext.h>
+#include <mutex>
+#include <unordered_map>
+
+namespace frm
+{
+    // One global descriptor set holding every sampled image and sampler the app uses:
+    //   binding 0: texture2D textures[] (sampled images)
+    //   binding 1: sampler samplers[]
+    // Both arrays are partially bound and update-after-bind, so entries can be added while frames using
+    // the set are still in flight. Shaders get the indices through push constants, the set is bound once.
+    class BindlessTable
+    {
+    public:
+        static const uint32_t g_invalidIndex = ~0u;
+        static const uint32_t g_maxImages = 16384;
+        static const uint32_t g_maxSamplers = 256;
+
+        BindlessTable(VulkanContext& context);
+        ~BindlessTable();
+
+        // The view must stay alive until removeImage, unless the table owns it
+        uint32_t addImage(VkImageView imageView, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, bool ownsView = false);
+
+        // The slot (and the view if owned) is recycled once everything submitted before the call has completed, on every queue
+        void removeImage(uint32_t index);
+
+        // Samplers are never removed, adding the same sampler twice returns the same index
+        uint32_t addSampler(VkSampler sampler);
+
+        // Called by the context at the start of every frame, recycles the slots the GPU is done with
+        void nextFrame();
+
+        void bind(VkCommandBuffer cmdBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, uint32_t set = 0) const;
+
+        VkDescriptorSetLayout getSetLayout() const { return m_setLayout; }
+        VkDescriptorSet getSet() const { return m_set; }
+        uint32_t getImageCapacity() const { return m_imageCapacity; }
+        uint32_t getSamplerCapacity() const { return m_samplerCapacity; }
+
+    private:
+        struct ImageSlot
+        {
+            VkImageView view;
+            bool ownsView;
+        };
+
+        struct RetiredSlot
+        {
+            uint32_t index;
+            SubmitTicket lastSubmits[static_cast<size_t>(QueueType::Count)]; // at the time of the removal
+        };
+
+        VulkanContext& m_context;
+        VkDescriptorSetLayout m_setLayout;
+        VkDescriptorPool m_pool;
+        VkDescriptorSet m_set;
+        uint32_t m_imageCapacity;
+        uint32_t m_samplerCapacity;
+        std::vector<ImageSlot> m_images;
+        std::vector<uint32_t> m_freeImages;
+        std::vector<RetiredSlot> m_retiredImages; // in removal order
+        std::unordered_map<VkSampler, uint32_t> m_samplers;
+        mutable std::mutex m_mutex;
+    };
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <framework/Common.h>
+
+namespace frm
+{
+    // Optional device features negotiated at device creation. A feature is only true when the
+    // implementation supports it and it has actually been enabled on the device.
+    struct DeviceFeatures
+    {
+        bool timelineSemaphore;
+        bool synchronization2;
+        bool dynamicRendering;
+        bool memoryBudget;
+        bool descriptorIndexing; // partially bound, update-after-bind sampled image arrays (bindless)
+        bool extendedDynamicState;  // cull mode, front face, topology, depth/stencil test state
+        bool extendedDynamicState2; // rasterizer discard, depth bias and primitive restart enables
+        bool extendedDynamicState3; // polygon mode, color blend enable and color write mask
+        bool hostQueryReset; // vkResetQueryPool, queries can be reset without a command buffer
+    };
+
+    // Entry points of the optional features, loaded with vkGetDeviceProcAddr. nullptr when the feature is off.
+    struct DeviceFunctions
+    {
+        PFN_vkCmdPipelineBarrier2KHR cmdPipelineBarrier2;
+        PFN_vkCmdBeginRenderingKHR cmdBeginRendering;
+        PFN_vkCmdEndRenderingKHR cmdEndRendering;
+        PFN_vkCmdSetCullModeEXT cmdSetCullMode;
+        PFN_vkCmdSetFrontFaceEXT cmdSetFrontFace;
+        PFN_vkCmdSetPrimitiveTopologyEXT cmdSetPrimitiveTopology;
+        PFN_vkCmdSetDepthTestEnableEXT cmdSetDepthTestEnable;
+        PFN_vkCmdSetDepthWriteEnableEXT cmdSetDepthWriteEnable;
+        PFN_vkCmdSetDepthCompareOpEXT cmdSetDepthCompareOp;
+        PFN_vkCmdSetStencilTestEnableEXT cmdSetStencilTestEnable;
+        PFN_vkCmdSetRasterizerDiscardEnableEXT cmdSetRasterizerDiscardEnable;
+        PFN_vkCmdSetDepthBiasEnableEXT cmdSetDepthBiasEnable;
+        PFN_vkCmdSetPrimitiveRestartEnableEXT cmdSetPrimitiveRestartEnable;
+        PFN_vkCmdSetPolygonModeEXT cmdSetPolygonMode;
+        PFN_vkCmdSetColorBlendEnableEXT cmdSetColorBlendEnable;
+        PFN_vkCmdSetColorWriteMaskEXT cmdSetColorWriteMask;
+    };
+
+    // Keeps track of the layers and extensions the Vulkan implementation offers and the ones we enabled.
+    // Required requests throw when the implementation doesn't have them, optional ones are just skipped.
+    class Capabilities
+    {
+    public:
+        void queryInstance();
+        void queryDevice(VkPhysicalDevice physicalDevice);
+
+        bool requestLayer(const char* name, bool required = false);
+        bool requestInstanceExtension(const char* name, bool required = false);
+        bool requestDeviceExtension(const char* name, bool required = false);
+
+        bool isLayerAvailable(const char* name) const { return contains(m_availableLayers, name); }
+        bool isInstanceExtensionAvailable(const char* name) const { return contains(m_availableInstanceExtensions, name); }
+        bool isDeviceExtensionAvailable(const char* name) const { return contains(m_availableDeviceExtensions, name); }
+
+        bool isLayerEnabled(const char* name) const { return contains(m_enabledLayers, name); }
+        bool isInstanceExtensionEnabled(const char* name) const { return contains(m_enabledInstanceExtensions, name); }
+        bool isDeviceExtensionEnabled(const char* name) const { return contains(m_enabledDeviceExtensions, name); }
+
+        // Name lists for VkInstanceCreateInfo / VkDeviceCreateInfo, valid as long as this object is not modified
+        void getEnabledLayers(std::vector<const char*>& names) const { getNames(m_enabledLayers, names); }
+        void getEnabledInstanceExtensions(std::vector<const char*>& names) const { getNames(m_enabledInstanceExtensions, names); }
+        void getEnabledDeviceExtensions(std::vector<const char*>& names) const { getNames(m_enabledDeviceExtensions, names); }
+
+    private:
+        std::vector<std::string> m_availableLayers;
+        std::vector<std::string> m_availableInstanceExtensions;
+        std::vector<std::string> m_availableDeviceExtensions;
+        std::vector<std::string> m_enabledLayers;
+        std::vector<std::string> m_enabledInstanceExtensions;
+        std::vector<std::string> m_enabledDeviceExtensions;
+
+        static bool request(const std::vector<std::string>& available,
+                            std::vector<std::string>& enabled,
+                            const char* name,
+                            bool required,
+                            const char* kind);
+        static bool contains(const std::vector<std::string>& list, const char* name);
+        static void getNames(const std::vector<std::string>& list, std::vector<const char*>& names);
+    };
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <framework/VulkanContext.h>
+#include <mutex>
+#include <unordered_map>
+
+namespace frm
+{
+    // Transient command buffers for the frame being recorded. Every thread that allocates gets its own
+    // VkCommandPool per frame in flight, so threads never share a pool and can record in parallel.
+    // Buffers are handed out by bumping an index into the ones allocated in earlier frames, and the
+    // whole pool is reset at once when the frame slot comes around again; buffers are never reset one by one.
+    class CommandAllocator
+    {
+    public:
+        CommandAllocator(VulkanContext& context, uint32_t framesInFlight, QueueType queue = QueueType::Graphics);
+        ~CommandAllocator();
+
+        // The buffer is valid until the current frame slot is reused, it must not be kept across frames
+        VkCommandBuffer allocate(VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+        // Resets every thread's pool of this frame slot, the GPU must be done with it (its fence has signaled)
+        // and no thread may be recording at the same time
+        void beginFrame(uint32_t frameIndex);
+
+        uint32_t getThreadCount() const;
+
+    private:
+        struct FramePool
+        {
+            VkCommandPool pool;
+            std::vector<VkCommandBuffer> buffers[2]; // primary, secondary
+            uint32_t used[2];
+        };
+
+        struct ThreadPools
+        {
+            std::vector<FramePool> frames;
+        };
+
+        VulkanContext& m_context;
+        QueueType m_queue;
+        uint32_t m_framesInFlight;
+        uint32_t m_frameIndex;
+        std::unordered_map<std::thread::id, std::unique_ptr<ThreadPools>> m_threads;
+        mutable std::mutex m_mutex;
+
+        ThreadPools& getThreadPools();
+    };
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <framework/VulkanContext.h>
+
+namespace frm
+{
+    // Wraps a command buffer for recording draws with dynamic pipeline state. The setters record the core
+    // and extended dynamic state commands, so a single pipeline can be drawn with different cull modes,
+    // topologies, depth state and so on instead of one pipeline per combination. Setting state the device
+    // doesn't support throws, check getFeatures().extendedDynamicState* first.
+    class CommandList
+    {
+    public:
+        CommandList(const VulkanContext& context, VkCommandBuffer cmdBuffer);
+
+        VkCommandBuffer get() const { return m_cmdBuffer; }
+
+        // Records a default for every state in VulkanContext::getDynamicStates, after binding such a pipeline
+        void resetDynamicState(const VkRect2D& renderArea, uint32_t colorAttachmentCount = 1);
+
+        void setViewport(const VkViewport& viewport);
+        void setViewport(const VkRect2D& rect); // full depth range
+        void setScissor(const VkRect2D& scissor);
+
+        // VK_EXT_extended_dynamic_state
+        void setCullMode(VkCullModeFlags cullMode);
+        void setFrontFace(VkFrontFace frontFace);
+        void setPrimitiveTopology(VkPrimitiveTopology topology);
+        void setDepthTestEnable(bool enable);
+        void setDepthWriteEnable(bool enable);
+        void setDepthCompareOp(VkCompareOp compareOp);
+        void setStencilTestEnable(bool enable);
+
+        // VK_EXT_extended_dynamic_state2
+        void setRasterizerDiscardEnable(bool enable);
+        void setDepthBiasEnable(bool enable);
+        void setPrimitiveRestartEnable(bool enable);
+
+        // VK_EXT_extended_dynamic_state3
+        void setPolygonMode(VkPolygonMode polygonMode);
+        void setColorBlendEnable(uint32_t attachment, bool enable);
+        void setColorWriteMask(uint32_t attachment, VkColorComponentFlags writeMask);
+
+    private:
+        const VulkanContext& m_context;
+        VkCommandBuffer m_cmdBuffer;
+
+        template<class Fn>
+        static Fn require(Fn fn, const char* name);
+    };
+}
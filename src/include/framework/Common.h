@@ -1,14 +1,22 @@
 #pragma once
 
 #include <iostream>
+#include <algorithm>
 #include <fstream>
 #include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <cctype>
 #include <vector>
+#include <memory>
 #include <cassert>
 #include <exception>
 #include <stdexcept>
 #include <chrono>
 #include <thread>
+#include <filesystem>
 
 #include "vk_mem_alloc.h"
 
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <framework/Trace.h>
+#include <atomic>
+#include <condition_variable>
+
+namespace frm
+{
+    // Records CPU scopes without locks. Every thread writes begin/end records into its own ring buffer
+    // (single producer, single consumer), a collector thread drains the rings and turns matching pairs
+    // into trace events, on the same clock and in the same TraceWriter as the GPU profiler.
+    // One profiler is active at a time, scopes outside of its lifetime cost a single atomic load.
+    // Threads that record scopes must be done with them before the profiler is destroyed.
+    class CpuProfiler
+    {
+    public:
+        CpuProfiler(TraceWriter& trace, uint32_t recordsPerThread = 16384); // becomes the active profiler
+        ~CpuProfiler(); // stops the collector and drains what's left
+
+        CpuProfiler(const CpuProfiler&) = delete;
+        CpuProfiler& operator=(const CpuProfiler&) = delete;
+
+        uint32_t getDroppedCount() const; // scopes lost because a ring was full
+
+        // used by CpuScope, false when no profiler is active
+        static bool begin(const char* name);
+        static void end();
+
+        static void setThreadName(const char* name); // for the calling thread, may be called before any profiler exists
+
+    private:
+        struct Record
+        {
+            const char* name; // nullptr for an end record
+            int64_t time;
+        };
+
+        struct ThreadBuffer
+        {
+            std::vector<Record> records; // power of two
+            std::atomic<uint64_t> head;  // written by the thread
+            std::atomic<uint64_t> tail;  // written by the collector
+            std::atomic<uint32_t> droppedCount;
+            uint32_t tid;
+
+            // thread side
+            uint32_t openCount;  // begins recorded and not ended yet, their ends always have room
+            uint32_t depth;      // all open scopes, recorded or not
+            uint32_t skipDepth;  // scopes at or below this depth were dropped, ~0u when none
+
+            // collector side
+            std::vector<Record> openScopes;
+        };
+
+        TraceWriter& m_trace;
+        uint32_t m_ringSize;
+        uint32_t m_generation;
+        std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+        mutable std::mutex m_buffersMutex; // only taken by the collector and when a thread records its first scope
+        std::thread m_collector;
+        std::mutex m_stopMutex;
+        std::condition_variable m_stopCondition;
+        bool m_stop;
+
+        static std::atomic<CpuProfiler*> g_active;
+        static std::atomic<uint32_t> g_generation;
+
+        static ThreadBuffer* getThreadBuffer(CpuProfiler* profiler);
+        static void push(ThreadBuffer& buffer, const Record& record);
+
+        void collectorLoop();
+        void collect();
+    };
+
+    // Measures the CPU time of the enclosing block
+    class CpuScope
+    {
+    public:
+        CpuScope(const char* name) : m_recorded(CpuProfiler::begin(name)) {}
+
+        ~CpuScope()
+        {
+            if (m_recorded) {
+                CpuProfiler::end();
+            }
+        }
+
+        CpuScope(const CpuScope&) = delete;
+        CpuScope& operator=(const CpuScope&) = delete;
+
+    private:
+        bool m_recorded;
+    };
+}
+
+#ifdef VKL_PROFILING
+#define FRM_CPU_SCOPE(name) frm::CpuScope FRM_CONCAT(cpuScope, __LINE__)(name)
+#define FRM_CPU_THREAD_NAME(name) frm::CpuProfiler::setThreadName(name)
+#else
+#define FRM_CPU_SCOPE(name)
+#define FRM_CPU_THREAD_NAME(name)
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <framework/VulkanContext.h>
+
+namespace frm
+{
+    // Allocates descriptor sets of any layout from a growing list of pools. When a pool runs out of memory
+    // the allocation moves on to the next free pool or a new one, so an allocation is normally just a
+    // vkAllocateDescriptorSets on the current pool. reset() recycles every pool at once, which is how
+    // per-frame transient sets are released. Not thread safe, use one allocator per thread.
+    class DescriptorAllocator
+    {
+    public:
+        // Descriptors of one type to reserve per set, pools are sized as ratio * setsPerPool
+        struct PoolRatio
+        {
+            VkDescriptorType type;
+            float ratio;
+        };
+
+        DescriptorAllocator(VulkanContext& context, uint32_t setsPerPool = 256);
+        DescriptorAllocator(VulkanContext& context, uint32_t setsPerPool, const std::vector<PoolRatio>& ratios);
+        ~DescriptorAllocator();
+
+        VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+
+        // Frees every set allocated so far, the GPU must be done with them
+        void reset();
+
+        size_t getPoolCount() const { return m_usedPools.size() + m_freePools.size(); }
+
+    private:
+        VulkanContext& m_context;
+        uint32_t m_setsPerPool;
+        std::vector<PoolRatio> m_ratios;
+        VkDescriptorPool m_currentPool;
+        std::vector<VkDescriptorPool> m_usedPools;
+        std::vector<VkDescriptorPool> m_freePools;
+
+        VkDescriptorPool grabPool();
+    };
+}
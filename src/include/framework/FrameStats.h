@@ -0,0 +1,71 @@
+#pragma once
+
+#include <framework/Common.h>
+
+namespace frm
+{
+    enum class FrameMetric
+    {
+        CpuFrame,    // one iteration of the App::dispatch loop
+        PrepareWait, // blocked in prepareNextSwapbuffer: frame fence and acquire
+        SubmitWait,  // in queue submissions and waits on their tickets
+        Present,
+        Count
+    };
+
+    // Timings of one frame in milliseconds, indexed by FrameMetric
+    struct FrameSample
+    {
+        double times[static_cast<size_t>(FrameMetric::Count)];
+    };
+
+    struct FrameSummary
+    {
+        double mean;
+        double p50;
+        double p95;
+        double p99;
+        double max;
+    };
+
+    // Rolling percentiles over the last frames and a log-scale histogram of the whole run. Regressions
+    // tend to show up as p99 spikes that an average frame rate hides. Optionally streams every frame to
+    // a CSV or JSON file as it comes in.
+    class FrameStats
+    {
+    public:
+        static const uint32_t g_bucketsPerOctave = 4;
+        static const uint32_t g_bucketCount = 64; // 1/16 ms up to 4 s, the last bucket also takes anything slower
+        static const uint32_t g_maxWindowSize = 1 << 20;
+
+        FrameStats(uint32_t windowSize = 1000);
+        ~FrameStats();
+
+        void addFrame(const FrameSample& sample);
+        void reset(); // drops the window and the histograms, e.g. after warm-up frames. The stream keeps going.
+        void setWindowSize(uint32_t windowSize); // also resets, capped at g_maxWindowSize
+
+        FrameSummary getSummary(FrameMetric metric) const; // over the rolling window
+        const std::vector<uint64_t>& getHistogram(FrameMetric metric) const { return m_histograms[static_cast<size_t>(metric)]; }
+        uint64_t getFrameCount() const { return m_frameCount; } // since the last reset
+        uint32_t getWindowFrameCount() const { return static_cast<uint32_t>(m_window.size()); } // frames the summaries cover
+        void print(std::ostream& stream) const; // summary of every metric and the CPU frame histogram
+
+        bool openStream(const std::string& path); // a .json path writes an array of frames, anything else CSV
+        void closeStream();
+
+        static double getBucketLimit(uint32_t bucket); // upper edge in milliseconds
+        static const char* getMetricName(FrameMetric metric);
+
+    private:
+        std::vector<FrameSample> m_window; // ring, m_frameCount % size is the oldest once it's full
+        uint32_t m_windowSize;
+        uint64_t m_frameCount;
+        std::vector<uint64_t> m_histograms[static_cast<size_t>(FrameMetric::Count)];
+        std::ofstream m_stream;
+        uint64_t m_streamedCount; // numbers the streamed frames, reset doesn't touch it
+        bool m_streamJson;
+
+        static uint32_t getBucket(double time);
+    };
+}
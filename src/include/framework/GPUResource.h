@@ -2,9 +2,28 @@
 
 #include <vulkan/vulkan.h>
 #include <framework/Common.h>
+#include <functional>
+#include <atomic>
 
 namespace frm
 {
+    // What the memory of a resource is used for, see VulkanContext::getCategoryBytes
+    enum class MemoryCategory
+    {
+        Vertex,
+        Index,
+        Texture,
+        Staging, // host visible copy sources
+        Other,   // render targets, uniform and storage buffers
+        Count
+    };
+
+    // Live allocation bytes per category, shared by the context and the resources it created
+    struct MemoryTotals
+    {
+        std::atomic<VkDeviceSize> bytes[static_cast<size_t>(MemoryCategory::Count)]{};
+    };
+
     template<class T>
     class GPUResource
     {
@@ -12,20 +31,31 @@ namespace frm
         GPUResource(VmaAllocator allocator, T resource, VmaAllocation allocation) :
             m_allocator(allocator),
             m_resource(resource),
-            m_allocation(allocation)
+            m_allocation(allocation),
+            m_bindlessIndex(~0u),
+            m_category(MemoryCategory::Other),
+            m_size(0)
         {
         }
 
         ~GPUResource()
         {
+            if (m_release) {
+                m_release();
+            }
+
+            if (m_memoryTotals) {
+                m_memoryTotals->bytes[static_cast<size_t>(m_category)] -= m_size;
+            }
+
             destroy();
         }
 
         void map(void** data);
         void unmap();
 
-        template<class T>
-        void map(T** data)
+        template<class U>
+        void map(U** data)
         {
             map(reinterpret_cast<void**>(data));
         }
@@ -35,16 +65,82 @@ namespace frm
             return m_resource;
         }
 
+        // Index in the context's bindless table, ~0u if the resource isn't in there
+        uint32_t getBindlessIndex() const
+        {
+            return m_bindlessIndex;
+        }
+
+        // release is called right before the resource is destroyed, to take it out of the table again
+        void setBindlessIndex(uint32_t index, std::function<void()> release)
+        {
+            m_bindlessIndex = index;
+            m_release = std::move(release);
+        }
+
+        MemoryCategory getMemoryCategory() const
+        {
+            return m_category;
+        }
+
+        VkDeviceSize getAllocationSize() const
+        {
+            return m_size;
+        }
+
+        // size is counted in totals until the resource is destroyed
+        void setMemoryCategory(std::shared_ptr<MemoryTotals> totals, MemoryCategory category, VkDeviceSize size)
+        {
+            m_memoryTotals = std::move(totals);
+            m_category = category;
+            m_size = size;
+            m_memoryTotals->bytes[static_cast<size_t>(m_category)] += m_size;
+        }
+
     private:
         VmaAllocator m_allocator;
         T m_resource;
         VmaAllocation m_allocation;
-        
+        uint32_t m_bindlessIndex;
+        std::function<void()> m_release;
+        std::shared_ptr<MemoryTotals> m_memoryTotals;
+        MemoryCategory m_category;
+        VkDeviceSize m_size;
+
         void destroy();
     };
 
+    // Layout of one mip level of one array layer, and the stages/accesses (sync2 masks) that used it
+    // since its last barrier. Kept up to date by ImageTracker, RenderGraph and the Uploader.
+    struct ImageSubresourceState
+    {
+        VkImageLayout layout;
+        VkPipelineStageFlags2KHR stage;
+        VkAccessFlags2KHR access;
+    };
+
+    class ImageResource : public GPUResource<VkImage>
+    {
+    public:
+        ImageResource(VmaAllocator allocator, VkImage image, VmaAllocation allocation, const VkImageCreateInfo& createInfo);
+
+        VkFormat getFormat() const { return m_format; }
+        VkImageAspectFlags getAspect() const { return m_aspect; }
+        uint32_t getMipLevels() const { return m_mipLevels; }
+        uint32_t getArrayLayers() const { return m_arrayLayers; }
+
+        ImageSubresourceState& getState(uint32_t mipLevel, uint32_t arrayLayer) { return m_states[arrayLayer * m_mipLevels + mipLevel]; }
+        void setState(const ImageSubresourceState& state); // every subresource, e.g. after a whole-image upload
+
+    private:
+        VkFormat m_format;
+        VkImageAspectFlags m_aspect;
+        uint32_t m_mipLevels;
+        uint32_t m_arrayLayers;
+        std::vector<ImageSubresourceState> m_states; // layer-major
+    };
+
     using BufferResource = GPUResource<VkBuffer>;
-    using ImageResource = GPUResource<VkImage>;
     using BufferResourceRef = std::shared_ptr<BufferResource>;
     using ImageResourceRef = std::shared_ptr<ImageResource>;
 }
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <framework/VulkanContext.h>
+#include <framework/Trace.h>
+
+namespace frm
+{
+    // Measures GPU time of command buffer regions with timestamp queries. Every frame in flight has its own
+    // query pool, the results of a slot are read back when the context reuses it, i.e. after its fence has
+    // signaled, so reading never stalls. Scopes may be recorded on any of the context's queues from any
+    // thread, work on other queues must be finished by the time the frame slot comes around again.
+    // Created by the context when GPU profiling is enabled, see VulkanContext::enableGpuProfiling.
+    class GpuProfiler
+    {
+    public:
+        GpuProfiler(VulkanContext& context, uint32_t maxScopesPerFrame = 512);
+        ~GpuProfiler();
+
+        // returns the query of the scope, ~0u when the frame is out of queries or the queue has no timestamps
+        uint32_t beginScope(VkCommandBuffer cmdBuffer, const char* name, QueueType queue);
+        void endScope(VkCommandBuffer cmdBuffer, uint32_t query);
+
+        void beginFrame(uint32_t frameIndex); // reads back what the slot recorded last time, then resets it
+        void resolveAll(); // every slot, after waitIdle
+
+        void exportTrace(TraceWriter& trace); // moves the resolved events to the trace
+        uint32_t getDroppedCount() const { return m_droppedCount; }
+
+    private:
+        struct Scope
+        {
+            const char* name;
+            QueueType queue;
+            uint32_t query; // begin, end is the next one
+        };
+
+        struct FrameQueries
+        {
+            VkQueryPool pool;
+            std::vector<Scope> scopes;
+            uint32_t queryCount;
+        };
+
+        VulkanContext& m_context;
+        uint32_t m_maxQueries;
+        std::vector<FrameQueries> m_frames;
+        uint32_t m_currentFrame;
+        uint64_t m_timestampMask[static_cast<size_t>(QueueType::Count)]; // 0 when the queue can't write timestamps
+        double m_timestampPeriod; // nanoseconds per tick
+        int64_t m_gpuToCpu; // added to converted GPU times to put them on the steady clock
+        std::vector<TraceEvent> m_events;
+        std::mutex m_mutex;
+        uint32_t m_droppedCount;
+
+        void calibrate();
+        void resolve(FrameQueries& frame);
+    };
+
+    // Measures the commands recorded while it's alive
+    class GpuScope
+    {
+    public:
+        GpuScope(GpuProfiler* profiler, VkCommandBuffer cmdBuffer, const char* name, QueueType queue = QueueType::Graphics) :
+            m_profiler(profiler),
+            m_cmdBuffer(cmdBuffer),
+            m_query(profiler != nullptr ? profiler->beginScope(cmdBuffer, name, queue) : ~0u)
+        {
+        }
+
+        ~GpuScope()
+        {
+            if (m_query != ~0u) {
+                m_profiler->endScope(m_cmdBuffer, m_query);
+            }
+        }
+
+        GpuScope(const GpuScope&) = delete;
+        GpuScope& operator=(const GpuScope&) = delete;
+
+    private:
+        GpuProfiler* m_profiler;
+        VkCommandBuffer m_cmdBuffer;
+        uint32_t m_query;
+    };
+}
+
+#ifdef VKL_PROFILING
+#define FRM_GPU_SCOPE(context, cmdBuffer, name) frm::GpuScope FRM_CONCAT(gpuScope, __LINE__)((context).getGpuProfiler(), cmdBuffer, name)
+#define FRM_GPU_SCOPE_QUEUE(context, cmdBuffer, name, queue) frm::GpuScope FRM_CONCAT(gpuScope, __LINE__)((context).getGpuProfiler(), cmdBuffer, name, queue)
+#else
+#define FRM_GPU_SCOPE(context, cmdBuffer, name)
+#define FRM_GPU_SCOPE_QUEUE(context, cmdBuffer, name, queue)
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <framework/VulkanContext.h>
+
+namespace frm
+{
+    // Queues image layout transitions against the state every ImageResource keeps per mip level and array
+    // layer, and records all of them with one vkCmdPipelineBarrier2 when flushed. Subresources that are
+    // already in the requested layout and were only read are left alone, neighbouring subresources with
+    // the same old state share one barrier. Without synchronization2 the same batch goes through
+    // vkCmdPipelineBarrier.
+    class ImageTracker
+    {
+    public:
+        ImageTracker(VulkanContext& context);
+
+        // Every mip level and array layer when range is nullptr. Stages and accesses are sync2 masks. A subresource
+        // can only be transitioned once between flushes, pass every stage that is going to use it in one call.
+        // Throws when the range is outside of the image, without touching any state.
+        void transition(const ImageResourceRef& image,
+                        VkImageLayout newLayout,
+                        VkPipelineStageFlags2KHR dstStage,
+                        VkAccessFlags2KHR dstAccess,
+                        const VkImageSubresourceRange* range = nullptr);
+
+        void flush(VkCommandBuffer cmdBuffer); // records the queued barriers, nothing when there are none
+
+        uint32_t getPendingCount() const { return static_cast<uint32_t>(m_barriers.size()); }
+        uint32_t getSkippedCount() const { return m_skippedCount; } // redundant transitions, since construction
+
+        // sync2 <-> sync1 helpers, also used by RenderGraph which still records vkCmdPipelineBarrier
+        static bool hasWrite(VkAccessFlags2KHR access);
+        static VkPipelineStageFlags toLegacyStages(VkPipelineStageFlags2KHR stages, VkPipelineStageFlags none);
+        static VkAccessFlags toLegacyAccess(VkAccessFlags2KHR access);
+
+    private:
+        // mips of one layer that share their old state
+        struct Run
+        {
+            ImageSubresourceState oldState;
+            uint32_t mipLevel;
+            uint32_t mipCount;
+            uint32_t arrayLayer;
+        };
+
+        VulkanContext& m_context;
+        std::vector<VkImageMemoryBarrier2KHR> m_barriers;
+        std::vector<ImageResourceRef> m_pendingImages; // alive at least until the barriers are recorded
+        uint32_t m_skippedCount;
+
+        void queueBarrier(ImageResource& image,
+                          const ImageSubresourceState& oldState,
+                          VkImageLayout newLayout,
+                          VkPipelineStageFlags2KHR dstStage,
+                          VkAccessFlags2KHR dstAccess,
+                          uint32_t mipLevel,
+                          uint32_t mipCount,
+                          uint32_t arrayLayer);
+        bool isPending(const ImageResource& image, uint32_t mipLevel, uint32_t mipCount, uint32_t arrayLayer) const;
+        void recordLegacy(VkCommandBuffer cmdBuffer);
+    };
+}
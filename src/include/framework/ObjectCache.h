@@ -0,0 +1,45 @@
+#pragma once
+
+#include <framework/VulkanContext.h>
+#include <mutex>
+#include <unordered_map>
+
+namespace frm
+{
+    // Hash-consed immutable Vulkan objects. Each get function looks the create info up by its contents
+    // (the SPIR-V bytes for shader modules) and only creates a new object the first time it sees it.
+    // The cache owns every returned handle and destroys them with the context, don't destroy them yourself.
+    class ObjectCache
+    {
+    public:
+        ObjectCache(VulkanContext& context);
+        ~ObjectCache();
+
+        // pNext chains aren't supported, the create infos must not have one
+        VkShaderModule getShaderModule(const std::vector<uint8_t>& shaderBlob);
+        VkSampler getSampler(const VkSamplerCreateInfo& createInfo);
+        VkDescriptorSetLayout getDescriptorLayout(const VkDescriptorSetLayoutCreateInfo& createInfo);
+        VkPipelineLayout getPipelineLayout(const VkPipelineLayoutCreateInfo& createInfo);
+        VkRenderPass getRenderPass(const VkRenderPassCreateInfo& createInfo);
+
+        uint64_t getHitCount() const;
+        uint64_t getMissCount() const;
+
+    private:
+        // Serialized create info, the member by member contents with every array it points to inlined
+        using Key = std::string;
+
+        VulkanContext& m_context;
+        std::unordered_map<Key, VkShaderModule> m_shaderModules;
+        std::unordered_map<Key, VkSampler> m_samplers;
+        std::unordered_map<Key, VkDescriptorSetLayout> m_setLayouts;
+        std::unordered_map<Key, VkPipelineLayout> m_pipelineLayouts;
+        std::unordered_map<Key, VkRenderPass> m_renderPasses;
+        uint64_t m_hits;
+        uint64_t m_misses;
+        mutable std::mutex m_mutex;
+
+        template<class T, class CreateFn>
+        T getOrCreate(std::unordered_map<Key, T>& objects, Key&& key, CreateFn&& create);
+    };
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <framework/VulkanContext.h>
+
+namespace frm
+{
+    // Records the draws of a render pass on several threads. The items [0, itemCount) are split into one
+    // contiguous chunk per thread, every chunk is recorded into its own secondary command buffer (the last
+    // one on the calling thread, the others on the context's worker pool) and the primary buffer executes
+    // them in chunk order, so the result doesn't depend on which thread finished first.
+    class ParallelRecorder
+    {
+    public:
+        // Nothing is inherited by secondary buffers: bind the pipeline and set the dynamic state in every chunk
+        using RecordFn = std::function<void(VkCommandBuffer cmdBuffer, uint32_t first, uint32_t count)>;
+
+        ParallelRecorder(VulkanContext& context);
+
+        void setThreadCount(uint32_t threadCount); // 0 = calling thread + every worker, 1 = calling thread only
+        uint32_t getThreadCount() const { return m_threadCount; }
+
+        // Begins the render pass on cmdBuffer, records and executes the secondaries, and ends the render pass
+        void recordRenderPass(VkCommandBuffer cmdBuffer, const VkRenderPassBeginInfo& rpBegin, uint32_t itemCount, const RecordFn& record);
+
+    private:
+        VulkanContext& m_context;
+        uint32_t m_threadCount;
+        std::vector<std::future<VkCommandBuffer>> m_jobs;
+        std::vector<VkCommandBuffer> m_secondaries;
+
+        VkCommandBuffer recordChunk(const VkCommandBufferInheritanceInfo& inheritance, uint32_t first, uint32_t count, const RecordFn& record);
+    };
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <framework/VulkanContext.h>
+
+namespace frm
+{
+    // How a pass uses a resource. Together with read/write it gives the pipeline stages, access masks
+    // and image layout the graph synchronizes against.
+    enum class ResourceUsage
+    {
+        ColorAttachment,        // COLOR_ATTACHMENT_OPTIMAL, read = loadOp LOAD or blending
+        DepthStencilAttachment, // DEPTH_STENCIL_ATTACHMENT_OPTIMAL, or the read-only layout when only read
+        VertexShader,           // sampled/storage image or uniform/storage buffer
+        FragmentShader,
+        ComputeShader,
+        Transfer,               // copy/blit/clear source (read) or destination (write)
+        VertexBuffer,
+        IndexBuffer,
+        IndirectBuffer,
+        Present                 // only as final usage, see RenderGraph::setOutput
+    };
+
+    // A frame graph: passes declare which resources they read and write, the graph drops the passes nobody
+    // depends on and records the barriers and layout transitions between the remaining ones. Barriers are
+    // only as wide as the declared usages and everything a pass needs is batched in one vkCmdPipelineBarrier.
+    // Build it every frame: reset, import, add passes, mark outputs, execute.
+    class RenderGraph
+    {
+    public:
+        using ResourceHandle = uint32_t;
+
+        class PassBuilder
+        {
+        public:
+            void read(ResourceHandle resource, ResourceUsage usage);
+            void write(ResourceHandle resource, ResourceUsage usage); // also call read when the old contents are used
+            void sideEffects(); // never culled, e.g. the results are read back by the host
+
+        private:
+            friend class RenderGraph;
+
+            PassBuilder(RenderGraph& graph, size_t passIndex);
+
+            RenderGraph& m_graph;
+            size_t m_passIndex;
+        };
+
+        using SetupFn = std::function<void(PassBuilder& builder)>;
+        using ExecuteFn = std::function<void(VkCommandBuffer cmdBuffer)>;
+
+        RenderGraph();
+
+        void reset();
+
+        // initialStage is what earlier work used the resource for, e.g. the stage the acquire semaphore is waited on for swapbuffers
+        ResourceHandle importImage(const char* name,
+                                   VkImage image,
+                                   VkImageAspectFlags aspect,
+                                   VkImageLayout initialLayout,
+                                   VkPipelineStageFlags initialStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+        // Starts from the state the image tracks (see ImageResource::getState) and writes the final state back to it in execute,
+        // so the next graph, ImageTracker and the Uploader continue from there. All subresources must be in the same layout.
+        ResourceHandle importImage(const char* name, const ImageResourceRef& image);
+        ResourceHandle importBuffer(const char* name, VkBuffer buffer, VkPipelineStageFlags initialStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+
+        // Passes run in declaration order. That is always a valid order, a pass can only depend on passes added before it.
+        void addPass(const char* name, const SetupFn& setup, const ExecuteFn& execute);
+
+        // Outputs are what the graph is for, passes that don't contribute to one are culled. With a final usage
+        // the resource is transitioned for it after the last pass, e.g. ResourceUsage::Present for a swapbuffer.
+        void setOutput(ResourceHandle resource);
+        void setOutput(ResourceHandle resource, ResourceUsage finalUsage);
+
+        void compile();
+        void execute(VkCommandBuffer cmdBuffer); // compiles first if needed
+
+        // Layout after the last pass and the final usage, import the VkImage with it next frame
+        VkImageLayout getFinalLayout(ResourceHandle resource) const { return m_resources[resource].finalLayout; }
+
+        uint32_t getCulledPassCount() const { return m_culledPassCount; }
+        uint32_t getBarrierCount() const { return m_barrierCount; } // image + memory barriers of the last compile
+
+    private:
+        struct Access
+        {
+            VkPipelineStageFlags stage;
+            VkAccessFlags access;
+            VkImageLayout layout;
+            bool write;
+        };
+
+        struct ResourceState
+        {
+            VkImageLayout layout;
+            VkPipelineStageFlags writeStage; // last write (or layout transition)
+            VkAccessFlags writeAccess;
+            VkPipelineStageFlags readStages; // stages that have already waited for the last write
+            VkAccessFlags readAccess;
+        };
+
+        struct Resource
+        {
+            std::string name;
+            VkImage image;
+            VkBuffer buffer;
+            VkImageAspectFlags aspect;
+            ImageResourceRef trackedImage; // state written back after execute
+            ResourceState initialState;
+            ResourceState finalState;
+            VkImageLayout finalLayout;
+            bool output;
+            bool hasFinalUsage;
+            ResourceUsage finalUsage;
+        };
+
+        struct PassAccess
+        {
+            ResourceHandle resource;
+            ResourceUsage usage;
+            bool read;
+            bool write;
+        };
+
+        struct Pass
+        {
+            std::string name;
+            ExecuteFn execute;
+            std::vector<PassAccess> accesses;
+            bool sideEffects;
+            bool culled;
+        };
+
+        struct BarrierBatch
+        {
+            VkPipelineStageFlags srcStage;
+            VkPipelineStageFlags dstStage;
+            VkMemoryBarrier memoryBarrier;
+            std::vector<VkImageMemoryBarrier> imageBarriers;
+        };
+
+        std::vector<Resource> m_resources;
+        std::vector<Pass> m_passes;
+        std::vector<BarrierBatch> m_passBarriers; // one batch in front of every pass
+        BarrierBatch m_finalBarriers;
+        uint32_t m_culledPassCount;
+        uint32_t m_barrierCount;
+        bool m_compiled;
+
+        void addAccess(size_t passIndex, ResourceHandle resource, ResourceUsage usage, bool write);
+        void cull();
+        void transition(BarrierBatch& batch, ResourceHandle resource, ResourceState& state, const Access& access);
+        void record(VkCommandBuffer cmdBuffer, BarrierBatch& batch);
+
+        static Access getAccess(ResourceUsage usage, bool read, bool write, bool image);
+        static void clearBatch(BarrierBatch& batch);
+    };
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <framework/Common.h>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+
+namespace frm
+{
+    // Fixed set of worker threads consuming a FIFO of jobs. Jobs are plain callables, their result
+    // (or exception) is handed back through the future returned by submit().
+    class ThreadPool
+    {
+    public:
+        ThreadPool(uint32_t threadCount = 0); // 0 = one worker per hardware thread
+        ~ThreadPool(); // finishes the queued jobs before joining
+
+        template<class F>
+        auto submit(F&& job) -> std::future<decltype(job())>;
+
+        uint32_t getThreadCount() const { return static_cast<uint32_t>(m_threads.size()); }
+        bool isWorkerThread() const; // a job waiting on jobs queued behind it would deadlock the pool
+
+    private:
+        std::vector<std::thread> m_threads;
+        std::queue<std::function<void()>> m_jobs;
+        std::mutex m_mutex;
+        std::condition_variable m_jobAvailable;
+        bool m_stop;
+
+        void workerLoop();
+    };
+
+    template<class F>
+    auto ThreadPool::submit(F&& job) -> std::future<decltype(job())>
+    {
+        using Result = decltype(job());
+
+        // std::function needs a copyable callable, the packaged task itself is move-only
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+        std::future<Result> result = task->get_future();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.push([task]() { (*task)(); });
+        }
+
+        m_jobAvailable.notify_one();
+
+        return result;
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <framework/Common.h>
+#include <mutex>
+
+// Profiling scopes (FRM_CPU_SCOPE, FRM_GPU_SCOPE) are only compiled in with the VKL_PROFILING CMake option
+#define FRM_CONCAT_IMPL(a, b) a##b
+#define FRM_CONCAT(a, b) FRM_CONCAT_IMPL(a, b)
+
+namespace frm
+{
+    // One complete event of a Chrome trace (chrome://tracing, Perfetto). Times are nanoseconds on the
+    // steady clock, GPU timestamps are converted to it as well so both end up on one timeline.
+    struct TraceEvent
+    {
+        const char* name; // string literal, events are kept long after the scope is gone
+        const char* category;
+        uint32_t pid;     // g_cpuProcess or g_gpuProcess
+        uint32_t tid;     // thread or queue
+        int64_t start;
+        int64_t duration;
+    };
+
+    // Collects events from the profilers and writes them as trace_event JSON. Thread safe.
+    // Holds at most maxEvents, later events are dropped so a long run can't grow it without bound.
+    class TraceWriter
+    {
+    public:
+        static const uint32_t g_cpuProcess = 0;
+        static const uint32_t g_gpuProcess = 1;
+        static const size_t g_defaultMaxEvents = 1 << 20; // 40 MiB of events
+
+        TraceWriter(size_t maxEvents = g_defaultMaxEvents);
+
+        void add(const TraceEvent& event);
+        void add(const std::vector<TraceEvent>& events);
+        void setThreadName(uint32_t pid, uint32_t tid, const std::string& name);
+
+        size_t getEventCount() const;
+        uint64_t getDroppedCount() const; // events past maxEvents
+        bool write(const std::string& path) const;
+
+        static int64_t now(); // steady clock, nanoseconds
+        static void writeString(std::ostream& stream, const char* str); // as a JSON string literal, quotes included
+
+    private:
+        struct ThreadName
+        {
+            uint32_t pid;
+            uint32_t tid;
+            std::string name;
+        };
+
+        mutable std::mutex m_mutex;
+        size_t m_maxEvents;
+        std::vector<TraceEvent> m_events;
+        uint64_t m_droppedCount;
+        std::vector<ThreadName> m_threadNames;
+    };
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <framework/VulkanContext.h>
+
+namespace frm
+{
+    // Streams data into GPU-only buffers and images through staging buffers on the transfer queue.
+    // When the transfer queue belongs to its own family, ownership of the destination is released on
+    // the transfer queue and acquired on the graphics queue, so copies run alongside rendering.
+    class Uploader
+    {
+    public:
+        Uploader(VulkanContext& context);
+        ~Uploader();
+
+        // The data is copied to a staging buffer right away, the GPU copy happens on flush()
+        void uploadBuffer(const BufferResourceRef& dst,
+                          const void* data,
+                          VkDeviceSize size,
+                          VkDeviceSize dstOffset,
+                          VkPipelineStageFlags dstStage,
+                          VkAccessFlags dstAccess);
+
+        // Uploads tightly packed pixels to mip 0 / layer 0 of a color image and leaves the whole image in dstLayout
+        void uploadImage(const ImageResourceRef& dst,
+                         const void* data,
+                         VkDeviceSize size,
+                         uint32_t width,
+                         uint32_t height,
+                         VkImageLayout dstLayout,
+                         VkPipelineStageFlags dstStage,
+                         VkAccessFlags dstAccess);
+
+        // Submits every pending upload, the returned ticket is complete once the resources are usable
+        // from the graphics queue.
+        SubmitTicket flush();
+
+        // Releases staging memory and command buffers of finished batches
+        void collect();
+
+    private:
+        struct PendingBuffer
+        {
+            BufferResourceRef dst;
+            BufferResourceRef staging;
+            VkDeviceSize size;
+            VkDeviceSize dstOffset;
+            VkPipelineStageFlags dstStage;
+            VkAccessFlags dstAccess;
+        };
+
+        struct PendingImage
+        {
+            ImageResourceRef dst;
+            BufferResourceRef staging;
+            uint32_t width;
+            uint32_t height;
+            VkImageLayout dstLayout;
+            VkPipelineStageFlags dstStage;
+            VkAccessFlags dstAccess;
+        };
+
+        struct Batch
+        {
+            SubmitTicket ticket;
+            VkCommandBuffer transferCmd;
+            VkCommandBuffer acquireCmd;
+            std::vector<PendingBuffer> buffers;
+            std::vector<PendingImage> images;
+        };
+
+        VulkanContext& m_context;
+        VkCommandPool m_transferPool;
+        VkCommandPool m_acquirePool;
+        std::vector<PendingBuffer> m_pendingBuffers;
+        std::vector<PendingImage> m_pendingImages;
+        std::vector<Batch> m_batches;
+        SubmitTicket m_lastTicket;
+
+        void createStaging(const void* data, VkDeviceSize size, BufferResourceRef& staging);
+    };
+}
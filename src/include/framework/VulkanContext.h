@@ -6,33 +6,121 @@
 
 #include <framework/Common.h>
 #include <framework/GPUResource.h>
+#include <framework/Capabilities.h>
+#include <framework/ThreadPool.h>
+#include <atomic>
 
 #define VK_FAILED(x) ((x) != VK_SUCCESS)
 
 namespace frm
 {
+    class Uploader;
+    class ObjectCache;
+    class DescriptorAllocator;
+    class BindlessTable;
+    class CommandAllocator;
+    class GpuProfiler;
+
+    enum class QueueType
+    {
+        Graphics, // graphics + present
+        Transfer, // dedicated transfer (DMA) queue if the hardware has one, graphics queue otherwise
+        Compute,  // async compute queue if the hardware has one, graphics queue otherwise
+        Count
+    };
+
+    // Completion ticket returned by queueSubmitAsync. It's just a point on a timeline semaphore,
+    // so it's cheap to copy and can be checked or waited on at any time later.
+    struct SubmitTicket
+    {
+        VkSemaphore timeline = VK_NULL_HANDLE;
+        uint64_t value = 0;
+    };
+
+    // Makes a submission wait on the GPU for a ticket, possibly from another queue
+    struct SubmitWait
+    {
+        SubmitTicket ticket;
+        VkPipelineStageFlags stageMask;
+    };
+
+    // Memory of one heap as seen by the allocator. usage and budget come from VK_EXT_memory_budget when
+    // getFeatures().memoryBudget, otherwise they are estimates from the allocations made through the allocator.
+    struct HeapBudget
+    {
+        VkDeviceSize size;
+        VkMemoryHeapFlags flags;
+        VkDeviceSize blockBytes;      // VkDeviceMemory allocated by the allocator
+        VkDeviceSize allocationBytes; // resources placed in those blocks
+        VkDeviceSize usage;           // the whole process, including swapchain and driver internals
+        VkDeviceSize budget;          // how much the process can use before things start to go wrong
+    };
+
+    // An attachment of cmdBeginRendering, the image must already be in layout
+    struct RenderingAttachment
+    {
+        VkImageView view;
+        VkImageLayout layout;
+        VkAttachmentLoadOp loadOp;
+        VkAttachmentStoreOp storeOp;
+        VkClearValue clearValue;
+    };
+
     class VulkanContext
     {
     public:
         VulkanContext();
         ~VulkanContext();
 
-        void initDevice(SDL_Window* window);
-        void prepareNextSwapbuffer(uint32_t& nextSwapbufferIndex);
+        void enableValidation(bool enable) { m_validation = enable; } // before initDevice, off by default
+        void enableGpuProfiling(bool enable) { m_gpuProfiling = enable; } // before initDevice, off by default
+        void initDevice(SDL_Window* window, uint32_t framesInFlight = 2);
+
+        // No window and no surface. Frames are rendered into a ring of offscreen images (a "virtual swapchain")
+        // that stand in for the swapbuffers, so apps run unchanged on machines without a display.
+        void initHeadlessDevice(uint32_t width, uint32_t height, uint32_t framesInFlight = 2);
+        bool prepareNextSwapbuffer(uint32_t& nextSwapbufferIndex); // false when there is nothing to render to this frame
+        bool isMinimized() const; // the window has no area, prepareNextSwapbuffer returns false until it gets one again
         void present(uint32_t swapbufferIndex);
         void queueSubmit(const VkSubmitInfo& submitInfo);
+        SubmitTicket queueSubmitAsync(const VkSubmitInfo& submitInfo);
+        // Submissions may come from any thread, submits to the same VkQueue are serialized.
+        // submitInfo may wait on and signal timeline semaphores of its own, their values go in a VkTimelineSemaphoreSubmitInfo
+        // that comes first in pNext. It's merged with the ticket values, the same goes for submitFrame.
+        SubmitTicket queueSubmitAsync(QueueType queue, const VkSubmitInfo& submitInfo, const std::vector<SubmitWait>& waits = {});
+        bool isComplete(const SubmitTicket& ticket) const;
+        SubmitTicket getLastSubmit(QueueType queue) const; // complete once everything submitted to the queue so far is done, frames included
+        void wait(const SubmitTicket& ticket) const;
+        void submitFrame(const VkSubmitInfo& submitInfo, const std::vector<SubmitWait>& waits = {});
         void waitIdle();
 
+        // Swapchain settings, applied when the swapchain is (re)created on the next prepareNextSwapbuffer.
+        // Unsupported present modes fall back to FIFO, the image count is clamped to the surface limits.
+        void setPresentMode(VkPresentModeKHR presentMode);
+        void setSwapbufferCount(uint32_t count);
+        void invalidateSwapchain() { m_swapchainDirty = true; } // e.g. the window has been resized
+
         // Wrapper for vkCreateX functions
         void createBuffer(const VkBufferCreateInfo& createInfo, VmaMemoryUsage usage, BufferResourceRef& buffer);
-        void createImage(const VkImageCreateInfo& createInfo, VmaMemoryUsage usage, ImageResourceRef& image);
+        // With bindless, a sampled color image also gets a view in the bindless table when descriptor indexing is available,
+        // see ImageResource::getBindlessIndex. Depth/stencil images are never added.
+        void createImage(const VkImageCreateInfo& createInfo, VmaMemoryUsage usage, ImageResourceRef& image, bool bindless = false);
         void createImageView(const VkImageViewCreateInfo& createInfo, VkImageView* imageView);
-        void createCommandPool(uint32_t flags, VkCommandPool* cmdPool);
+        void createCommandPool(uint32_t flags, VkCommandPool* cmdPool, QueueType queue = QueueType::Graphics);
         void createCommandBuffer(VkCommandPool cmdPool, VkCommandBuffer* cmdBuffer);
         void createShaderModule(const std::vector<uint8_t>& shaderBlob, VkShaderModule* shaderModule);
         void createDescriptorLayout(const VkDescriptorSetLayoutCreateInfo& createInfo, VkDescriptorSetLayout* setLayout);
         void createPipelineLayout(const VkPipelineLayoutCreateInfo& createInfo, VkPipelineLayout* pipelineLayout);
         void createGraphicsPipeline(const VkGraphicsPipelineCreateInfo& createInfo, VkPipeline* pipeline);
+        void createComputePipeline(const VkComputePipelineCreateInfo& createInfo, VkPipeline* pipeline);
+        // Batch versions, the pipelines are compiled in parallel on the worker pool and all share the pipeline cache.
+        // They return once the whole batch is done. If any pipeline fails the ones already created are destroyed and the error is rethrown.
+        // Called from a worker of the pool, e.g. a loader job, the batch is compiled on that thread instead.
+        void createGraphicsPipelines(const std::vector<VkGraphicsPipelineCreateInfo>& createInfos, std::vector<VkPipeline>& pipelines);
+        void createComputePipelines(const std::vector<VkComputePipelineCreateInfo>& createInfos, std::vector<VkPipeline>& pipelines);
+        // Viewport, scissor and every extended dynamic state the device has, for VkPipelineDynamicStateCreateInfo.
+        // Pipelines created with them have to be drawn with all of them set, see CommandList::resetDynamicState.
+        void getDynamicStates(std::vector<VkDynamicState>& states) const;
         void createFramebuffer(const VkFramebufferCreateInfo& createInfo, VkFramebuffer* framebuffer);
         void createRenderPass(const VkRenderPassCreateInfo& createInfo, VkRenderPass* renderpass);
         void createDescriptorPool(const VkDescriptorPoolCreateInfo& createInfo, VkDescriptorPool* descriptorPool);
@@ -42,42 +130,168 @@ namespace frm
 
         void destroyBuffer(VkBuffer buffer);
 
+        // Records a dispatch that covers at least threadCount invocations, rounded up to whole workgroups
+        static void cmdDispatchThreads(VkCommandBuffer cmdBuffer, const glm::uvec3& threadCount, const glm::uvec3& localSize);
+
+        // Dynamic rendering (getFeatures().dynamicRendering): renders straight into image views, no render pass or framebuffer
+        // objects. Pipelines used inside are created with VkPipelineRenderingCreateInfoKHR in pNext and no render pass.
+        void cmdBeginRendering(VkCommandBuffer cmdBuffer,
+                               const VkRect2D& renderArea,
+                               const std::vector<RenderingAttachment>& colorAttachments,
+                               const RenderingAttachment* depthAttachment = nullptr,
+                               const RenderingAttachment* stencilAttachment = nullptr) const;
+        void cmdEndRendering(VkCommandBuffer cmdBuffer) const;
+
         VkDevice getDevice() const { return m_device; }
-        VkQueue getQueue() const { return m_deviceQueue; }
-        uint32_t getQueueIndex() const { return m_deviceQueueIndex; }
+        VkPhysicalDevice getPhysicalDevice() const { return m_physicalDevice; }
+        const VkPhysicalDeviceProperties& getDeviceProperties() const { return m_pdProperties; }
+        const VkPhysicalDeviceLimits& getDeviceLimits() const { return m_pdProperties.limits; }
+        const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const { return m_pdMemoryProperties; }
+        VkQueue getQueue(QueueType queue = QueueType::Graphics) const { return m_queues[static_cast<size_t>(queue)].queue; }
+        uint32_t getQueueIndex(QueueType queue = QueueType::Graphics) const { return m_queues[static_cast<size_t>(queue)].familyIndex; }
+        bool hasDedicatedQueue(QueueType queue) const { return getQueueIndex(queue) != getQueueIndex(QueueType::Graphics); }
+        void getQueueFamilies(std::vector<uint32_t>& families) const; // unique families, for VK_SHARING_MODE_CONCURRENT resources
+        Uploader& getUploader() { return *m_uploader; }
+        ObjectCache& getObjectCache() { return *m_objectCache; }
+        DescriptorAllocator& getDescriptorAllocator() { return *m_descriptorAllocator; } // sets that live as long as the app wants them
+        DescriptorAllocator& getFrameDescriptorAllocator() { return *m_frames[m_currentFrame].descriptors; } // sets for the current frame only
+        BindlessTable& getBindlessTable() { return *m_bindless; } // only when getFeatures().descriptorIndexing
+        bool isHeadless() const { return m_headless; }
+        bool isValidationEnabled() const { return m_caps.isLayerEnabled(g_validationLayer); }
+        const Capabilities& getCapabilities() const { return m_caps; }
+        const DeviceFeatures& getFeatures() const { return m_features; }
+        const DeviceFunctions& getFunctions() const { return m_functions; }
+        VkPipelineCache getPipelineCache() const { return m_pipelineCache; }
+        double getPipelineCreateTime() const; // seconds spent in pipeline creation so far, summed over all threads
+        double getPipelineBatchTime() const; // wall clock seconds spent in createGraphicsPipelines/createComputePipelines so far
+        uint32_t getPipelineCreateCount() const;
+        double getSubmitTime() const; // seconds spent in vkQueueSubmit and waiting on submit tickets so far, summed over all threads
+        uint64_t getSubmitCount() const; // vkQueueSubmit calls so far
+        VkDeviceSize getAllocatedBytes() const; // sum of all live allocations made through the allocator, every heap
+        void getHeapBudgets(std::vector<HeapBudget>& budgets) const; // one per memory heap
+        VkDeviceSize getCategoryBytes(MemoryCategory category) const; // live resources created by createBuffer/createImage
+        bool writeMemoryStats(const std::string& path) const; // the allocator's detailed JSON dump (vmaBuildStatsString)
+        static const char* getMemoryCategoryName(MemoryCategory category);
+        ThreadPool& getThreadPool() { return *m_workers; }
         size_t getSwapbufferCount() const { return m_swapchainImages.size(); }
         VkImage getSwapbuffer(size_t idx) const { return m_swapchainImages[idx]; }
         VkImageView getSwapbufferView(size_t idx) const { return m_swapchainImgViews[idx]; }
         VkFormat getSwapchainFormat() const { return VK_FORMAT_B8G8R8A8_SRGB; }
+        VkExtent2D getSwapchainExtent() const { return m_swapchainExtent; }
+        VkPresentModeKHR getPresentMode() const { return m_presentMode; }
+        uint32_t getSwapchainGeneration() const { return m_swapchainGeneration; } // bumped every time the swapchain is recreated
+        uint32_t getFramesInFlight() const { return static_cast<uint32_t>(m_frames.size()); }
+        uint32_t getFrameIndex() const { return m_currentFrame; }
+        VkCommandBuffer getFrameCommandBuffer() const { return m_frames[m_currentFrame].cmdBuffer; }
+        CommandAllocator& getCommandAllocator() { return *m_cmdAllocator; } // more buffers for this frame, from any thread
+        GpuProfiler* getGpuProfiler() { return m_gpuProfiler.get(); } // nullptr unless enableGpuProfiling
+
+        static const uint32_t g_maxFramesInFlight = 3;
 
     private:
+        // Per-frame synchronization objects. The CPU only waits on inFlightFence when it wraps around
+        // the ring, so it can record frame N+1 while the GPU is still executing frame N.
+        struct QueueContext
+        {
+            VkQueue queue;
+            uint32_t familyIndex;
+            VkSemaphore timeline; // signaled by every submission on this queue
+            std::atomic<uint64_t> timelineValue; // getLastSubmit may be called from any thread, e.g. when an image is destroyed
+            std::mutex* submitMutex; // the VkQueue must be externally synchronized, shared by the queue types that fall back to it
+        };
+
+        struct FrameContext
+        {
+            VkFence inFlightFence;
+            VkSemaphore swapbufferAcquired;
+            uint32_t swapbufferIndex; // acquired by prepareNextSwapbuffer
+            VkCommandBuffer cmdBuffer; // from m_cmdAllocator
+            std::unique_ptr<DescriptorAllocator> descriptors; // reset together with the frame's command pools
+            bool submitted;
+        };
+
         VkInstance m_instance;
         VkPhysicalDevice m_physicalDevice;
         VkPhysicalDeviceFeatures m_pdFeatures;
+        VkPhysicalDeviceProperties m_pdProperties;
+        VkPhysicalDeviceMemoryProperties m_pdMemoryProperties;
         VkSurfaceKHR m_surface;
         VkSurfaceCapabilitiesKHR m_surfaceCaps;
         VkDevice m_device;
         VmaAllocator m_allocator;
-        VkQueue m_deviceQueue;
-        uint32_t m_deviceQueueIndex;
+        QueueContext m_queues[static_cast<size_t>(QueueType::Count)];
+        std::mutex m_queueMutexes[static_cast<size_t>(QueueType::Count)]; // one per distinct VkQueue, see QueueContext::submitMutex
+        SDL_Window* m_window;
         VkSwapchainKHR m_swapchain;
+        VkExtent2D m_swapchainExtent;
+        VkPresentModeKHR m_presentMode;
+        VkPresentModeKHR m_requestedPresentMode;
+        uint32_t m_requestedSwapbufferCount;
+        uint32_t m_swapchainGeneration;
+        bool m_swapchainDirty;
         std::vector<VkImage> m_swapchainImages;
         std::vector<VkImageView> m_swapchainImgViews;
-        std::vector<VkImageMemoryBarrier> m_swapchainInitialLayoutBarriers;
-        VkFence m_swapbufferAvailable;
-        VkFence m_submitFence;
+        std::vector<VkSemaphore> m_renderComplete; // per swapbuffer, not per frame slot: the present waiting on it may outlive the slot's fence
+        VkCommandPool m_swapchainInitPool;
+        VkCommandBuffer m_swapchainInitCmd;
+        SubmitTicket m_swapchainInitTicket;
+        std::vector<ImageResourceRef> m_virtualSwapbuffers; // headless only, backs m_swapchainImages
+        uint32_t m_virtualSwapbufferIndex;
+        std::vector<FrameContext> m_frames;
+        std::unique_ptr<CommandAllocator> m_cmdAllocator;
+        uint32_t m_currentFrame;
+        std::unique_ptr<Uploader> m_uploader;
+        std::unique_ptr<ObjectCache> m_objectCache;
+        std::unique_ptr<DescriptorAllocator> m_descriptorAllocator;
+        std::shared_ptr<BindlessTable> m_bindless; // images hold weak references to it
+        std::unique_ptr<GpuProfiler> m_gpuProfiler;
+        std::shared_ptr<MemoryTotals> m_memoryTotals; // resources hold references to it
+        uint32_t m_allocatorFrame; // the budget is refreshed when it changes
+        VkPipelineCache m_pipelineCache;
+        std::string m_pipelineCachePath;
+        bool m_pipelineCacheLoaded;
+        double m_pipelineCreateTime;
+        double m_pipelineBatchTime;
+        uint32_t m_pipelineCreateCount;
+        mutable std::mutex m_pipelineStatsMutex; // pipelines may be created from worker threads
+        mutable double m_submitTime; // wait() is const
+        mutable uint64_t m_submitCount;
+        mutable std::mutex m_submitStatsMutex;
+        std::unique_ptr<ThreadPool> m_workers;
+        Capabilities m_caps;
+        DeviceFeatures m_features;
+        DeviceFunctions m_functions;
+        bool m_validation;
+        bool m_gpuProfiling;
+        bool m_headless;
         bool m_initialized;
 
-        // instance
-        static const char* g_instanceLayers[1];
-        static const char* g_instanceExtensions[2];
-
-        // device
-        static const char* g_deviceLayers[1];
-        static const char* g_deviceExtensions[1];
+        static const char* g_validationLayer;
 
         void init();
+        void selectPhysicalDevice(); // highest score wins, VKL_DEVICE overrides by index or name
         void shutdown();
-        void createSwapchain();
+        void createDevice(uint32_t framesInFlight);
+        void loadDeviceFunctions();
+        bool createSwapchain();
+        VkExtent2D getSurfaceExtent(VkSurfaceCapabilitiesKHR& surfaceCaps) const; // 0x0 while the window is minimized
+        bool createSurfaceSwapchain();
+        void createVirtualSwapchain();
+        void createRenderCompleteSemaphores();
+        void destroyRenderCompleteSemaphores();
+        bool recreateSwapchain();
+        void waitFramesInFlight();
+        void createQueueTimelines();
+        void createPipelineCache();
+        void destroyPipelineCache(); // writes the cache back to disk
+        bool isPipelineCacheValid(const std::vector<uint8_t>& cacheData) const;
+        void addPipelineCreateTime(std::chrono::high_resolution_clock::time_point start);
+        void addPipelineBatchTime(std::chrono::high_resolution_clock::time_point start);
+        void addSubmitTime(std::chrono::high_resolution_clock::time_point start, uint64_t submitCount) const;
+        void addToBindlessTable(const VkImageCreateInfo& createInfo, const ImageResourceRef& image);
+        void createFrameContexts(uint32_t count);
+        void destroyFrameContexts();
+
+        static int64_t scorePhysicalDevice(VkPhysicalDevice physicalDevice); // -1 if the device can't be used
     };
 }
@@ -0,0 +1,213 @@
+#include "Harness.h"
+#include <cmath>
+#include <iomanip>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define BENCH_HAS_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_RDTSC 1
+#endif
+
+namespace bench
+{
+    volatile char g_sink;
+
+    Harness::Harness(const Options& options) :
+        m_options(options)
+    {
+    }
+
+    void Harness::add(const std::string& name, const Body& body)
+    {
+        using Clock = std::chrono::steady_clock;
+        std::vector<double> times;
+        std::vector<double> cycles;
+        uint64_t iterations = 1;
+        Result result{};
+
+        if (!m_options.filter.empty() && name.find(m_options.filter) == std::string::npos) {
+            return;
+        }
+
+        // double the iteration count until one sample is long enough for the clock to resolve it well
+        while (true) {
+            auto start = Clock::now();
+            double elapsed;
+
+            body(iterations);
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+            if (elapsed >= m_options.minSampleTime || iterations >= (1ull << 40)) {
+                break;
+            }
+
+            iterations *= 2;
+        }
+
+        // caches, branch predictors, lazily allocated memory
+        for (uint32_t i = 0; i < m_options.warmup; i++) {
+            body(iterations);
+        }
+
+        for (uint32_t i = 0; i < m_options.repetitions; i++) {
+            auto start = Clock::now();
+            uint64_t startCycles = readCycles();
+
+            body(iterations);
+
+            uint64_t endCycles = readCycles();
+            double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+            times.push_back(elapsed / iterations);
+            cycles.push_back(static_cast<double>(endCycles - startCycles) / iterations);
+        }
+
+        std::sort(times.begin(), times.end());
+        std::sort(cycles.begin(), cycles.end());
+
+        auto percentile = [&times](double p) {
+            size_t rank = static_cast<size_t>(std::ceil(p * times.size()));
+            return times[std::min(times.size(), std::max<size_t>(rank, 1)) - 1];
+        };
+
+        result.name = name;
+        result.iterations = iterations;
+
+        for (auto time : times) {
+            result.mean += time / times.size();
+        }
+
+        result.min = times.front();
+        result.p50 = percentile(0.50);
+        result.p90 = percentile(0.90);
+        result.p99 = percentile(0.99);
+        result.max = times.back();
+        result.cycles = cycles[cycles.size() / 2];
+
+        std::cout << "  " << name << ": " << result.p50 << " ns" << std::endl;
+        m_results.push_back(result);
+    }
+
+    void Harness::skip(const std::string& name, const std::string& reason)
+    {
+        if (!m_options.filter.empty() && name.find(m_options.filter) == std::string::npos) {
+            return;
+        }
+
+        m_skipped.emplace_back(name, reason);
+    }
+
+    void Harness::print(std::ostream& stream) const
+    {
+        size_t nameWidth = 4;
+        std::ios::fmtflags flags = stream.flags();
+
+        for (auto& result : m_results) {
+            nameWidth = std::max(nameWidth, result.name.size());
+        }
+
+        for (auto& skipped : m_skipped) {
+            nameWidth = std::max(nameWidth, skipped.first.size());
+        }
+
+        stream << std::endl << m_options.repetitions << " repetitions, " << m_options.warmup << " warm-up, ns per iteration" << std::endl;
+        stream << std::left << std::setw(nameWidth) << "case" << std::right
+               << std::setw(12) << "iterations"
+               << std::setw(12) << "min"
+               << std::setw(12) << "p50"
+               << std::setw(12) << "p90"
+               << std::setw(12) << "p99"
+               << std::setw(12) << "max"
+               << std::setw(12) << "cycles" << std::endl;
+        stream << std::fixed << std::setprecision(1);
+
+        for (auto& result : m_results) {
+            stream << std::left << std::setw(nameWidth) << result.name << std::right
+                   << std::setw(12) << result.iterations
+                   << std::setw(12) << result.min
+                   << std::setw(12) << result.p50
+                   << std::setw(12) << result.p90
+                   << std::setw(12) << result.p99
+                   << std::setw(12) << result.max
+                   << std::setw(12) << result.cycles << std::endl;
+        }
+
+        for (auto& skipped : m_skipped) {
+            stream << std::left << std::setw(nameWidth) << skipped.first << "  skipped: " << skipped.second << std::endl;
+        }
+
+        stream.flags(flags);
+    }
+
+    bool Harness::writeJson(const std::string& path) const
+    {
+        std::ofstream file(path, std::ios::out | std::ios::trunc);
+
+        if (!file.is_open()) {
+            return false;
+        }
+
+        file << std::fixed << std::setprecision(3);
+        file << "{\n  \"repetitions\": " << m_options.repetitions << ",\n  \"warmup\": " << m_options.warmup << ",\n  \"cases\": [";
+
+        for (size_t i = 0; i < m_results.size(); i++) {
+            const Result& result = m_results[i];
+
+            file << (i == 0 ? "\n" : ",\n")
+                 << "    {\"name\": \"" << result.name << "\""
+                 << ", \"iterations\": " << result.iterations
+                 << ", \"mean_ns\": " << result.mean
+                 << ", \"min_ns\": " << result.min
+                 << ", \"p50_ns\": " << result.p50
+                 << ", \"p90_ns\": " << result.p90
+                 << ", \"p99_ns\": " << result.p99
+                 << ", \"max_ns\": " << result.max
+                 << ", \"cycles\": " << result.cycles << "}";
+        }
+
+        file << "\n  ]\n}\n";
+
+        return file.good();
+    }
+
+    bool Harness::parseArgs(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; i++) {
+            bool hasValue = i + 1 < argc;
+
+            if (std::strcmp(argv[i], "--filter") == 0 && hasValue) {
+                options.filter = argv[++i];
+            }
+            else if (std::strcmp(argv[i], "--reps") == 0 && hasValue) {
+                options.repetitions = std::max(1u, static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)));
+            }
+            else if (std::strcmp(argv[i], "--warmup") == 0 && hasValue) {
+                options.warmup = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            }
+            else if (std::strcmp(argv[i], "--min-time") == 0 && hasValue) {
+                options.minSampleTime = std::strtod(argv[++i], nullptr) / 1000.0;
+            }
+            else if (std::strcmp(argv[i], "--json") == 0 && hasValue) {
+                options.jsonPath = argv[++i];
+            }
+            else {
+                std::cout << "Usage: " << argv[0] << " [--filter <substring>] [--reps <n>] [--warmup <n>] [--min-time <ms>] [--json <path>]" << std::endl;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    uint64_t Harness::readCycles()
+    {
+        // reference cycles at the nominal frequency, not core clocks under turbo
+#ifdef BENCH_HAS_RDTSC
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+}
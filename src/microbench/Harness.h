@@ -0,0 +1,73 @@
+#pragma once
+
+#include <framework/Common.h>
+#include <functional>
+
+namespace bench
+{
+    // Runs body(iterations) and reports the time per iteration. The iteration count of a sample is
+    // calibrated so one sample takes at least the minimum sample time, then warm-up samples are run
+    // and thrown away before the measured repetitions.
+    using Body = std::function<void(uint64_t iterations)>;
+
+    struct Options
+    {
+        uint32_t warmup = 5;
+        uint32_t repetitions = 30;
+        double minSampleTime = 0.01; // seconds
+        std::string filter;          // only cases whose name contains it
+        std::string jsonPath;
+    };
+
+    struct Result
+    {
+        std::string name;
+        uint64_t iterations;   // per sample
+        double mean;           // ns per iteration
+        double min;
+        double p50;
+        double p90;
+        double p99;
+        double max;
+        double cycles;         // median TSC ticks per iteration, 0 where there is no cycle counter
+    };
+
+    class Harness
+    {
+    public:
+        Harness(const Options& options);
+
+        void add(const std::string& name, const Body& body);
+        void skip(const std::string& name, const std::string& reason); // keeps the case visible in the report
+
+        void print(std::ostream& stream) const;
+        bool writeJson(const std::string& path) const;
+
+        static bool parseArgs(int argc, char** argv, Options& options); // false on --help or bad arguments
+
+    private:
+        Options m_options;
+        std::vector<Result> m_results;
+        std::vector<std::pair<std::string, std::string>> m_skipped;
+
+        static uint64_t readCycles();
+    };
+
+    extern volatile char g_sink;
+
+    // Keeps the compiler from dropping a computation whose result is never used
+#if defined(_MSC_VER)
+    template<class T>
+    inline void doNotOptimize(const T& value)
+    {
+        g_sink = *reinterpret_cast<const volatile char*>(&value);
+        _ReadWriteBarrier();
+    }
+#else
+    template<class T>
+    inline void doNotOptimize(const T& value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+#endif
+}
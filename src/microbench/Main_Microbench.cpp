@@ -0,0 +1,200 @@
+#include <framework/VulkanContext.h>
+#include <framework/GPUResource.h>
+#include <framework/Resource.h>
+#include <framework/ShapeGen.h>
+#include "Harness.h"
+
+// CPU side paths of the framework, measured in isolation. Run from the build directory so the
+// resources copied next to the executable are found.
+
+static void addShapeGenCases(bench::Harness& harness)
+{
+    // the shapes are allocated with new[], freeing them is part of what a sample pays
+    harness.add("ShapeGen::makeTriangle", [](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; i++) {
+            frm::VertexPos* verts;
+
+            bench::doNotOptimize(frm::ShapeGen::makeTriangle(1.0f, verts));
+            bench::doNotOptimize(verts);
+            delete[] verts;
+        }
+    });
+
+    harness.add("ShapeGen::makeColorTriangle", [](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; i++) {
+            frm::VertexPosCol* verts;
+
+            bench::doNotOptimize(frm::ShapeGen::makeColorTriangle(1.0f, verts));
+            bench::doNotOptimize(verts);
+            delete[] verts;
+        }
+    });
+
+    harness.add("ShapeGen::makeColorPlane", [](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; i++) {
+            frm::VertexPosCol* verts;
+            uint32_t* indices;
+            size_t numIndices;
+
+            bench::doNotOptimize(frm::ShapeGen::makeColorPlane(0.5f, indices, verts, numIndices));
+            bench::doNotOptimize(verts);
+            bench::doNotOptimize(indices);
+            delete[] verts;
+            delete[] indices;
+        }
+    });
+
+    harness.add("ShapeGen::makePlane", [](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; i++) {
+            frm::VertexPosTex* verts;
+            uint32_t* indices;
+            size_t numIndices;
+
+            bench::doNotOptimize(frm::ShapeGen::makePlane(0.5f, indices, verts, numIndices));
+            bench::doNotOptimize(verts);
+            bench::doNotOptimize(indices);
+            delete[] verts;
+            delete[] indices;
+        }
+    });
+}
+
+static void addResourceCases(bench::Harness& harness)
+{
+    // file contents come from the OS cache after the first read, this measures our side of loading
+    const size_t sizes[] = { 4 * 1024, 1024 * 1024 };
+
+    for (auto size : sizes) {
+        std::string path = "microbench_" + std::to_string(size) + ".bin";
+        std::string name = "Resource::loadBinary " + std::to_string(size / 1024) + " KiB";
+        std::vector<uint8_t> contents(size, 0x5a);
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+        file.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+        file.close();
+
+        if (!file.good()) {
+            harness.skip(name, "cannot write " + path);
+            continue;
+        }
+
+        harness.add(name, [&path](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                std::vector<uint8_t> blob;
+
+                frm::Resource::loadBinary(path, blob);
+                bench::doNotOptimize(blob.data());
+            }
+        });
+
+        std::remove(path.c_str());
+    }
+
+    if (!std::filesystem::exists("shaderboi_fish.png")) {
+        harness.skip("Resource::loadImage", "shaderboi_fish.png not found in the working directory");
+        return;
+    }
+
+    harness.add("Resource::loadImage", [](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; i++) {
+            frm::ImageData imageData;
+
+            frm::Resource::loadImage("shaderboi_fish.png", imageData, 4);
+            bench::doNotOptimize(imageData.data.data());
+        }
+    });
+}
+
+static void addMappedCopyCases(bench::Harness& harness, frm::VulkanContext& context)
+{
+    const size_t sizes[] = { 64 * 1024, 4 * 1024 * 1024 };
+
+    for (auto size : sizes) {
+        std::string sizeName = std::to_string(size / 1024) + " KiB";
+        std::vector<uint8_t> src(size, 0x5a);
+        frm::BufferResourceRef buffer;
+        VkBufferCreateInfo bufferInfo{};
+        void* mapped;
+
+        // the same kind of buffer the samples stage vertex and index data in
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+        context.createBuffer(bufferInfo, VMA_MEMORY_USAGE_CPU_ONLY, buffer);
+
+        buffer->map(&mapped);
+
+        harness.add("memcpy to mapped BufferResource " + sizeName, [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                std::memcpy(mapped, src.data(), size);
+                bench::doNotOptimize(mapped);
+            }
+        });
+
+        buffer->unmap();
+
+        harness.add("map + memcpy + unmap BufferResource " + sizeName, [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                void* data;
+
+                buffer->map(&data);
+                std::memcpy(data, src.data(), size);
+                buffer->unmap();
+                bench::doNotOptimize(data);
+            }
+        });
+    }
+}
+
+static void addMatrixCases(bench::Harness& harness)
+{
+    // what 05-Transform and 06-Texture do in onUpdate every frame
+    harness.add("onUpdate world-view-projection", [](uint64_t iterations) {
+        float aspect = 640.f / 480.f;
+        float time = 0.f;
+
+        for (uint64_t i = 0; i < iterations; i++) {
+            glm::mat4 wvpMatrix = glm::perspectiveLH(glm::radians(45.0f), aspect, 0.01f, 500.f) *
+                glm::lookAtLH(glm::vec3(0.f, 0.f, -2.f), glm::vec3(0.f, 0.f, 1.f), glm::vec3(0.f, 1.f, 0.f)) *
+                glm::rotate(glm::identity<glm::mat4>(), time, glm::vec3(0.f, 1.f, 0.f));
+
+            bench::doNotOptimize(wvpMatrix);
+            time += 1.0f / 60.0f;
+        }
+    });
+}
+
+int main(int argc, char** argv)
+{
+    bench::Options options;
+    frm::VulkanContext context;
+
+    if (!bench::Harness::parseArgs(argc, argv, options)) {
+        return 1;
+    }
+
+    bench::Harness harness(options);
+
+    addShapeGenCases(harness);
+    addResourceCases(harness);
+    addMatrixCases(harness);
+
+    // the mapped copies need a device, any device, they don't touch the GPU
+    try {
+        context.initHeadlessDevice(64, 64, 1);
+        addMappedCopyCases(harness, context);
+    }
+    catch (const std::exception& e) {
+        harness.skip("memcpy to mapped BufferResource", e.what());
+    }
+
+    harness.print(std::cout);
+
+    if (!options.jsonPath.empty() && !harness.writeJson(options.jsonPath)) {
+        std::cout << "Cannot write " << options.jsonPath << std::endl;
+        return 1;
+    }
+
+    return 0;
+}